@@ -228,6 +228,23 @@ find_package(BZip2 REQUIRED)
 include_directories(${BZIP2_INCLUDE_DIR})
 add_definitions(${BZIP2_DEFINITIONS})
 
+# brotli and zstd, optional content encodings
+find_path(BROTLI_INCLUDE_DIR NAMES brotli/encode.h)
+find_library(BROTLI_ENC_LIB NAMES brotlienc)
+if (BROTLI_INCLUDE_DIR AND BROTLI_ENC_LIB)
+	include_directories(${BROTLI_INCLUDE_DIR})
+	add_definitions(-DHAVE_BROTLI=1)
+	message(STATUS "Found brotli: ${BROTLI_ENC_LIB}")
+endif()
+
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+find_library(ZSTD_LIB NAMES zstd)
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIB)
+	include_directories(${ZSTD_INCLUDE_DIR})
+	add_definitions(-DHAVE_ZSTD=1)
+	message(STATUS "Found zstd: ${ZSTD_LIB}")
+endif()
+
 # oniguruma
 find_package(ONIGURUMA REQUIRED)
 include_directories(${ONIGURUMA_INCLUDE_DIRS})
@@ -359,6 +376,14 @@ endif()
 	target_link_libraries(${target} ${ZLIB_LIBRARIES})
 	target_link_libraries(${target} ${BZIP2_LIBRARIES})
 
+	if (BROTLI_INCLUDE_DIR AND BROTLI_ENC_LIB)
+		target_link_libraries(${target} ${BROTLI_ENC_LIB})
+	endif()
+
+	if (ZSTD_INCLUDE_DIR AND ZSTD_LIB)
+		target_link_libraries(${target} ${ZSTD_LIB})
+	endif()
+
 	target_link_libraries(${target} ${LIBXML2_LIBRARIES})
 	target_link_libraries(${target} ${EXPAT_LIBRARY})
 	target_link_libraries(${target} ${ONIGURUMA_LIBRARIES})
@@ -1083,7 +1083,8 @@ typedef   OptWorker<Post>          PostOptWorker;
     if (threadCount <= 0) threadCount = 1; \
     this->m_data.m_dispatcher = \
       new JobQueueDispatcher<BlockScope *, worker >( \
-        threadCount, true, 0, false, this); \
+        threadCount, true, 0, false, this, false, \
+        Option::ParserJobStealing); \
   } while (0)
 
 #define IMPLEMENT_OPT_VISITOR_ENQUEUE(scope) \
@@ -207,6 +207,7 @@ bool Option::EnableXHP = true;
 bool Option::NativeXHP = true;
 int Option::ScannerType = Scanner::AllowShortTags;
 int Option::ParserThreadCount = 0;
+bool Option::ParserJobStealing = false;
 
 int Option::InvokeFewArgsCount = 6;
 bool Option::InvokeWithSpecificArgs = true;
@@ -412,6 +413,7 @@ void Option::Load(Hdf &config) {
   if (ParserThreadCount <= 0) {
     ParserThreadCount = Process::GetCPUCount();
   }
+  ParserJobStealing = config["ParserJobStealing"].getBool(false);
 
   RTTIOutputFile = config["RTTIOutputFile"].getString();
   EnableEval = (EvalLevel)config["EnableEval"].getByte(0);
@@ -331,6 +331,7 @@ public:
   static bool NativeXHP;
   static int ScannerType;
   static int ParserThreadCount;
+  static bool ParserJobStealing;
 
   /**
    * "Dynamic" means a function or a method can be invoked dynamically.
@@ -242,7 +242,8 @@ bool Package::parse(bool check) {
   if (threadCount <= 0) threadCount = 1;
 
   JobQueueDispatcher<ParserWorker::JobType, ParserWorker>
-    dispatcher(threadCount, true, 0, false, this);
+    dispatcher(threadCount, true, 0, false, this, false,
+               Option::ParserJobStealing);
 
   m_dispatcher = &dispatcher;
 
@@ -1180,6 +1180,28 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "mysql_fetch_all_columns",
+    'desc'   => "Fetches all remaining rows of a result at once, one array per column. This avoids creating an array per row when reading large result sets.",
+    'flags'  =>  HasDocComment,
+    'return' => array(
+      'type'   => Variant,
+      'desc'   => "Returns an array keyed by field name, each value being an array of that column's values in row order, or FALSE on failure. If two or more columns of the result have the same field names, the last column will take precedence.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "result",
+        'type'   => Variant,
+        'desc'   => "resource that is being evaluated. This result comes from a call to mysql_query().",
+      ),
+    ),
+    'taint_observer' => array(
+      'set_mask'   => "TAINT_BIT_ALL",
+      'clear_mask' => "TAINT_BIT_NONE",
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "mysql_fetch_lengths",
@@ -189,6 +189,54 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "pagelet_server_tasks_start",
+    'desc'   => "Processes a batch of pagelet server requests.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => VariantMap,
+      'desc'   => "Task handles with the same keys as the requests, null for requests that could not be started. They can be used with pagelet_server_tasks_wait() and all the functions taking one pagelet task.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "requests",
+        'type'   => VariantMap,
+        'desc'   => "Each request is either a URL, or an array with \"url\" and optional \"headers\", \"post_data\" and \"files\", same as pagelet_server_task_start()'s parameters.",
+      ),
+    ),
+  ));
+
+DefineFunction(
+  array(
+    'name'   => "pagelet_server_tasks_wait",
+    'desc'   => "Block until any of the pagelet tasks has data available, or until all of them are done. This sleeps until a task makes progress, instead of polling pagelet_server_task_status().",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => VariantVec,
+      'desc'   => "Keys of the tasks whose pagelet_server_task_status() is PAGELET_READY or PAGELET_DONE, in the order of tasks. This is empty if the timeout expired before any task had data.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "tasks",
+        'type'   => VariantMap,
+        'desc'   => "Pagelet task handles returned from pagelet_server_task_start() or pagelet_server_tasks_start().",
+      ),
+      array(
+        'name'   => "timeout_ms",
+        'type'   => Int64,
+        'value'  => "-1",
+        'desc'   => "How many milli-seconds to wait at most. 0 only checks the tasks, and a negative value waits for as long as it takes.",
+      ),
+      array(
+        'name'   => "wait_all",
+        'type'   => Boolean,
+        'value'  => "false",
+        'desc'   => "Wait for all tasks to be done, instead of any of them to have data.",
+      ),
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "pagelet_server_flush",
@@ -20,6 +20,7 @@
 #include <runtime/base/file/output_file.h>
 #include <runtime/base/file/zip_file.h>
 #include <runtime/base/file/mem_file.h>
+#include <runtime/base/file/input_file.h>
 #include <runtime/base/file/url_file.h>
 #include <runtime/base/complex_types.h>
 #include <runtime/base/util/string_buffer.h>
@@ -161,6 +162,17 @@ Object File::OpenImpl(CStrRef filename, CStrRef mode, CArrRef options) {
 
     if (!strcasecmp(filename.c_str(), "php://input")) {
       Transport *transport = g_context->getTransport();
+      if (s_file_data->m_inputStreamed) {
+        // what the first one read is gone, so this one couldn't start at
+        // the beginning of the body
+        raise_warning("php://input can only be opened once when the "
+                      "request body is streamed");
+        return Object();
+      }
+      if (transport && transport->hasMorePostData()) {
+        s_file_data->m_inputStreamed = true;
+        return Object(NEWOBJ(InputFile)(transport));
+      }
       if (transport) {
         int size = 0;
         const void *data = transport->getPostData(size);
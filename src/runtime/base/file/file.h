@@ -27,8 +27,8 @@ namespace HPHP {
 
 class FileData : public RequestEventHandler {
 public:
-  FileData() : m_pcloseRet(0) {}
-  void clear() { m_pcloseRet = 0; }
+  FileData() : m_pcloseRet(0), m_inputStreamed(false) {}
+  void clear() { m_pcloseRet = 0; m_inputStreamed = false; }
   virtual void requestInit() {
     clear();
   }
@@ -36,6 +36,7 @@ public:
     clear();
   }
   int m_pcloseRet;
+  bool m_inputStreamed; // php://input was opened on a streamed body
 };
 
 DECLARE_EXTERN_REQUEST_LOCAL(FileData, s_file_data);
@@ -0,0 +1,106 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#include <runtime/base/file/input_file.h>
+#include <runtime/base/complex_types.h>
+#include <runtime/base/runtime_error.h>
+#include <runtime/base/server/transport.h>
+
+namespace HPHP {
+
+IMPLEMENT_OBJECT_ALLOCATION(InputFile)
+///////////////////////////////////////////////////////////////////////////////
+
+StaticString InputFile::s_class_name("InputFile");
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor and destructor
+
+InputFile::InputFile(Transport *transport)
+  : File(false), m_transport(transport), m_data(NULL), m_len(0),
+    m_cursor(0) {
+  ASSERT(m_transport);
+  m_data = (const char *)m_transport->getPostData(m_len);
+}
+
+InputFile::~InputFile() {
+  closeImpl();
+}
+
+bool InputFile::open(CStrRef filename, CStrRef mode) {
+  throw FatalErrorException("cannot open a php://input file ");
+}
+
+bool InputFile::close() {
+  return closeImpl();
+}
+
+bool InputFile::closeImpl() {
+  s_file_data->m_pcloseRet = 0;
+  m_closed = true;
+  m_transport = NULL;
+  m_data = NULL;
+  m_len = m_cursor = 0;
+  File::closeImpl();
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// virtual functions
+
+int64 InputFile::readImpl(char *buffer, int64 length) {
+  ASSERT(length > 0);
+  while (m_cursor == m_len) {
+    if (!m_transport || !m_transport->hasMorePostData()) return 0;
+    m_data = (const char *)m_transport->getMorePostData(m_len);
+    m_cursor = 0;
+    if (m_data == NULL) {
+      // connection went away, nothing more is coming
+      m_transport = NULL;
+      m_len = 0;
+    }
+  }
+  int64 remaining = m_len - m_cursor;
+  if (remaining < length) length = remaining;
+  memcpy(buffer, m_data + m_cursor, length);
+  m_cursor += length;
+  return length;
+}
+
+int64 InputFile::writeImpl(const char *buffer, int64 length) {
+  raise_warning("cannot write to a php://input stream");
+  return -1;
+}
+
+int64 InputFile::tell() {
+  return m_position;
+}
+
+bool InputFile::eof() {
+  int64 avail = m_writepos - m_readpos;
+  if (avail > 0 || m_cursor < m_len) {
+    return false;
+  }
+  return !m_transport || !m_transport->hasMorePostData();
+}
+
+bool InputFile::flush() {
+  return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
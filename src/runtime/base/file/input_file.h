@@ -0,0 +1,66 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#ifndef __HPHP_INPUT_FILE_H__
+#define __HPHP_INPUT_FILE_H__
+
+#include <runtime/base/file/file.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class Transport;
+
+/**
+ * For php://input when the request body is still being received: reads
+ * whatever the transport has buffered, then pulls more of the body from the
+ * connection as needed. Like the body itself, it can only be read once:
+ * File::Open() fails on any later php://input of the same request.
+ */
+class InputFile : public File {
+public:
+  DECLARE_OBJECT_ALLOCATION(InputFile);
+
+  InputFile(Transport *transport);
+  virtual ~InputFile();
+
+  static StaticString s_class_name;
+  // overriding ResourceData
+  CStrRef o_getClassNameHook() const { return s_class_name; }
+
+  // implementing File
+  virtual bool open(CStrRef filename, CStrRef mode);
+  virtual bool close();
+  virtual int64 readImpl(char *buffer, int64 length);
+  virtual int64 writeImpl(const char *buffer, int64 length);
+  virtual int64 tell();
+  virtual bool eof();
+  virtual bool flush();
+
+protected:
+  Transport *m_transport;
+  const char *m_data; // body chunk the transport currently holds
+  int m_len;
+  int m_cursor;
+
+  bool closeImpl();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_INPUT_FILE_H__
@@ -215,6 +215,9 @@ const Eval::MethodStatement* ObjectData::getMethodStatement(const char* name)
 const Eval::MethodStatement* ObjectData::getConstructorStatement() const {
   return NULL;
 }
+const Eval::ClassEvalState* ObjectData::getClassEvalState() const {
+  return NULL;
+}
 
 void ObjectData::bindThis(ThreadInfo *info) {
   FrameInjection::SetStaticClassName(info, getRoot()->o_getClassName());
@@ -30,6 +30,7 @@ namespace HPHP {
 // Needed for eval
 namespace Eval {
 class MethodStatement;
+class ClassEvalState;
 class FunctionCallExpression;
 class VariableEnvironment;
 }
@@ -173,6 +174,7 @@ class ObjectData : public CountableNF {
   virtual const Eval::MethodStatement* getConstructorStatement() const;
   virtual const Eval::MethodStatement* getMethodStatement(const char* name)
       const;
+  virtual const Eval::ClassEvalState* getClassEvalState() const;
 
   static Variant os_invoke(CStrRef c, CStrRef s,
                            CArrRef params, int64 hash, bool fatal = true);
@@ -54,8 +54,14 @@ namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 // regex cache and helpers
 
+/**
+ * Entries are refcounted: the cache holds one reference, and so does anything
+ * keeping an entry across user code (preg_replace_callback), which can run
+ * more preg_* calls that replace or flush the cached entry.
+ */
 class pcre_cache_entry {
 public:
+  pcre_cache_entry() : m_refCount(1) {}
   ~pcre_cache_entry() {
     free(re);
     if (extra) free(extra);
@@ -73,6 +79,12 @@ public:
   unsigned const char *tables;
 #endif
   int compile_options;
+
+  void incRef() { m_refCount++; }
+  void decRef() { if (--m_refCount == 0) delete this; }
+
+private:
+  int m_refCount;
 };
 
 typedef hphp_hash_map<StringData *, pcre_cache_entry*,
@@ -87,11 +99,12 @@ public:
     TAINT_OBSERVER_CAP_STACK();
     for (PCREStringMap::iterator it = m_cache.begin(); it != m_cache.end();
          ++it) {
-      delete it->second;
+      it->second->decRef();
       if (!it->first->isStatic()) {
         delete it->first;
       }
     }
+    m_cache.clear();
   }
 
   pcre_cache_entry *find(CStrRef regex) {
@@ -105,7 +118,7 @@ public:
     TAINT_OBSERVER_CAP_STACK();
     PCREStringMap::iterator it = m_cache.find(regex.get());
     if (it != m_cache.end()) {
-      delete it->second;
+      it->second->decRef();
       it->second = pce;
     } else {
       m_cache[regex->copy(true)] = pce;
@@ -750,19 +763,6 @@ Variant preg_match_all(CStrRef pattern, CStrRef subject,
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static String preg_do_repl_func(CVarRef function, CStrRef subject,
-                                int *offsets, int count) {
-  Array subpats = Array::Create();
-  for (int i = 0; i < count; i++) {
-    subpats.append(subject.substr(offsets[i<<1],
-                                  offsets[(i<<1)+1] - offsets[i<<1]));
-  }
-
-  Array args;
-  args.set(0, subpats);
-  return f_call_user_func_array(function, args);
-}
-
 static bool preg_get_backref(const char **str, int *backref) {
   register char in_brace = 0;
   register const char *walk = *str;
@@ -800,56 +800,274 @@ static bool preg_get_backref(const char **str, int *backref) {
   return true;
 }
 
-static String php_pcre_replace(CStrRef pattern, CStrRef subject,
-                               CVarRef replace_var, bool callable,
-                               int limit, int *replace_count) {
-  pcre_cache_entry *pce = pcre_get_compiled_regex_cache(pattern);
-  if (pce == NULL) {
+/**
+ * A replacement string with its "$n", "${n}" and "\\n" backreferences
+ * resolved once, so that substituting a match is just a few memcpy()s
+ * instead of re-scanning the replacement string twice per match.
+ */
+class pcre_replace_template {
+public:
+  void compile(const char *replace, int replace_len) {
+    const char *walk = replace;
+    const char *replace_end = replace + replace_len;
+    char walk_last = 0;
+    int start = 0;
+    int backref;
+    while (walk < replace_end) {
+      if ('\\' == *walk || '$' == *walk) {
+        if (walk_last == '\\') {
+          m_literal[m_literal.size() - 1] = *walk++;
+          walk_last = 0;
+          continue;
+        }
+        if (preg_get_backref(&walk, &backref)) {
+          m_pieces.push_back(Piece(start, m_literal.size() - start, backref));
+          start = m_literal.size();
+          continue;
+        }
+      }
+      m_literal += *walk++;
+      walk_last = walk[-1];
+    }
+    if (start < (int)m_literal.size()) {
+      m_pieces.push_back(Piece(start, m_literal.size() - start, -1));
+    }
+  }
+
+  int length(const int *offsets, int count) const {
+    int len = m_literal.size();
+    for (unsigned int i = 0; i < m_pieces.size(); i++) {
+      int backref = m_pieces[i].backref;
+      if (backref >= 0 && backref < count) {
+        len += offsets[(backref<<1)+1] - offsets[backref<<1];
+      }
+    }
+    return len;
+  }
+
+  char *apply(char *walkbuf, const char *subject, const int *offsets,
+              int count) const {
+    const char *literal = m_literal.data();
+    for (unsigned int i = 0; i < m_pieces.size(); i++) {
+      const Piece &piece = m_pieces[i];
+      memcpy(walkbuf, literal + piece.start, piece.len);
+      walkbuf += piece.len;
+      if (piece.backref >= 0 && piece.backref < count) {
+        int match_len = offsets[(piece.backref<<1)+1] -
+          offsets[piece.backref<<1];
+        memcpy(walkbuf, subject + offsets[piece.backref<<1], match_len);
+        walkbuf += match_len;
+      }
+    }
+    return walkbuf;
+  }
+
+private:
+  struct Piece {
+    Piece(int s, int l, int b) : start(s), len(l), backref(b) {}
+    int start;   // literal text preceding the backref, in m_literal
+    int len;
+    int backref; // -1 for trailing literal text
+  };
+
+  string m_literal;
+  vector<Piece> m_pieces;
+};
+
+/**
+ * Everything needed to apply one pattern/replacement pair, set up once and
+ * reused for every subject it is applied to: compiled regex, offsets vector,
+ * pre-parsed replacement, and the argument arrays handed to the callback.
+ */
+class pcre_replacer {
+public:
+  pcre_replacer()
+    : m_pce(NULL), m_offsets(NULL), m_size_offsets(0),
+      m_callable(false), m_eval(false) {
+  }
+  ~pcre_replacer() {
+    if (m_pce) m_pce->decRef();
+    if (m_offsets) free(m_offsets);
+  }
+
+  bool init(CStrRef pattern, CVarRef replace_var, bool callable);
+  String replace(CStrRef subject, int limit, int *replace_count);
+
+private:
+  String m_pattern;
+  pcre_cache_entry *m_pce;
+  int *m_offsets;
+  int m_size_offsets;
+  bool m_callable;
+  bool m_eval;
+
+  Variant m_replace_var;
+  String m_replace_val;
+  String m_eval_fn;
+  pcre_replace_template m_template;
+
+  Array m_subpats; // reused across callback invocations
+  Array m_args;
+
+  String callback(CStrRef subject, int count);
+  void eval(CStrRef subject, int count, char *&result, int &result_len,
+            int &alloc_len);
+};
+typedef boost::shared_ptr<pcre_replacer> pcre_replacer_ptr;
+
+bool pcre_replacer::init(CStrRef pattern, CVarRef replace_var,
+                         bool callable) {
+  m_pattern = pattern;
+  m_callable = callable;
+  m_pce = pcre_get_compiled_regex_cache(pattern);
+  if (m_pce == NULL) {
     return false;
   }
-  bool eval = false;
-  if (pce->preg_options & PREG_REPLACE_EVAL) {
+  // callbacks may compile enough patterns to drop this one from the cache
+  m_pce->incRef();
+  if (m_pce->preg_options & PREG_REPLACE_EVAL) {
     if (callable)
       throw NotSupportedException("preg_replace",
                                   "Modifier /e cannot be used with replacement "
                                   "callback.");
-    eval = true;
+    m_eval = true;
   }
 
-  int size_offsets;
-  int *offsets = create_offset_array(pce, size_offsets);
-  if (offsets == NULL) {
+  m_offsets = create_offset_array(m_pce, m_size_offsets);
+  if (m_offsets == NULL) {
+    m_pce->decRef();
+    m_pce = NULL;
     return false;
   }
 
-  const char *replace = NULL;
-  const char *replace_end = NULL;
-  int replace_len = 0;
-  String replace_val;
-  String eval_fn;
-
-  if (!callable) {
-    replace_val = replace_var.toString();
-    if (eval) {
-      // Extract eval fn
-      int pidx = replace_val.find('(');
-      const char *rd = replace_val.data();
-      int rs = replace_val.size();
-
-      if (!(rs >= 5 && pidx >= 0 && rd[pidx+1] == '"' &&
-            ((rd[rs-2] == '"' && rd[rs-1] == ')') ||
-            (rd[rs-3] == '"' && rd[rs-2] == ')' && rd[rs-1] == ';')))) {
-        throw NotSupportedException("preg_replace",
-                                    "Modifier /e must be used with the form "
-                                    "f(\"<replacement string>\") or "
-                                    "f(\"<replacement string>\");");
+  if (callable) {
+    m_replace_var = replace_var;
+    m_subpats = Array::Create();
+    m_args = Array::Create();
+    return true;
+  }
+
+  m_replace_val = replace_var.toString();
+  if (m_eval) {
+    // Extract eval fn
+    int pidx = m_replace_val.find('(');
+    const char *rd = m_replace_val.data();
+    int rs = m_replace_val.size();
+
+    if (!(rs >= 5 && pidx >= 0 && rd[pidx+1] == '"' &&
+          ((rd[rs-2] == '"' && rd[rs-1] == ')') ||
+           (rd[rs-3] == '"' && rd[rs-2] == ')' && rd[rs-1] == ';')))) {
+      throw NotSupportedException("preg_replace",
+                                  "Modifier /e must be used with the form "
+                                  "f(\"<replacement string>\") or "
+                                  "f(\"<replacement string>\");");
+    }
+    m_eval_fn = m_replace_val.substr(0, pidx);
+    m_replace_val = m_replace_val.substr(pidx+1, rs - (pidx+1) - 1);
+  } else {
+    m_template.compile(m_replace_val.data(), m_replace_val.size());
+  }
+  return true;
+}
+
+String pcre_replacer::callback(CStrRef subject, int count) {
+  for (int i = 0; i < count; i++) {
+    m_subpats.set(i, subject.substr(m_offsets[i<<1],
+                                    m_offsets[(i<<1)+1] - m_offsets[i<<1]));
+  }
+  for (int i = m_subpats.size() - 1; i >= count; i--) {
+    m_subpats.remove(i);
+  }
+
+  m_args.set(0, m_subpats);
+  String ret = f_call_user_func_array(m_replace_var, m_args);
+  // drop the extra reference so the next match can refill m_subpats in
+  // place, unless the callback kept a copy of it
+  m_args.set(0, null_variant);
+  return ret;
+}
+
+void pcre_replacer::eval(CStrRef subject, int count, char *&result,
+                         int &result_len, int &alloc_len) {
+  /* Expand backrefs in place after the current result, collecting the
+     quoted arguments of the eval function as we go. */
+  int new_len = result_len;
+  const char *replace = m_replace_val.data();
+  const char *replace_end = replace + m_replace_val.size();
+  const char *walk = replace;
+  char walk_last = 0;
+  int backref;
+  while (walk < replace_end) {
+    if ('\\' == *walk || '$' == *walk) {
+      if (walk_last == '\\') {
+        walk++;
+        walk_last = 0;
+        continue;
+      }
+      if (preg_get_backref(&walk, &backref)) {
+        if (backref < count) {
+          new_len += m_offsets[(backref<<1)+1] - m_offsets[backref<<1];
+        }
+        continue;
+      }
+    }
+    new_len++;
+    walk++;
+    walk_last = walk[-1];
+  }
+  if (new_len + 1 > alloc_len) {
+    alloc_len = 1 + alloc_len + 2 * new_len;
+    result = (char *)realloc(result, alloc_len);
+  }
+
+  char *walkbuf = result + result_len;
+  walk = replace;
+  walk_last = 0;
+  Array params;
+  const char* lastStart = NULL;
+  while (walk < replace_end) {
+    bool handleQuote = '"' == *walk && walk_last != '\\';
+    if (handleQuote && lastStart != NULL) {
+      String str(lastStart, walkbuf - lastStart, CopyString);
+      params.append(str);
+      lastStart = NULL;
+      handleQuote = false;
+    }
+    if ('\\' == *walk || '$' == *walk) {
+      if (walk_last == '\\') {
+        *(walkbuf-1) = *walk++;
+        walk_last = 0;
+        continue;
+      }
+      if (preg_get_backref(&walk, &backref)) {
+        if (backref < count) {
+          int match_len = m_offsets[(backref<<1)+1] - m_offsets[backref<<1];
+          memcpy(walkbuf, subject.data() + m_offsets[backref<<1], match_len);
+          walkbuf += match_len;
+        }
+        continue;
       }
-      eval_fn = replace_val.substr(0, pidx);
-      replace_val = replace_val.substr(pidx+1, rs - (pidx+1) - 1);
     }
-    replace = replace_val.data();
-    replace_len = replace_val.size();
-    replace_end = replace + replace_len;
+    *walkbuf++ = *walk++;
+    walk_last = walk[-1];
+    if (handleQuote && lastStart == NULL) {
+      lastStart = walkbuf;
+    }
+  }
+  *walkbuf = '\0';
+
+  String eval_result = f_call_user_func_array(m_eval_fn, params);
+  if (result_len + eval_result.size() + 1 > alloc_len) {
+    alloc_len = 1 + alloc_len + 2 * eval_result.size();
+    result = (char *)realloc(result, alloc_len);
+  }
+  memcpy(result + result_len, eval_result.data(), eval_result.size());
+  result_len += eval_result.size();
+}
+
+String pcre_replacer::replace(CStrRef subject, int limit, int *replace_count) {
+  if (m_pce == NULL) {
+    return false;
   }
 
   int alloc_len = 2 * subject.size() + 1;
@@ -859,26 +1077,22 @@ static String php_pcre_replace(CStrRef pattern, CStrRef subject,
   const char *match = NULL;
   int start_offset = 0;
   s_pcre_cache->error_code = PHP_PCRE_NO_ERROR;
-  pcre_extra *extra = pce->extra;
+  pcre_extra *extra = m_pce->extra;
   set_extra_limits(extra);
 
+  int *offsets = m_offsets;
   int result_len = 0;
   int new_len;        // Length of needed storage
-  const char *walk;   // Used to walk the replacement string
-  char walk_last;     // Last walked character
-  char *walkbuf;      // Location of current replacement in the result
-  int match_len;      // Length of the current match
-  int backref;        // Backreference number
   int g_notempty = 0; // If the match should not be empty
   while (1) {
     /* Execute the regular expression. */
-    int count = pcre_exec(pce->re, extra, subject.data(), subject.size(),
-                          start_offset, g_notempty, offsets, size_offsets);
+    int count = pcre_exec(m_pce->re, extra, subject.data(), subject.size(),
+                          start_offset, g_notempty, offsets, m_size_offsets);
 
     /* Check for too many substrings condition. */
     if (count == 0) {
       raise_warning("Matched, but too many substrings");
-      count = size_offsets / 3;
+      count = m_size_offsets / 3;
     }
 
     const char *piece = subject.data() + start_offset;
@@ -890,33 +1104,13 @@ static String php_pcre_replace(CStrRef pattern, CStrRef subject,
       match = subject.data() + offsets[0];
       new_len = result_len + offsets[0] - start_offset; //part before the match
 
-      /* If evaluating, do it and add the return string's length */
-      String eval_result;
-      if (callable) {
-        /* Use custom function to get replacement string and its length. */
-        eval_result = preg_do_repl_func(replace_var, subject, offsets, count);
-        new_len += eval_result.size();
-      } else { /* do regular substitution */
-        walk = replace;
-        walk_last = 0;
-        while (walk < replace_end) {
-          if ('\\' == *walk || '$' == *walk) {
-            if (walk_last == '\\') {
-              walk++;
-              walk_last = 0;
-              continue;
-            }
-            if (preg_get_backref(&walk, &backref)) {
-              if (backref < count) {
-                new_len += offsets[(backref<<1)+1] - offsets[backref<<1];
-              }
-              continue;
-            }
-          }
-          new_len++;
-          walk++;
-          walk_last = walk[-1];
-        }
+      /* If using custom function, get replacement string and its length. */
+      String callback_result;
+      if (m_callable) {
+        callback_result = callback(subject, count);
+        new_len += callback_result.size();
+      } else if (!m_eval) {
+        new_len += m_template.length(offsets, count);
       }
 
       if (new_len + 1 > alloc_len) {
@@ -928,57 +1122,16 @@ static String php_pcre_replace(CStrRef pattern, CStrRef subject,
       result_len += match-piece;
 
       /* copy replacement and backrefs */
-      walkbuf = result + result_len;
-
-      /* If evaluating or using custom function, copy result to the buffer
-       * and clean up. */
-      if (callable) {
-        memcpy(walkbuf, eval_result.data(), eval_result.size());
-        result_len += eval_result.size();
-      } else { /* do regular backreference copying */
-        walk = replace;
-        walk_last = 0;
-        Array params;
-        const char* lastStart = NULL;
-        while (walk < replace_end) {
-          bool handleQuote = eval && '"' == *walk && walk_last != '\\';
-          if (handleQuote && lastStart != NULL) {
-            String str(lastStart, walkbuf - lastStart, CopyString);
-            params.append(str);
-            lastStart = NULL;
-            handleQuote = false;
-          }
-          if ('\\' == *walk || '$' == *walk) {
-            if (walk_last == '\\') {
-              *(walkbuf-1) = *walk++;
-              walk_last = 0;
-              continue;
-            }
-            if (preg_get_backref(&walk, &backref)) {
-              if (backref < count) {
-                match_len = offsets[(backref<<1)+1] - offsets[backref<<1];
-                memcpy(walkbuf, subject.data() + offsets[backref<<1],
-                       match_len);
-                walkbuf += match_len;
-              }
-              continue;
-            }
-          }
-          *walkbuf++ = *walk++;
-          walk_last = walk[-1];
-          if (handleQuote && lastStart == NULL) {
-            lastStart = walkbuf;
-          }
-        }
-        *walkbuf = '\0';
-        if (eval) {
-          eval_result = f_call_user_func_array(eval_fn, params);
-          memcpy(result + result_len, eval_result.data(), eval_result.size());
-          result_len += eval_result.size();
-        } else {
-          /* increment the result length by how much we've added to the string */
-          result_len += walkbuf - (result + result_len);
-        }
+      if (m_callable) {
+        memcpy(result + result_len, callback_result.data(),
+               callback_result.size());
+        result_len += callback_result.size();
+      } else if (m_eval) {
+        eval(subject, count, result, result_len, alloc_len);
+      } else {
+        char *walkbuf = m_template.apply(result + result_len, subject.data(),
+                                         offsets, count);
+        result_len = walkbuf - result;
       }
 
       if (limit != -1) {
@@ -1012,24 +1165,24 @@ static String php_pcre_replace(CStrRef pattern, CStrRef subject,
         const char *s;
         int size;
         String stemp;
-        if (callable) {
-          if (replace_var.isObject()) {
-            stemp = 
-              replace_var.objectForCall()->o_getClassName() + "::__invoke";
+        if (m_callable) {
+          if (m_replace_var.isObject()) {
+            stemp =
+              m_replace_var.objectForCall()->o_getClassName() + "::__invoke";
           } else {
-            stemp = replace_var.toString();
+            stemp = m_replace_var.toString();
           }
           s = stemp.data();
           size = stemp.size();
         } else {
-          s = replace_val.data();
-          size = replace_val.size();
+          s = m_replace_val.data();
+          size = m_replace_val.size();
         }
         pcre_log_error(__FUNCTION__, __LINE__, count,
-                       pattern.data(), pattern.size(),
+                       m_pattern.data(), m_pattern.size(),
                        subject.data(), subject.size(),
                        s, size,
-                       callable, limit, start_offset, g_notempty);
+                       m_callable, limit, start_offset, g_notempty);
       }
       pcre_handle_exec_error(count);
       free(result);
@@ -1047,47 +1200,56 @@ static String php_pcre_replace(CStrRef pattern, CStrRef subject,
     start_offset = offsets[1];
   }
 
-  free(offsets);
   if (result) {
     return String(result, result_len, AttachString);
   }
   return String();
 }
 
-static String php_replace_in_subject(CVarRef regex, CVarRef replace,
-                                     String subject, int limit, bool callable,
-                                     int *replace_count) {
+/**
+ * Compiles every pattern of a preg_replace() call once, so that an array of
+ * subjects shares a single compile/study pass and offsets vector per pattern.
+ */
+static void php_prepare_replacers(CVarRef regex, CVarRef replace,
+                                  bool callable,
+                                  vector<pcre_replacer_ptr> &replacers) {
   if (!regex.is(KindOfArray)) {
-    return php_pcre_replace(regex.toString(), subject, replace,
-                            callable, limit, replace_count);
+    pcre_replacer_ptr replacer(new pcre_replacer());
+    replacer->init(regex.toString(), replace, callable);
+    replacers.push_back(replacer);
+    return;
   }
 
   if (callable || !replace.is(KindOfArray)) {
     Array arr = regex.toArray();
     for (ArrayIter iterRegex(arr); iterRegex; ++iterRegex) {
-      String regex_entry = iterRegex.second().toString();
-      subject = php_pcre_replace(regex_entry, subject, replace,
-                                 callable, limit, replace_count);
-      if (subject.isNull()) {
-        return subject;
-      }
+      pcre_replacer_ptr replacer(new pcre_replacer());
+      replacer->init(iterRegex.second().toString(), replace, callable);
+      replacers.push_back(replacer);
     }
-    return subject;
+    return;
   }
 
   Array arrReplace = replace.toArray();
   Array arrRegex = regex.toArray();
   ArrayIter iterReplace(arrReplace);
   for (ArrayIter iterRegex(arrRegex); iterRegex; ++iterRegex) {
-    String regex_entry = iterRegex.second().toString();
     Variant replace_value;
     if (iterReplace) {
       replace_value = iterReplace.second();
       ++iterReplace;
     }
+    pcre_replacer_ptr replacer(new pcre_replacer());
+    replacer->init(iterRegex.second().toString(), replace_value, callable);
+    replacers.push_back(replacer);
+  }
+}
 
-    subject = php_pcre_replace(regex_entry, subject, replace_value,
-                               callable, limit, replace_count);
+static String php_replace_in_subject(const vector<pcre_replacer_ptr> &replacers,
+                                     String subject, int limit,
+                                     int *replace_count) {
+  for (unsigned int i = 0; i < replacers.size(); i++) {
+    subject = replacers[i]->replace(subject, limit, replace_count);
     if (subject.isNull()) {
       return subject;
     }
@@ -1105,11 +1267,13 @@ Variant preg_replace_impl(CVarRef pattern, CVarRef replacement,
     return false;
   }
 
+  vector<pcre_replacer_ptr> replacers;
+  php_prepare_replacers(pattern, replacement, is_callable, replacers);
+
   int replace_count = 0;
   if (!subject.is(KindOfArray)) {
-    String ret = php_replace_in_subject(pattern, replacement,
-                                        subject.toString(),
-                                        limit, is_callable, &replace_count);
+    String ret = php_replace_in_subject(replacers, subject.toString(),
+                                        limit, &replace_count);
     count = replace_count;
     return ret;
   }
@@ -1118,8 +1282,8 @@ Variant preg_replace_impl(CVarRef pattern, CVarRef replacement,
   Array arrSubject = subject.toArray();
   for (ArrayIter iter(arrSubject); iter; ++iter) {
     String subject_entry = iter.second().toString();
-    String result = php_replace_in_subject(pattern, replacement, subject_entry,
-                                           limit, is_callable, &replace_count);
+    String result = php_replace_in_subject(replacers, subject_entry,
+                                           limit, &replace_count);
     if (!result.isNull()) {
       return_value.set(iter.first(), result);
     }
@@ -27,6 +27,7 @@
 #include <system/gen/php/globals/symbols.h>
 #include <runtime/base/server/pagelet_server.h>
 #include <runtime/base/server/xbox_server.h>
+#include <runtime/base/server/shared_worker_pool.h>
 #include <runtime/base/server/http_server.h>
 #include <runtime/base/server/replay_transport.h>
 #include <runtime/base/server/http_request_handler.h>
@@ -63,6 +64,8 @@
 
 #include <runtime/eval/runtime/eval_state.h>
 #include <runtime/eval/runtime/file_repository.h>
+#include <runtime/eval/runtime/parse_cache.h>
+#include <runtime/eval/runtime/stat_cache.h>
 #include <runtime/eval/parser/parser.h>
 
 using namespace std;
@@ -1007,6 +1010,7 @@ void hphp_process_init() {
   Process::InitProcessStatics();
   init_static_variables();
   init_literal_varstrings();
+  SharedWorkerPool::Restart();
   PageletServer::Restart();
   XboxServer::Restart();
   FiberAsyncFunc::Restart();
@@ -1266,6 +1270,9 @@ void hphp_session_exit() {
 void hphp_process_exit() {
   FiberAsyncFunc::Stop();
   Eval::Debugger::Stop();
+  Eval::FileRepository::StopPreparse();
+  Eval::ParseCache::Flush();
+  Eval::StatCache::Stop();
   Extension::ShutdownModules();
   LightProcess::Close();
 }
@@ -74,6 +74,8 @@ bool RuntimeOption::AssertWarning = false;
 int RuntimeOption::NoticeFrequency = 1;
 int RuntimeOption::WarningFrequency = 1;
 int64 RuntimeOption::SerializationSizeLimit = 0;
+int64 RuntimeOption::ParallelSerializationThreshold = 0;
+int RuntimeOption::ParallelSerializationThreadCount = 4;
 int64 RuntimeOption::StringOffsetLimit = 10 * 1024 * 1024; // 10MB
 
 std::string RuntimeOption::AccessLogDefaultFormat;
@@ -97,23 +99,44 @@ int RuntimeOption::ServerThreadCount = 50;
 bool RuntimeOption::ServerThreadRoundRobin = false;
 int RuntimeOption::ServerThreadDropCacheTimeoutSeconds = 0;
 bool RuntimeOption::ServerThreadJobLIFO = false;
+bool RuntimeOption::ServerThreadJobStealing = false;
 bool RuntimeOption::ServerThreadDropStack = false;
 int RuntimeOption::PageletServerThreadCount = 0;
 bool RuntimeOption::PageletServerThreadRoundRobin = false;
 int RuntimeOption::PageletServerThreadDropCacheTimeoutSeconds = 0;
 int RuntimeOption::PageletServerQueueLimit = 0;
 bool RuntimeOption::PageletServerThreadDropStack = false;
+bool RuntimeOption::PageletServerThreadJobStealing = false;
+int RuntimeOption::WorkerPoolThreadCount = 0;
+int RuntimeOption::WorkerPoolPageWeight = 4;
+int RuntimeOption::WorkerPoolPageMinThreads = 0;
+int RuntimeOption::WorkerPoolPageletWeight = 2;
+int RuntimeOption::WorkerPoolPageletMinThreads = 0;
+int RuntimeOption::WorkerPoolXboxWeight = 1;
+int RuntimeOption::WorkerPoolXboxMinThreads = 0;
 int RuntimeOption::FiberCount = 1;
 int RuntimeOption::RequestTimeoutSeconds = 0;
 size_t RuntimeOption::ServerMemoryHeadRoom = 0;
 int64 RuntimeOption::RequestMemoryMaxBytes = -1;
 int64 RuntimeOption::ImageMemoryMaxBytes = 0;
 int RuntimeOption::ResponseQueueCount;
+int RuntimeOption::ServerEventLoopCount = 1;
+bool RuntimeOption::ConcurrencyLimitEnabled = false;
+int RuntimeOption::ConcurrencyLimitMin = 0;
+int RuntimeOption::ConcurrencyLimitMax = 0;
+int RuntimeOption::ConcurrencyLimitQueueTimeTarget = 100;
+int RuntimeOption::ConcurrencyLimitWindow = 500;
+int RuntimeOption::ConcurrencyLimitRetryAfter = 1;
 int RuntimeOption::ServerGracefulShutdownWait;
 bool RuntimeOption::ServerHarshShutdown = true;
 bool RuntimeOption::ServerEvilShutdown = true;
 int RuntimeOption::ServerDanglingWait;
 int RuntimeOption::GzipCompressionLevel = 3;
+int64 RuntimeOption::GzipCompressionCacheSize = 0;
+int RuntimeOption::GzipCompressionOffloadThreshold = 0;
+int RuntimeOption::GzipCompressionThreadCount = 2;
+int RuntimeOption::BrotliCompressionLevel = 0;
+int RuntimeOption::ZstdCompressionLevel = 0;
 std::string RuntimeOption::ForceCompressionURL;
 std::string RuntimeOption::ForceCompressionCookie;
 std::string RuntimeOption::ForceCompressionParam;
@@ -122,6 +145,8 @@ bool RuntimeOption::EnableKeepAlive = true;
 bool RuntimeOption::ExposeHPHP = true;
 bool RuntimeOption::ExposeXFBServer = false;
 int RuntimeOption::ConnectionTimeoutSeconds = -1;
+int RuntimeOption::KeepAliveIdleMax = 0;
+int RuntimeOption::KeepAliveIdleTimeoutSeconds = 0;
 bool RuntimeOption::EnableOutputBuffering = false;
 std::string RuntimeOption::OutputHandler;
 bool RuntimeOption::ImplicitFlush = false;
@@ -143,6 +168,7 @@ std::string RuntimeOption::DefaultCharsetName = "utf-8";
 bool RuntimeOption::ForceServerNameToHeader = false;
 
 int RuntimeOption::RequestBodyReadLimit = -1;
+bool RuntimeOption::StreamRequestBody = false;
 
 bool RuntimeOption::EnableSSL = false;
 int RuntimeOption::SSLPort = 443;
@@ -155,6 +181,7 @@ IpBlockMapPtr RuntimeOption::IpBlocks;
 SatelliteServerInfoPtrVec RuntimeOption::SatelliteServerInfos;
 
 int RuntimeOption::XboxServerThreadCount = 0;
+bool RuntimeOption::XboxServerThreadJobStealing = false;
 int RuntimeOption::XboxServerMaxQueueLength = INT_MAX;
 int RuntimeOption::XboxServerPort = 0;
 int RuntimeOption::XboxDefaultLocalTimeoutMilliSeconds = 500;
@@ -183,6 +210,7 @@ bool RuntimeOption::EnableStaticContentCache = true;
 bool RuntimeOption::EnableStaticContentFromDisk = true;
 bool RuntimeOption::EnableOnDemandUncompress = true;
 bool RuntimeOption::EnableStaticContentMMap = true;
+int RuntimeOption::StaticContentZeroCopyMinSize = 16384;
 
 std::string RuntimeOption::RTTIDirectory;
 bool RuntimeOption::EnableCliRTTI = false;
@@ -327,6 +355,12 @@ bool RuntimeOption::EnableXHP = true;
 bool RuntimeOption::EnableObjDestructCall = false;
 bool RuntimeOption::EnableEvalOptimization = true;
 int RuntimeOption::EvalScalarValueExprLimit = 64;
+bool RuntimeOption::EvalBytecodeInterpreter = false;
+std::string RuntimeOption::EvalParseCacheFile;
+int RuntimeOption::EvalPreparseThreads = 0;
+std::string RuntimeOption::EvalPreparseFileList;
+bool RuntimeOption::EvalStatCache = false;
+int RuntimeOption::EvalStatCacheRevalidate = 1;
 bool RuntimeOption::CheckSymLink = false;
 bool RuntimeOption::NativeXHP = true;
 int RuntimeOption::ScannerType = 0;
@@ -581,6 +615,10 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     MaxSQLRowCount = rlimit["MaxSQLRowCount"].getInt64(0);
     MaxMemcacheKeyCount = rlimit["MaxMemcacheKeyCount"].getInt64(0);
     SerializationSizeLimit = rlimit["SerializationSizeLimit"].getInt64(0);
+    ParallelSerializationThreshold =
+      rlimit["ParallelSerializationThreshold"].getInt64(0);
+    ParallelSerializationThreadCount =
+      rlimit["ParallelSerializationThreadCount"].getInt32(4);
     StringOffsetLimit = rlimit["StringOffsetLimit"].getInt64(10 * 1024 * 1024);
   }
   {
@@ -597,6 +635,7 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     ServerThreadDropCacheTimeoutSeconds =
       server["ThreadDropCacheTimeoutSeconds"].getInt32(0);
     ServerThreadJobLIFO = server["ThreadJobLIFO"].getBool();
+    ServerThreadJobStealing = server["ThreadJobStealing"].getBool();
     ServerThreadDropStack = server["ThreadDropStack"].getBool();
     RequestTimeoutSeconds = server["RequestTimeoutSeconds"].getInt32(0);
     ServerMemoryHeadRoom = server["MemoryHeadRoom"].getInt64(0);
@@ -606,6 +645,18 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
       ResponseQueueCount = ServerThreadCount / 10;
       if (ResponseQueueCount <= 0) ResponseQueueCount = 1;
     }
+    ServerEventLoopCount = server["EventLoopCount"].getInt32(1);
+    if (ServerEventLoopCount <= 0) ServerEventLoopCount = 1;
+    {
+      Hdf limit = server["ConcurrencyLimit"];
+      ConcurrencyLimitEnabled = limit["Enabled"].getBool();
+      ConcurrencyLimitMin = limit["Min"].getInt32(ServerThreadCount);
+      ConcurrencyLimitMax = limit["Max"].getInt32(ServerThreadCount * 4);
+      ConcurrencyLimitQueueTimeTarget =
+        limit["QueueTimeTargetMilliSeconds"].getInt32(100);
+      ConcurrencyLimitWindow = limit["WindowMilliSeconds"].getInt32(500);
+      ConcurrencyLimitRetryAfter = limit["RetryAfterSeconds"].getInt32(1);
+    }
     ServerGracefulShutdownWait = server["GracefulShutdownWait"].getInt16(0);
     ServerHarshShutdown = server["HarshShutdown"].getBool(true);
     ServerEvilShutdown = server["EvilShutdown"].getBool(true);
@@ -614,6 +665,17 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
       ServerGracefulShutdownWait = ServerDanglingWait;
     }
     GzipCompressionLevel = server["GzipCompressionLevel"].getInt16(3);
+    GzipCompressionCacheSize =
+      server["GzipCompressionCacheSize"].getInt64(0);
+    GzipCompressionOffloadThreshold =
+      server["GzipCompressionOffloadThreshold"].getInt32(0);
+    GzipCompressionThreadCount =
+      server["GzipCompressionThreadCount"].getInt32(2);
+    if (GzipCompressionThreadCount <= 0) GzipCompressionThreadCount = 1;
+    BrotliCompressionLevel = server["BrotliCompressionLevel"].getInt16(0);
+    ZstdCompressionLevel = server["ZstdCompressionLevel"].getInt16(0);
+    if (BrotliCompressionLevel > 11) BrotliCompressionLevel = 11;
+    if (ZstdCompressionLevel > 22) ZstdCompressionLevel = 22;
 
     ForceCompressionURL    = server["ForceCompression"]["URL"].getString();
     ForceCompressionCookie = server["ForceCompression"]["Cookie"].getString();
@@ -624,6 +686,9 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     ExposeHPHP = server["ExposeHPHP"].getBool(true);
     ExposeXFBServer = server["ExposeXFBServer"].getBool();
     ConnectionTimeoutSeconds = server["ConnectionTimeoutSeconds"].getInt16(-1);
+    KeepAliveIdleMax = server["KeepAliveIdleMax"].getInt32(0);
+    KeepAliveIdleTimeoutSeconds =
+      server["KeepAliveIdleTimeoutSeconds"].getInt32(0);
     EnableOutputBuffering = server["EnableOutputBuffering"].getBool();
     OutputHandler = server["OutputHandler"].getString();
     ImplicitFlush = server["ImplicitFlush"].getBool();
@@ -640,6 +705,11 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     DefaultCharsetName = server["DefaultCharsetName"].getString("utf-8");
 
     RequestBodyReadLimit = server["RequestBodyReadLimit"].getInt32(-1);
+    StreamRequestBody = server["StreamRequestBody"].getBool();
+    if (StreamRequestBody && RequestBodyReadLimit < 0) {
+      // requests have to be dispatched before their bodies are read
+      RequestBodyReadLimit = 64 * 1024;
+    }
 
     EnableSSL = server["EnableSSL"].getBool();
     SSLPort = server["SSLPort"].getInt16(443);
@@ -678,6 +748,8 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     if (EnableStaticContentMMap) {
       EnableOnDemandUncompress = true;
     }
+    StaticContentZeroCopyMinSize =
+      server["StaticContentZeroCopyMinSize"].getInt32(16384);
     RTTIDirectory =
       Util::normalizeDir(server["RTTIDirectory"].getString("/tmp/"));
     EnableCliRTTI = server["EnableCliRTTI"].getBool();
@@ -844,6 +916,8 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
   {
     Hdf xbox = config["Xbox"];
     XboxServerThreadCount = xbox["ServerInfo.ThreadCount"].getInt32(0);
+    XboxServerThreadJobStealing =
+      xbox["ServerInfo.ThreadJobStealing"].getBool();
     XboxServerMaxQueueLength =
       xbox["ServerInfo.MaxQueueLength"].getInt32(INT_MAX);
     if (XboxServerMaxQueueLength < 0) XboxServerMaxQueueLength = INT_MAX;
@@ -867,10 +941,21 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     PageletServerThreadCount = pagelet["ThreadCount"].getInt32(0);
     PageletServerThreadRoundRobin = pagelet["ThreadRoundRobin"].getBool();
     PageletServerThreadDropStack = pagelet["ThreadDropStack"].getBool();
+    PageletServerThreadJobStealing = pagelet["ThreadJobStealing"].getBool();
     PageletServerThreadDropCacheTimeoutSeconds =
       pagelet["ThreadDropCacheTimeoutSeconds"].getInt32(0);
     PageletServerQueueLimit = pagelet["QueueLimit"].getInt32(0);
   }
+  {
+    Hdf pool = config["WorkerPool"];
+    WorkerPoolThreadCount = pool["ThreadCount"].getInt32(0);
+    WorkerPoolPageWeight = pool["Page.Weight"].getInt32(4);
+    WorkerPoolPageMinThreads = pool["Page.MinThreads"].getInt32(0);
+    WorkerPoolPageletWeight = pool["Pagelet.Weight"].getInt32(2);
+    WorkerPoolPageletMinThreads = pool["Pagelet.MinThreads"].getInt32(0);
+    WorkerPoolXboxWeight = pool["Xbox.Weight"].getInt32(1);
+    WorkerPoolXboxMinThreads = pool["Xbox.MinThreads"].getInt32(0);
+  }
   {
     FiberCount = config["Fiber.ThreadCount"].getInt32(Process::GetCPUCount());
   }
@@ -1031,6 +1116,12 @@ void RuntimeOption::Load(Hdf &config, StringVec *overwrites /* = NULL */) {
     EnableObjDestructCall = eval["EnableObjDestructCall"].getBool(false);
     EnableEvalOptimization = eval["EnableEvalOptimization"].getBool(true);
     EvalScalarValueExprLimit = eval["EvalScalarValueExprLimit"].getInt32(64);
+    EvalBytecodeInterpreter = eval["BytecodeInterpreter"].getBool(false);
+    EvalParseCacheFile = eval["ParseCacheFile"].getString();
+    EvalPreparseThreads = eval["PreparseThreads"].getInt32(0);
+    EvalPreparseFileList = eval["PreparseFileList"].getString();
+    EvalStatCache = eval["StatCache"].getBool(false);
+    EvalStatCacheRevalidate = eval["StatCacheRevalidate"].getInt32(1);
     MaxUserFunctionId = eval["MaxUserFunctionId"].getInt32(2 * 65536);
     CheckSymLink = eval["CheckSymLink"].getBool(false);
     NativeXHP = eval["NativeXHP"].getBool(true);
@@ -69,6 +69,8 @@ public:
   static int NoticeFrequency; // output 1 out of NoticeFrequency notices
   static int WarningFrequency;
   static int64 SerializationSizeLimit;
+  static int64 ParallelSerializationThreshold;
+  static int ParallelSerializationThreadCount;
   static int64 StringOffsetLimit;
 
   static std::string AccessLogDefaultFormat;
@@ -91,23 +93,44 @@ public:
   static bool ServerThreadRoundRobin;
   static int ServerThreadDropCacheTimeoutSeconds;
   static bool ServerThreadJobLIFO;
+  static bool ServerThreadJobStealing;
   static bool ServerThreadDropStack;
   static int PageletServerThreadCount;
   static bool PageletServerThreadRoundRobin;
   static int PageletServerThreadDropCacheTimeoutSeconds;
   static int PageletServerQueueLimit;
   static bool PageletServerThreadDropStack;
+  static bool PageletServerThreadJobStealing;
+  static int WorkerPoolThreadCount;
+  static int WorkerPoolPageWeight;
+  static int WorkerPoolPageMinThreads;
+  static int WorkerPoolPageletWeight;
+  static int WorkerPoolPageletMinThreads;
+  static int WorkerPoolXboxWeight;
+  static int WorkerPoolXboxMinThreads;
   static int FiberCount;
   static int RequestTimeoutSeconds;
   static size_t ServerMemoryHeadRoom;
   static int64 RequestMemoryMaxBytes;
   static int64 ImageMemoryMaxBytes;
   static int ResponseQueueCount;
+  static int ServerEventLoopCount;
+  static bool ConcurrencyLimitEnabled;
+  static int ConcurrencyLimitMin;
+  static int ConcurrencyLimitMax;
+  static int ConcurrencyLimitQueueTimeTarget;
+  static int ConcurrencyLimitWindow;
+  static int ConcurrencyLimitRetryAfter;
   static int ServerGracefulShutdownWait;
   static int ServerDanglingWait;
   static bool ServerHarshShutdown;
   static bool ServerEvilShutdown;
   static int GzipCompressionLevel;
+  static int64 GzipCompressionCacheSize;
+  static int GzipCompressionOffloadThreshold;
+  static int GzipCompressionThreadCount;
+  static int BrotliCompressionLevel;
+  static int ZstdCompressionLevel;
   static std::string ForceCompressionURL;
   static std::string ForceCompressionCookie;
   static std::string ForceCompressionParam;
@@ -116,6 +139,8 @@ public:
   static bool ExposeHPHP;
   static bool ExposeXFBServer;
   static int ConnectionTimeoutSeconds;
+  static int KeepAliveIdleMax;
+  static int KeepAliveIdleTimeoutSeconds;
   static bool EnableOutputBuffering;
   static std::string OutputHandler;
   static bool ImplicitFlush;
@@ -142,6 +167,9 @@ public:
   // If a request has a body over this limit, switch to on-demand reading.
   // -1 for no limit.
   static int RequestBodyReadLimit;
+  // Leave bodies that are not forms on the connection for php://input and
+  // file uploads to pull as they read, instead of buffering them up front.
+  static bool StreamRequestBody;
 
   static bool EnableSSL;
   static int SSLPort;
@@ -150,6 +178,7 @@ public:
   static std::string SSLCertificateKeyFile;
 
   static int XboxServerThreadCount;
+  static bool XboxServerThreadJobStealing;
   static int XboxServerMaxQueueLength;
   static int XboxServerPort;
   static int XboxDefaultLocalTimeoutMilliSeconds;
@@ -178,6 +207,7 @@ public:
   static bool EnableStaticContentFromDisk;
   static bool EnableOnDemandUncompress;
   static bool EnableStaticContentMMap;
+  static int StaticContentZeroCopyMinSize;
 
   static std::string RTTIDirectory;
   static bool EnableCliRTTI;
@@ -338,6 +368,12 @@ public:
   static bool EnableObjDestructCall;
   static bool EnableEvalOptimization;
   static int  EvalScalarValueExprLimit;
+  static bool EvalBytecodeInterpreter;
+  static std::string EvalParseCacheFile;
+  static int EvalPreparseThreads;
+  static std::string EvalPreparseFileList;
+  static bool EvalStatCache;
+  static int EvalStatCacheRevalidate;
   static bool CheckSymLink;
   static bool NativeXHP;
   static int ScannerType;
@@ -128,8 +128,23 @@ void AdminRequestHandler::handleRequest(Transport *transport) {
         "                  requests\n"
         "/check-pl-queued: how many pagelet requests are queued waiting to\n"
         "                  be handled\n"
+        "/check-queue-wait: histogram of how long http requests waited in\n"
+        "                  queue, one \"<us> <count>\" line per bucket\n"
+        "/check-pl-queue-wait: same for pagelet requests\n"
+        "/check-pl-stats:  count, average and max queue time and execution\n"
+        "                  time in us of finished pagelet requests by URL\n"
+        "/check-concurrency-limit: current limit on in-flight http requests\n"
+        "                  and how many requests it has turned away\n"
+        "/check-connections: open and idle http connections, and how many\n"
+        "                  requests closed ones served\n"
         "/check-mem:       report memory quick statistics in log file\n"
         "/check-apc:       report APC quick statistics\n"
+        "/check-parse-cache: hits and misses of the eval parse cache, and\n"
+        "                  how many files it holds\n"
+        "/check-parse-time: histogram of how long eval files took to parse,\n"
+        "                  one \"<us> <count>\" line per bucket\n"
+        "/check-dynamic-locals: eval functions whose locals can be reached\n"
+        "                  by name, with the constructs that cause it\n"
         "/check-sql:       report SQL table statistics\n"
 
         "/status.xml:      show server status in XML\n"
@@ -483,6 +498,26 @@ static bool send_status(Transport *transport, ServerStats::Format format,
   return true;
 }
 
+static string queue_wait_histogram(const std::vector<int64> &counts) {
+  // each line is "<upper bound in us> <count>", last bucket has no bound
+  string out;
+  for (unsigned int i = 0; i < counts.size(); i++) {
+    if (i + 1 < counts.size()) {
+      out += lexical_cast<string>(1LL << i);
+    } else {
+      out += "inf";
+    }
+    out += " ";
+    out += lexical_cast<string>(counts[i]);
+    out += "\n";
+  }
+  return out;
+}
+
+void (*parse_cache_stats)(std::ostream &out) = NULL;
+void (*parse_time_histogram)(std::vector<int64> &counts) = NULL;
+void (*dynamic_locals_report)(std::ostream &out) = NULL;
+
 bool AdminRequestHandler::handleCheckRequest(const std::string &cmd,
                                              Transport *transport) {
   if (cmd == "check-load") {
@@ -505,6 +540,67 @@ bool AdminRequestHandler::handleCheckRequest(const std::string &cmd,
     transport->sendString(lexical_cast<string>(count));
     return true;
   }
+  if (cmd == "check-concurrency-limit") {
+    ConcurrencyLimiterPtr limiter =
+      HttpServer::Server->getConcurrencyLimiter();
+    if (!limiter) {
+      transport->sendString("Concurrency limit is not enabled\n");
+      return true;
+    }
+    ServerPtr server = HttpServer::Server->getPageServer();
+    ostringstream out;
+    out << "limit " << limiter->getLimit() << "\n"
+        << "in-flight " << server->getActiveWorker() + server->getQueuedJobs()
+        << "\n"
+        << "rejected " << limiter->getRejected() << "\n";
+    transport->sendString(out.str());
+    return true;
+  }
+  if (cmd == "check-connections") {
+    ServerConnectionStats stats;
+    HttpServer::Server->getPageServer()->getConnectionStats(stats);
+    ostringstream out;
+    out << "open " << stats.open << "\n"
+        << "idle " << stats.idle << "\n"
+        << "opened " << stats.opened << "\n"
+        << "closed " << stats.closed << "\n"
+        << "reused " << stats.reused << "\n"
+        << "evicted " << stats.evicted << "\n"
+        << "timed-out " << stats.timedOut << "\n";
+    // one "<at least this many requests> <connections>" line per bucket
+    for (unsigned int i = 0; i < stats.requestsPerConnection.size(); i++) {
+      if (stats.requestsPerConnection[i] == 0) continue;
+      out << (1 << i) << " " << stats.requestsPerConnection[i] << "\n";
+    }
+    transport->sendString(out.str());
+    return true;
+  }
+  if (cmd == "check-queue-wait") {
+    std::vector<int64> counts;
+    HttpServer::Server->getPageServer()->getQueueWaitHistogram(counts);
+    transport->sendString(queue_wait_histogram(counts));
+    return true;
+  }
+  if (cmd == "check-pl-queue-wait") {
+    std::vector<int64> counts;
+    PageletServer::GetQueueWaitHistogram(counts);
+    transport->sendString(queue_wait_histogram(counts));
+    return true;
+  }
+  if (cmd == "check-pl-stats") {
+    std::map<std::string, PageletStats> stats;
+    PageletServer::GetStats(stats);
+    ostringstream out;
+    for (std::map<std::string, PageletStats>::const_iterator iter =
+           stats.begin(); iter != stats.end(); ++iter) {
+      const PageletStats &s = iter->second;
+      out << iter->first << " " << s.count
+          << " " << s.queueTimeUs / s.count << " " << s.maxQueueTimeUs
+          << " " << s.execTimeUs / s.count << " " << s.maxExecTimeUs << "\n";
+    }
+    transport->sendString(out.str());
+    return true;
+  }
   if (cmd == "check-mem") {
     return toggle_switch(transport, RuntimeOption::CheckMemory);
   }
@@ -516,6 +612,32 @@ bool AdminRequestHandler::handleCheckRequest(const std::string &cmd,
     transport->sendString(stats);
     return true;
   }
+  if (cmd == "check-parse-cache") {
+    if (!parse_cache_stats || RuntimeOption::EvalParseCacheFile.empty()) {
+      transport->sendString("No Parse Cache\n");
+      return true;
+    }
+    ostringstream out;
+    (*parse_cache_stats)(out);
+    transport->sendString(out.str());
+    return true;
+  }
+  if (cmd == "check-parse-time") {
+    std::vector<int64> counts;
+    if (parse_time_histogram) {
+      (*parse_time_histogram)(counts);
+    }
+    transport->sendString(queue_wait_histogram(counts));
+    return true;
+  }
+  if (cmd == "check-dynamic-locals") {
+    ostringstream out;
+    if (dynamic_locals_report) {
+      (*dynamic_locals_report)(out);
+    }
+    transport->sendString(out.str());
+    return true;
+  }
   if (cmd == "check-sql") {
     string stats = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
     stats += "<SQL>\n";
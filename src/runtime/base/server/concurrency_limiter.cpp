@@ -0,0 +1,110 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/base/server/concurrency_limiter.h>
+#include <util/atomic.h>
+#include <util/compatibility.h>
+#include <math.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+const int ConcurrencyLimiter::s_shares[PriorityCount] = { 50, 90, 100 };
+
+static int64 to_us(const timespec &ts) {
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+int64 ConcurrencyLimiter::Now() {
+  timespec ts;
+  gettime(CLOCK_MONOTONIC, &ts);
+  return to_us(ts);
+}
+
+ConcurrencyLimiter::Priority
+ConcurrencyLimiter::ParsePriority(const char *name) {
+  if (name) {
+    if (strcasecmp(name, "low") == 0) return LowPriority;
+    if (strcasecmp(name, "high") == 0) return HighPriority;
+  }
+  return NormalPriority;
+}
+
+ConcurrencyLimiter::ConcurrencyLimiter(int minLimit, int maxLimit,
+                                       int targetQueueMs, int windowMs)
+  : m_minLimit(minLimit), m_maxLimit(maxLimit),
+    m_targetUs(targetQueueMs * 1000LL), m_windowUs(windowMs * 1000LL),
+    m_limit(maxLimit), m_rejected(0), m_windowStart(Now()),
+    m_queueUs(0), m_samples(0), m_peak(0) {
+  if (m_minLimit < 1) m_minLimit = 1;
+  if (m_maxLimit < m_minLimit) m_maxLimit = m_minLimit;
+  m_limit = m_maxLimit;
+}
+
+void ConcurrencyLimiter::onDequeue(const timespec &queueStart) {
+  onDequeue(Now() - to_us(queueStart));
+}
+
+void ConcurrencyLimiter::onDequeue(int64 queueUs) {
+  atomic_add(m_queueUs, queueUs);
+  atomic_inc(m_samples);
+}
+
+bool ConcurrencyLimiter::admit(int priority, int inFlight, int64 now) {
+  if (inFlight > m_peak) m_peak = inFlight; // racy, but only a hint
+
+  if (now - m_windowStart >= m_windowUs && m_mutex.tryLock()) {
+    closeWindow(now);
+    m_mutex.unlock();
+  }
+
+  if (priority < 0 || priority >= PriorityCount) priority = NormalPriority;
+  int allowed = (int64)m_limit * s_shares[priority] / 100;
+  if (inFlight <= allowed || inFlight <= m_minLimit) {
+    return true;
+  }
+  atomic_add(m_rejected, (int64)1);
+  return false;
+}
+
+void ConcurrencyLimiter::closeWindow(int64 now) {
+  if (now - m_windowStart < m_windowUs) return; // closed by someone else
+  int samples = m_samples;
+  int64 queueUs = m_queueUs;
+  int peak = m_peak;
+  m_samples = 0;
+  m_queueUs = 0;
+  m_peak = 0;
+  m_windowStart = now;
+  if (samples == 0) return;
+
+  int limit = m_limit;
+  int64 average = queueUs / samples;
+  if (average > m_targetUs) {
+    // gradient: shrink by target/average, at most by half each window
+    double gradient = (double)m_targetUs / average;
+    if (gradient < 0.5) gradient = 0.5;
+    limit = (int)(limit * gradient);
+  } else if (peak * 10 >= limit * 8) {
+    limit += (int)sqrt((double)limit);
+  }
+  if (limit < m_minLimit) limit = m_minLimit;
+  if (limit > m_maxLimit) limit = m_maxLimit;
+  m_limit = limit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
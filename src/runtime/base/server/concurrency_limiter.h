@@ -0,0 +1,102 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_CONCURRENCY_LIMITER_H__
+#define __HPHP_CONCURRENCY_LIMITER_H__
+
+#include <runtime/base/types.h>
+#include <util/mutex.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Decides whether an incoming request should be queued or turned away right
+ * away with 503 because the server is falling behind. The limit on in-flight
+ * requests (queued plus being handled) adapts to measured queue time:
+ * every window, it shrinks in proportion to how far the average queue time
+ * overshot the target, or grows by about sqrt(limit) if the target was met
+ * and the limit was actually being hit. Lower priority requests only get a
+ * share of the limit, so they are shed first.
+ */
+DECLARE_BOOST_TYPES(ConcurrencyLimiter);
+class ConcurrencyLimiter {
+public:
+  enum Priority {
+    LowPriority,
+    NormalPriority,
+    HighPriority,
+
+    PriorityCount
+  };
+
+  /**
+   * "low", "normal" or "high"; anything else is normal.
+   */
+  static Priority ParsePriority(const char *name);
+
+public:
+  ConcurrencyLimiter(int minLimit, int maxLimit, int targetQueueMs,
+                     int windowMs);
+
+  /**
+   * Called before a request is queued: checks whether it fits under its
+   * priority's share of the current limit. "inFlight" includes the request
+   * itself. "now" is in microseconds on the monotonic clock.
+   */
+  bool admit(int priority, int inFlight) {
+    return admit(priority, inFlight, Now());
+  }
+  bool admit(int priority, int inFlight, int64 now);
+
+  /**
+   * Called when an admitted request is picked up by a worker, with how long
+   * it waited in queue. The queue times of a window decide how the limit
+   * moves when admit() closes it.
+   */
+  void onDequeue(const timespec &queueStart);
+  void onDequeue(int64 queueUs);
+
+  static int64 Now();
+
+  int getLimit() const { return m_limit;}
+  int64 getRejected() const { return m_rejected;}
+
+private:
+  static const int s_shares[PriorityCount]; // percentage of the limit
+
+  int m_minLimit;
+  int m_maxLimit;
+  int64 m_targetUs;
+  int64 m_windowUs;
+  int m_limit;
+  int64 m_rejected;
+
+  // current window, updated by event loops and workers without locking
+  int64 m_windowStart;
+  int64 m_queueUs;
+  int m_samples;
+  int m_peak;
+
+  Mutex m_mutex; // only one worker closes a window
+
+  void closeWindow(int64 now);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_CONCURRENCY_LIMITER_H__
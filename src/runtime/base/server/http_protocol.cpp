@@ -116,6 +116,7 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
   // $_POST and $_REQUEST
   if (transport->getMethod() == Transport::POST) {
     bool needDelete = false;
+    bool streamed = false;
     int size = 0;
     const void *data = transport->getPostData(size);
     if (data && size) {
@@ -137,6 +138,7 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
         } else {
           if (transport->hasMorePostData()) {
             needDelete = true;
+            streamed = RuntimeOption::StreamRequestBody;
             data = Util::buffer_duplicate(data, size);
           }
           DecodeRfc1867(transport, g->GV(_POST), g->GV(_FILES),
@@ -144,15 +146,17 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
         }
         ASSERT(!transport->getFiles(files));
       } else {
-        needDelete = read_all_post_data(transport, data, size);
-
-        bool decodeData = strncasecmp(contentType.c_str(),
-                                       DEFAULT_POST_CONTENT_TYPE,
-                                       sizeof(DEFAULT_POST_CONTENT_TYPE)-1) == 0;
-        // Always decode data for now. (macvicar)
-        decodeData = true;
+        bool formPost = strncasecmp(contentType.c_str(),
+                                    DEFAULT_POST_CONTENT_TYPE,
+                                    sizeof(DEFAULT_POST_CONTENT_TYPE)-1) == 0;
+        if (RuntimeOption::StreamRequestBody && !formPost &&
+            transport->hasMorePostData()) {
+          // left on the connection for php://input to read
+          streamed = true;
+        } else {
+          needDelete = read_all_post_data(transport, data, size);
 
-        if (decodeData) {
+          // Always decode data for now. (macvicar)
           DecodeParameters(g->GV(_POST), (const char*)data, size, true);
         }
 
@@ -162,7 +166,11 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
         }
       }
       CopyParams(request, g->GV(_POST));
-      if (needDelete) {
+      if (streamed) {
+        // only part of the body was ever held in memory, so there is no
+        // $HTTP_RAW_POST_DATA for it: php://input is the only way to read it
+        if (needDelete) free((void *)data);
+      } else if (needDelete) {
         if (RuntimeOption::AlwaysPopulateRawPostData &&
             size <= (int)StringData::LenMask) {
           g->GV(HTTP_RAW_POST_DATA) = String((char*)data, size, AttachString);
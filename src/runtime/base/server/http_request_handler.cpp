@@ -52,7 +52,9 @@ void HttpRequestHandler::sendStaticContent(Transport *transport,
                                            time_t mtime,
                                            bool compressed,
                                            const std::string &cmd,
-                                           const char *ext) {
+                                           const char *ext,
+                                           bool zeroCopy /* = false */,
+                                           int fd /* = -1 */) {
   ASSERT(ext);
   ASSERT(cmd.rfind('.') != string::npos);
   ASSERT(strcmp(ext, cmd.c_str() + cmd.rfind('.') + 1) == 0);
@@ -105,7 +107,34 @@ void HttpRequestHandler::sendStaticContent(Transport *transport,
   // should not attempt to compress it.
   transport->disableCompression();
 
-  transport->sendRaw((void*)data, len, 200, compressed);
+  if (zeroCopy) {
+    transport->sendStatic(data, len, compressed, fd);
+  } else {
+    transport->sendRaw((void*)data, len, 200, compressed);
+  }
+}
+
+static bool use_zero_copy(int64 len) {
+  return RuntimeOption::StaticContentZeroCopyMinSize > 0 &&
+    len >= RuntimeOption::StaticContentZeroCopyMinSize && len <= INT_MAX;
+}
+
+bool HttpRequestHandler::sendStaticFile(Transport *transport,
+                                        const std::string &file,
+                                        const std::string &cmd,
+                                        const char *ext) {
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      !use_zero_copy(st.st_size)) {
+    close(fd);
+    return false;
+  }
+  sendStaticContent(transport, NULL, st.st_size, st.st_mtime, false, cmd, ext,
+                    true, fd);
+  close(fd);
+  return true;
 }
 
 void HttpRequestHandler::handleRequest(Transport *transport) {
@@ -173,14 +202,18 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
   if (ext && strcasecmp(ext, "php") != 0) {
     if (RuntimeOption::EnableStaticContentCache) {
       bool original = compressed;
+      int encoding = transport->getContentEncoding();
       // check against static content cache
-      if (StaticContentCache::TheCache.find(path, data, len, compressed)) {
+      if (StaticContentCache::TheCache.find(path, data, len, compressed,
+                                            encoding)) {
         String str;
         // (qigao) not calling stat at this point because the timestamp of
         // local cache file is not valuable, maybe misleading. This way
         // the Last-Modified header will not show in response.
         // stat(RuntimeOption::FileCache.c_str(), &st);
-        if (!original && compressed) {
+        if (compressed &&
+            (!original || encoding != transport->getContentEncoding())) {
+          ASSERT(encoding == CODING_GZIP);
           data = gzdecode(data, len);
           if (data == NULL) {
             throw FatalErrorException("cannot unzip compressed data");
@@ -188,7 +221,9 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
           compressed = false;
           str = NEW(StringData)(data, len, AttachString);
         }
-        sendStaticContent(transport, data, len, 0, compressed, path, ext);
+        // cached data lives as long as the process, unless it was unzipped
+        sendStaticContent(transport, data, len, 0, compressed, path, ext,
+                          str.isNull() && use_zero_copy(len));
         StaticContentCache::TheFileCache->adviseOutMemory();
         ServerStats::LogPage(path, 200);
         GetAccessLog().log(transport, vhost);
@@ -198,6 +233,12 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
 
     if (RuntimeOption::EnableStaticContentFromDisk) {
       String translated = File::TranslatePath(String(absPath));
+      if (!translated.empty() &&
+          sendStaticFile(transport, translated.data(), path, ext)) {
+        ServerStats::LogPage(path, 200);
+        GetAccessLog().log(transport, vhost);
+        return;
+      }
       if (!translated.empty()) {
         StringBuffer sb(translated.data());
         if (sb.valid()) {
@@ -218,6 +259,8 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
       // check against dynamic content cache
       ASSERT(transport->getUrl());
       string key = path + transport->getUrl();
+      // only gzipped copies are kept for dynamic content
+      if (transport->getContentEncoding() != CODING_GZIP) compressed = false;
       if (DynamicContentCache::TheCache.find(key, data, len, compressed)) {
         sendStaticContent(transport, data, len, 0, compressed, path, ext);
         ServerStats::LogPage(path, 200);
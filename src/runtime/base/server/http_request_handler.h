@@ -48,7 +48,10 @@ private:
   void sendStaticContent(Transport *transport, const char *data, int len,
                          time_t mtime, bool compressed,
                          const std::string &cmd,
-                         const char *ext);
+                         const char *ext,
+                         bool zeroCopy = false, int fd = -1);
+  bool sendStaticFile(Transport *transport, const std::string &file,
+                      const std::string &cmd, const char *ext);
   bool executePHPRequest(Transport *transport, RequestURI &reqURI,
                          SourceRootInfo &sourceRootInfo,
                          bool cachableDynamicContent);
@@ -34,6 +34,7 @@
 #include <runtime/base/server/replay_transport.h>
 #include <runtime/base/program_functions.h>
 #include <runtime/eval/debugger/debugger.h>
+#include <runtime/eval/runtime/file_repository.h>
 #include <util/db_conn.h>
 #include <util/log_aggregator.h>
 #include <runtime/ext/ext_apc.h>
@@ -61,6 +62,7 @@ HttpServer::HttpServer(void *sslCTX /* = NULL */)
   // enabling mutex profiling, but it's not turned on
   LockProfiler::s_pfunc_profile = server_stats_log_mutex;
 
+  LibEventServer *pageServer;
   if (RuntimeOption::ServerPortFd != -1 || RuntimeOption::SSLPortFd != -1) {
     LibEventServerWithFd* server =
       (new TypedServer<LibEventServerWithFd, HttpRequestHandler>
@@ -69,9 +71,9 @@ HttpServer::HttpServer(void *sslCTX /* = NULL */)
         RuntimeOption::RequestTimeoutSeconds));
     server->setServerSocketFd(RuntimeOption::ServerPortFd);
     server->setSSLSocketFd(RuntimeOption::SSLPortFd);
-    m_pageServer = ServerPtr(server);
+    pageServer = server;
   } else if (RuntimeOption::TakeoverFilename.empty()) {
-    m_pageServer = ServerPtr
+    pageServer =
       (new TypedServer<LibEventServer, HttpRequestHandler>
        (RuntimeOption::ServerIP, RuntimeOption::ServerPort,
         RuntimeOption::ServerThreadCount,
@@ -84,8 +86,21 @@ HttpServer::HttpServer(void *sslCTX /* = NULL */)
         RuntimeOption::RequestTimeoutSeconds));
     server->setTransferFilename(RuntimeOption::TakeoverFilename);
     server->addTakeoverListener(this);
-    m_pageServer = ServerPtr(server);
+    pageServer = server;
   }
+  pageServer->setEventLoopCount(RuntimeOption::ServerEventLoopCount);
+  if (SharedWorkerPool::Enabled()) {
+    pageServer->useSharedWorkerPool();
+  }
+  if (RuntimeOption::ConcurrencyLimitEnabled) {
+    m_concurrencyLimiter = ConcurrencyLimiterPtr
+      (new ConcurrencyLimiter(RuntimeOption::ConcurrencyLimitMin,
+                              RuntimeOption::ConcurrencyLimitMax,
+                              RuntimeOption::ConcurrencyLimitQueueTimeTarget,
+                              RuntimeOption::ConcurrencyLimitWindow));
+    pageServer->setConcurrencyLimiter(m_concurrencyLimiter);
+  }
+  m_pageServer = ServerPtr(pageServer);
 
   if (RuntimeOption::EnableSSL && m_sslCTX) {
     SSLInit::Init();
@@ -223,6 +238,9 @@ void HttpServer::run() {
     m_serviceThreads[i]->waitForStarted();
   }
 
+  // runs in the background while servers start and take requests
+  Eval::FileRepository::StartPreparse();
+
   if (RuntimeOption::ServerPort) {
     if (!startServer(true)) {
       Logger::Error("Unable to start page server");
@@ -48,12 +48,16 @@ public:
   void takeoverShutdown(LibEventServerWithTakeover* server);
 
   ServerPtr getPageServer() { return m_pageServer;}
+  ConcurrencyLimiterPtr getConcurrencyLimiter() {
+    return m_concurrencyLimiter;
+  }
 
 private:
   bool m_stopped;
   void *m_sslCTX;
 
   ServerPtr m_pageServer;
+  ConcurrencyLimiterPtr m_concurrencyLimiter;
   ServerPtr m_adminServer;
   SatelliteServerPtrVec m_satellites;
   SatelliteServerPtrVec m_danglings;
@@ -0,0 +1,170 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#include <runtime/base/server/libevent_connection_manager.h>
+#include <runtime/base/runtime_option.h>
+
+using namespace std;
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+static void on_connection_close(evhttp_connection *conn, void *obj) {
+  ASSERT(obj);
+  ((LibEventConnectionManager*)obj)->onClose(conn);
+}
+
+static void on_connection_tick(int fd, short what, void *obj) {
+  ASSERT(obj);
+  ((LibEventConnectionManager*)obj)->onTick();
+}
+
+// requests per connection up to 2^15 and more
+static const int kRequestBuckets = 16;
+
+LibEventConnectionManager::LibEventConnectionManager()
+  : m_ticking(false), m_idleMax(0), m_open(0), m_idleCount(0), m_opened(0),
+    m_closed(0), m_reused(0), m_evicted(0), m_timedOut(0),
+    m_requestsPerConn(kRequestBuckets) {
+}
+
+void LibEventConnectionManager::create(event_base *eventBase,
+                                       int loopCount) {
+  m_idleMax = (RuntimeOption::KeepAliveIdleMax + loopCount - 1) / loopCount;
+  if (m_idleMax > 0 || RuntimeOption::KeepAliveIdleTimeoutSeconds > 0) {
+    evtimer_set(&m_tick, on_connection_tick, this);
+    event_base_set(eventBase, &m_tick);
+    struct timeval tv = { 1, 0 };
+    evtimer_add(&m_tick, &tv);
+    m_ticking = true;
+  }
+}
+
+void LibEventConnectionManager::close() {
+  if (m_ticking) {
+    evtimer_del(&m_tick);
+    m_ticking = false;
+  }
+}
+
+int LibEventConnectionManager::onRequest(evhttp_connection *conn) {
+  ConnectionMap::iterator iter = m_conns.find(conn);
+  if (iter == m_conns.end()) {
+    iter = m_conns.insert(ConnectionMap::value_type(conn, Connection())).first;
+    evhttp_connection_set_closecb(conn, on_connection_close, this);
+    m_open++;
+    m_opened++;
+  } else {
+    m_reused++;
+  }
+  Connection &c = iter->second;
+  setIdle(c, conn, false);
+  return ++c.requests;
+}
+
+void LibEventConnectionManager::onResponseSent(evhttp_connection *conn) {
+  // the connection may have been closed while the request was handled
+  ConnectionMap::iterator iter = m_conns.find(conn);
+  if (iter == m_conns.end()) return;
+  setIdle(iter->second, conn, true);
+}
+
+void LibEventConnectionManager::onClose(evhttp_connection *conn) {
+  ConnectionMap::iterator iter = m_conns.find(conn);
+  if (iter == m_conns.end()) return;
+  Connection &c = iter->second;
+  setIdle(c, conn, false);
+
+  int bucket = 0;
+  for (int n = c.requests; n > 1 && bucket < kRequestBuckets - 1; n >>= 1) {
+    bucket++;
+  }
+  m_requestsPerConn[bucket]++;
+  m_conns.erase(iter);
+  m_open--;
+  m_closed++;
+}
+
+void LibEventConnectionManager::onTick() {
+  closeIdle(time(NULL));
+  struct timeval tv = { 1, 0 };
+  evtimer_add(&m_tick, &tv);
+}
+
+void LibEventConnectionManager::setIdle(Connection &c,
+                                        evhttp_connection *conn, bool idle) {
+  if (c.idle == idle) return;
+  c.idle = idle;
+  if (idle) {
+    c.idleSince = time(NULL);
+    c.idleIter = m_idle.insert(m_idle.end(), conn);
+    m_idleCount++;
+  } else {
+    m_idle.erase(c.idleIter);
+    m_idleCount--;
+  }
+}
+
+void LibEventConnectionManager::closeIdle(time_t now) {
+  int timeout = RuntimeOption::KeepAliveIdleTimeoutSeconds;
+  while (!m_idle.empty()) {
+    evhttp_connection *conn = m_idle.front();
+    Connection &c = m_conns[conn];
+    bool timedOut = timeout > 0 && now - c.idleSince >= timeout;
+    if (!timedOut && (m_idleMax <= 0 || m_idleCount <= m_idleMax ||
+                      now <= c.idleSince)) {
+      break;
+    }
+    if (getPendingOutput(conn) > 0) {
+      // its last response is still on its way out to a slow client, so it
+      // only goes idle once that's done; check again on a later tick
+      setIdle(c, conn, false);
+      setIdle(c, conn, true);
+      c.idleSince = now;
+      continue;
+    }
+    if (timedOut) {
+      m_timedOut++;
+    } else {
+      m_evicted++;
+    }
+    // forget it first, so the close callback finds nothing left to do
+    onClose(conn);
+    evhttp_connection_free(conn);
+  }
+}
+
+int LibEventConnectionManager::getPendingOutput(evhttp_connection *conn) {
+  return evhttp_connection_get_output_length(conn);
+}
+
+void LibEventConnectionManager::getStats(ServerConnectionStats &stats) {
+  stats.open += m_open;
+  stats.idle += m_idleCount;
+  stats.opened += m_opened;
+  stats.closed += m_closed;
+  stats.reused += m_reused;
+  stats.evicted += m_evicted;
+  stats.timedOut += m_timedOut;
+  stats.requestsPerConnection.resize(kRequestBuckets);
+  for (int i = 0; i < kRequestBuckets; i++) {
+    stats.requestsPerConnection[i] += m_requestsPerConn[i];
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,115 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#ifndef __HTTP_SERVER_LIB_EVENT_CONNECTION_MANAGER_H__
+#define __HTTP_SERVER_LIB_EVENT_CONNECTION_MANAGER_H__
+
+#include <runtime/base/server/server.h>
+#include <evhttp.h>
+#include <list>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Keeps track of the client connections of one event loop, so keep-alive
+ * reuse can be measured and idle connections capped. A connection is idle
+ * from the time its last response was handed to libevent until its next
+ * request comes in. Idle connections are kept in the order they went idle,
+ * and with one timeout for all of them, that list doubles as the timeout
+ * wheel: a once-a-second tick closes them from the front. One whose response
+ * is still being written out when its turn comes is not closed but goes to
+ * the back of the list again.
+ *
+ * Pipelined requests need no queueing here, since evhttp does not read the
+ * next request of a connection before the current one was answered.
+ *
+ * Everything but getStats() runs on the loop's thread.
+ */
+class LibEventConnectionManager {
+public:
+  LibEventConnectionManager();
+  virtual ~LibEventConnectionManager() {}
+
+  /**
+   * Starts the tick on the loop's event base, if there is any idle limit.
+   * Each of "loopCount" loops gets an even share of KeepAliveIdleMax.
+   */
+  void create(event_base *eventBase, int loopCount);
+  void close();
+
+  /**
+   * Returns how many requests the connection has received so far, including
+   * this one.
+   */
+  int onRequest(evhttp_connection *conn);
+  void onResponseSent(evhttp_connection *conn);
+  void onClose(evhttp_connection *conn);
+  void onTick();
+
+  /**
+   * What a tick does: closes connections idle for KeepAliveIdleTimeoutSeconds
+   * as of "now", and the oldest ones beyond this loop's idle limit.
+   */
+  void closeIdle(time_t now);
+
+  /**
+   * Adds this loop's counters to "stats".
+   */
+  void getStats(ServerConnectionStats &stats);
+
+protected:
+  /**
+   * Bytes of the connection's last response not yet written to the socket.
+   */
+  virtual int getPendingOutput(evhttp_connection *conn);
+
+private:
+  struct Connection {
+    Connection() : requests(0), idle(false), idleSince(0) {}
+
+    int requests;
+    bool idle;
+    time_t idleSince;
+    std::list<evhttp_connection*>::iterator idleIter;
+  };
+  typedef hphp_hash_map<evhttp_connection*, Connection,
+                        pointer_hash<evhttp_connection> > ConnectionMap;
+
+  ConnectionMap m_conns;
+  std::list<evhttp_connection*> m_idle; // oldest idle first
+  event m_tick;
+  bool m_ticking;
+  int m_idleMax;
+
+  // only written by the loop's thread, getStats() may read them a bit late
+  int m_open;
+  int m_idleCount;
+  int64 m_opened;
+  int64 m_closed;
+  int64 m_reused;
+  int64 m_evicted;
+  int64 m_timedOut;
+  std::vector<int64> m_requestsPerConn; // log2 buckets, filled on close
+
+  void setIdle(Connection &c, evhttp_connection *conn, bool idle);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HTTP_SERVER_LIB_EVENT_CONNECTION_MANAGER_H__
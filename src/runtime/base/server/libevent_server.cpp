@@ -19,8 +19,11 @@
 #include <runtime/base/memory/memory_manager.h>
 #include <runtime/base/server/server_stats.h>
 #include <runtime/base/server/http_protocol.h>
+#include <runtime/base/server/virtual_host.h>
+#include <runtime/base/server/response_compressor.h>
 #include <util/compatibility.h>
 #include <util/logger.h>
+#include <util/util.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // static handler
@@ -30,6 +33,17 @@ static void on_request(struct evhttp_request *request, void *obj) {
   ((HPHP::LibEventServer*)obj)->onRequest(request);
 }
 
+static void on_loop_request(struct evhttp_request *request, void *obj) {
+  ASSERT(obj);
+  HPHP::LibEventLoop *loop = (HPHP::LibEventLoop*)obj;
+  loop->getServer()->onRequest(request, loop->getId());
+}
+
+static void on_loop_control(int fd, short events, void *obj) {
+  ASSERT(obj);
+  ((HPHP::LibEventLoop*)obj)->onControl();
+}
+
 static void on_response(int fd, short what, void *obj) {
   ASSERT(obj);
   ((HPHP::PendingResponseQueue*)obj)->process();
@@ -43,11 +57,29 @@ static void on_thread_stop(int fd, short events, void *context) {
   event_base_loopbreak((struct event_base *)context);
 }
 
+static void dispatch_with_timeout(struct event_base *eventBase,
+                                  int timeoutSeconds) {
+  struct timeval timeout;
+  timeout.tv_sec = timeoutSeconds;
+  timeout.tv_usec = 0;
+
+  event eventTimeout;
+  event_set(&eventTimeout, -1, 0, on_timer, eventBase);
+  event_base_set(eventBase, &eventTimeout);
+  event_add(&eventTimeout, &timeout);
+
+  event_base_loop(eventBase, EVLOOP_ONCE);
+
+  event_del(&eventTimeout);
+}
+
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 // LibEventJob
 
-LibEventJob::LibEventJob(evhttp_request *req) : request(req) {
+LibEventJob::LibEventJob(evhttp_request *req, int loop /* = 0 */,
+                         int connRequests /* = 1 */)
+  : request(req), loop(loop), connRequests(connRequests) {
   gettime(CLOCK_MONOTONIC, &start);
 }
 
@@ -85,13 +117,14 @@ void LibEventWorker::doJob(LibEventJobPtr job) {
   evhttp_request *request = job->request;
   ASSERT(m_opaque);
   LibEventServer *server = (LibEventServer*)m_opaque;
+  server->onJobStart(*job);
 
   if (m_handler == NULL || server->supportReset()) {
     m_handler = server->createRequestHandler();
     ASSERT(m_handler);
   }
 
-  LibEventTransport transport(server, request, m_id);
+  LibEventTransport transport(server, request, m_id, job->loop);
 #ifdef _EVENT_USE_OPENSSL
   if (evhttp_is_connection_ssl(job->request->evcon)) {
     transport.setSSL();
@@ -100,6 +133,7 @@ void LibEventWorker::doJob(LibEventJobPtr job) {
   bool error = true;
   std::string errorMsg;
   try {
+    server->onDequeue(*job);
     std::string cmd = transport.getCommand();
     cmd = std::string("/") + cmd;
     if (server->shouldHandle(cmd)) {
@@ -144,6 +178,25 @@ void LibEventWorker::onThreadExit() {
   MemoryManager::TheMemoryManager().getNoCheck()->cleanup();
 }
 
+void LibEventWorker::attach(LibEventServer *server, int id) {
+  m_opaque = server;
+  m_id = id;
+}
+
+RequestHandler *LibEventWorker::releaseHandler() {
+  RequestHandler *handler = m_handler;
+  m_handler = NULL;
+  return handler;
+}
+
+void LibEventPoolJob::run(int worker) {
+  m_server->getPoolWorker(worker)->doJob(m_job);
+}
+
+void LibEventPoolExitJob::run(int worker) {
+  m_server->onThreadExit(m_server->getPoolWorker(worker)->releaseHandler());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // constructor and destructor
 
@@ -157,8 +210,16 @@ LibEventServer::LibEventServer(const std::string &address, int port,
     m_dispatcher(thread, RuntimeOption::ServerThreadRoundRobin,
                  RuntimeOption::ServerThreadDropCacheTimeoutSeconds,
                  RuntimeOption::ServerThreadDropStack,
-                 this, RuntimeOption::ServerThreadJobLIFO),
-    m_dispatcherThread(this, &LibEventServer::dispatch) {
+                 this, RuntimeOption::ServerThreadJobLIFO,
+                 RuntimeOption::ServerThreadJobStealing),
+    m_dispatcherThread(this, &LibEventServer::dispatch),
+    m_sharedPool(false),
+    m_compressionDispatcher(NULL) {
+  if (RuntimeOption::GzipCompressionOffloadThreshold > 0) {
+    m_compressionDispatcher = new JobQueueDispatcher
+      <LibEventCompressionJob*, LibEventCompressionWorker>
+      (RuntimeOption::GzipCompressionThreadCount, false, 0, false, NULL);
+  }
   m_eventBase = event_base_new();
   m_server = evhttp_new(m_eventBase);
   m_server_ssl = NULL;
@@ -167,7 +228,7 @@ LibEventServer::LibEventServer(const std::string &address, int port,
 #ifdef EVHTTP_PORTABLE_READ_LIMITING
   evhttp_set_read_limit(m_server, RuntimeOption::RequestBodyReadLimit);
 #endif
-  m_responseQueue.create(m_eventBase);
+  m_responseQueue.create(m_eventBase, &m_connections);
 }
 
 LibEventServer::~LibEventServer() {
@@ -179,11 +240,39 @@ LibEventServer::~LibEventServer() {
   if (getStatus() != STOPPING) {
     event_base_free(m_eventBase);
   }
+  delete m_compressionDispatcher;
+  for (unsigned int i = 0; i < m_poolWorkers.size(); i++) {
+    delete m_poolWorkers[i];
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // implementing HttpServer
 
+void LibEventServer::setEventLoopCount(int count) {
+  ASSERT(getStatus() == NOT_YET_STARTED && m_loops.empty());
+  if (count <= 1) return;
+  for (int i = 0; i < count; i++) {
+    std::string name;
+    Util::string_printf(name, "page.loop.%d.requests", i);
+    m_loopStats.push_back(name);
+    if (i > 0) {
+      m_loops.push_back(LibEventLoopPtr(new LibEventLoop(this, i)));
+    }
+  }
+}
+
+void LibEventServer::useSharedWorkerPool() {
+  ASSERT(getStatus() == NOT_YET_STARTED && m_poolWorkers.empty());
+  ASSERT(SharedWorkerPool::Enabled());
+  m_sharedPool = true;
+  for (int i = 0; i < SharedWorkerPool::GetThreadCount(); i++) {
+    LibEventWorker *worker = new LibEventWorker();
+    worker->attach(this, i);
+    m_poolWorkers.push_back(worker);
+  }
+}
+
 int LibEventServer::getAcceptSocket() {
   int ret;
   const char *address = m_address.empty() ? NULL : m_address.c_str();
@@ -216,31 +305,37 @@ void LibEventServer::start() {
   }
 
   setStatus(RUNNING);
-  m_dispatcher.start();
+  m_connections.create(m_eventBase, getEventLoopCount());
+  if (!m_sharedPool) {
+    m_dispatcher.start();
+  }
+  if (m_compressionDispatcher) {
+    m_compressionDispatcher->start();
+  }
   m_dispatcherThread.start();
-  m_timeoutThread.start();
+  for (unsigned int i = 0; i < m_loops.size(); i++) {
+    if (!m_loops[i]->start(m_accept_sock)) {
+      Logger::Error("Event loop %d failed to accept on port %d",
+                    m_loops[i]->getId(), m_port);
+    }
+  }
+  if (!m_sharedPool) {
+    m_timeoutThread.start();
+  }
 }
 
 void LibEventServer::waitForEnd() {
   m_dispatcherThread.waitForEnd();
+  for (unsigned int i = 0; i < m_loops.size(); i++) {
+    m_loops[i]->waitForEnd();
+  }
 
   m_timeoutThreadData.stop();
   m_timeoutThread.waitForEnd();
 }
 
 void LibEventServer::dispatchWithTimeout(int timeoutSeconds) {
-  struct timeval timeout;
-  timeout.tv_sec = timeoutSeconds;
-  timeout.tv_usec = 0;
-
-  event eventTimeout;
-  event_set(&eventTimeout, -1, 0, on_timer, m_eventBase);
-  event_base_set(m_eventBase, &eventTimeout);
-  event_add(&eventTimeout, &timeout);
-
-  event_base_loop(m_eventBase, EVLOOP_ONCE);
-
-  event_del(&eventTimeout);
+  dispatch_with_timeout(m_eventBase, timeoutSeconds);
 }
 
 void LibEventServer::dispatch() {
@@ -261,6 +356,7 @@ void LibEventServer::dispatch() {
     m_responseQueue.process();
   }
   m_responseQueue.close();
+  m_connections.close();
 
   // flusing all remaining events
   if (RuntimeOption::ServerGracefulShutdownWait) {
@@ -276,7 +372,20 @@ void LibEventServer::stop() {
   setStatus(STOPPING);
 
   // stop JobQueue processing
-  m_dispatcher.stop();
+  if (m_sharedPool) {
+    // pool threads keep running, only our requests have to be done
+    SharedWorkerPool::WaitIdle(SharedWorkerPool::PageJob);
+    std::vector<SharedWorkerJob*> jobs;
+    for (unsigned int i = 0; i < m_poolWorkers.size(); i++) {
+      jobs.push_back(new LibEventPoolExitJob(this));
+    }
+    SharedWorkerPool::RunOnEachThread(jobs);
+  } else {
+    m_dispatcher.stop();
+  }
+  if (m_compressionDispatcher) {
+    m_compressionDispatcher->stop();
+  }
 
   // stop event loop
   setStatus(STOPPED);
@@ -284,10 +393,19 @@ void LibEventServer::stop() {
     // an error occured but we're in shutdown already, so ignore
   }
   m_dispatcherThread.waitForEnd();
+  for (unsigned int i = 0; i < m_loops.size(); i++) {
+    m_loops[i]->stop();
+  }
   evhttp_free(m_server);
   m_server = NULL;
 }
 
+void LibEventServer::dropAcceptSocket() {
+  for (unsigned int i = 0; i < m_loops.size(); i++) {
+    m_loops[i]->dropAcceptSocket();
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // SSL handling
 
@@ -326,11 +444,14 @@ int LibEventServer::getAcceptSocketSSL() {
 // request/response handling
 
 void LibEventServer::onThreadEnter() {
+  // pool threads are registered with the pool's own timeout thread
+  if (m_sharedPool) return;
   m_timeoutThreadData.registerRequestThread
     (&ThreadInfo::s_threadInfo->m_reqInjectionData);
 }
 
-void LibEventServer::onRequest(struct evhttp_request *request) {
+void LibEventServer::onRequest(struct evhttp_request *request,
+                               int loop /* = 0 */) {
   if (RuntimeOption::EnableKeepAlive &&
       RuntimeOption::ConnectionTimeoutSeconds > 0) {
     // before processing request, set the connection timeout
@@ -339,13 +460,75 @@ void LibEventServer::onRequest(struct evhttp_request *request) {
                                   RuntimeOption::ConnectionTimeoutSeconds);
   }
   if (getStatus() == RUNNING) {
-    m_dispatcher.enqueue(LibEventJobPtr(new LibEventJob(request)));
+    int connRequests = getConnections(loop).onRequest(request->evcon);
+    if (!admitRequest(request, loop)) return;
+    LibEventJobPtr job(new LibEventJob(request, loop, connRequests));
+    if (m_sharedPool) {
+      SharedWorkerPool::Enqueue(SharedWorkerPool::PageJob,
+                                new LibEventPoolJob(this, job));
+    } else {
+      m_dispatcher.enqueue(job);
+    }
   } else {
     Logger::Error("throwing away one new request while shutting down");
   }
 }
 
-void LibEventServer::onResponse(int worker, evhttp_request *request,
+/**
+ * Runs on the event loop before the request is queued, so a rejected request
+ * never waits for a worker. This is why the virtual host is matched here
+ * instead of through HttpProtocol::GetVirtualHost(), which needs a request
+ * thread.
+ */
+bool LibEventServer::admitRequest(evhttp_request *request, int loop) {
+  if (!m_limiter) return true;
+  int priority = VirtualHost::GetDefault().getConcurrencyPriority();
+  const char *host = evhttp_find_header(request->input_headers, "Host");
+  if (host) {
+    std::string hostName(host);
+    for (unsigned int i = 0; i < RuntimeOption::VirtualHosts.size(); i++) {
+      VirtualHostPtr vhost = RuntimeOption::VirtualHosts[i];
+      if (vhost->match(hostName)) {
+        priority = vhost->getConcurrencyPriority();
+        break;
+      }
+    }
+  }
+  int inFlight = getActiveWorker() + getQueuedJobs() + 1;
+  if (m_limiter->admit(priority, inFlight)) {
+    return true;
+  }
+  ServerStats::Log("page.concurrency.rejected", 1);
+  char buf[11];
+  snprintf(buf, sizeof(buf), "%d", RuntimeOption::ConcurrencyLimitRetryAfter);
+  evhttp_add_header(request->output_headers, "Retry-After", buf);
+  evbuffer_add(request->output_buffer, "Service Unavailable", 19);
+  evhttp_connection *conn = request->evcon;
+  evhttp_send_reply(request, 503, HttpProtocol::GetReasonString(503), NULL);
+  getConnections(loop).onResponseSent(conn);
+  return false;
+}
+
+void LibEventServer::onDequeue(const LibEventJob &job) {
+  if (m_limiter) m_limiter->onDequeue(job.getStartTimer());
+}
+
+void LibEventServer::onJobStart(const LibEventJob &job) {
+  if (!m_loopStats.empty()) {
+    ServerStats::Log(m_loopStats[job.loop], 1);
+  }
+  ServerStats::Log(job.connRequests > 1 ? "page.conn.reused" :
+                   "page.conn.opened", 1);
+}
+
+void LibEventServer::getConnectionStats(ServerConnectionStats &stats) {
+  m_connections.getStats(stats);
+  for (unsigned int i = 0; i < m_loops.size(); i++) {
+    m_loops[i]->getConnections().getStats(stats);
+  }
+}
+
+void LibEventServer::onResponse(int worker, int loop, evhttp_request *request,
                                 int code, LibEventTransport *transport) {
   int nwritten = 0;
   bool skip_sync = false;
@@ -355,6 +538,14 @@ void LibEventServer::onResponse(int worker, evhttp_request *request,
 
   int totalSize = 0;
 
+  if (transport->isCompressionOffloaded()) {
+    ASSERT(m_compressionDispatcher);
+    m_compressionDispatcher->enqueue
+      (new LibEventCompressionJob(this, worker, loop, request, code,
+                                  transport->getContentEncoding()));
+    return;
+  }
+
   if (RuntimeOption::LibEventSyncSend && !skip_sync) {
     const char *reason = HttpProtocol::GetReasonString(code);
     timespec begin, end;
@@ -369,24 +560,201 @@ void LibEventServer::onResponse(int worker, evhttp_request *request,
     transport->onFlushBegin(totalSize);
     transport->onFlushProgress(nwritten, delay);
   }
-  m_responseQueue.enqueue(worker, request, code, nwritten);
+  getResponseQueue(loop).enqueue(worker, request, code, nwritten);
 }
 
-void LibEventServer::onChunkedResponse(int worker, evhttp_request *request,
-                                       int code, evbuffer *chunk,
-                                       bool firstChunk) {
-  m_responseQueue.enqueue(worker, request, code, chunk, firstChunk);
+void LibEventServer::onChunkedResponse(int worker, int loop,
+                                       evhttp_request *request, int code,
+                                       evbuffer *chunk, bool firstChunk) {
+  getResponseQueue(loop).enqueue(worker, request, code, chunk, firstChunk);
 }
 
-void LibEventServer::onChunkedResponseEnd(int worker,
+void LibEventServer::onChunkedResponseEnd(int worker, int loop,
                                           evhttp_request *request) {
-  m_responseQueue.enqueue(worker, request);
+  getResponseQueue(loop).enqueue(worker, request);
+}
+
+void LibEventServer::onCompressedResponse(int worker, int loop,
+                                          evhttp_request *request, int code) {
+  getResponseQueue(loop).enqueue(worker, request, code, 0);
+}
+
+/**
+ * Copies a file into an output buffer, stopping short if it shrank.
+ */
+static void add_file(evbuffer *buf, int fd, int size) {
+  char chunk[16384];
+  off_t offset = 0;
+  while (offset < size) {
+    int len = size - offset;
+    if (len > (int)sizeof(chunk)) len = sizeof(chunk);
+    ssize_t n = pread(fd, chunk, len, offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    evbuffer_add(buf, chunk, n);
+    offset += n;
+  }
+}
+
+void LibEventServer::onDirectResponse(int worker, int loop,
+                                      evhttp_request *request, int code,
+                                      LibEventTransport *transport,
+                                      const char *data, int size, int fd) {
+  bool skip_sync = !RuntimeOption::LibEventSyncSend;
+#ifdef _EVENT_USE_OPENSSL
+  skip_sync = skip_sync || evhttp_is_connection_ssl(request->evcon);
+#endif
+  if (skip_sync) {
+    if (fd >= 0) {
+      add_file(request->output_buffer, fd, size);
+    } else {
+      evbuffer_add(request->output_buffer, data, size);
+    }
+    onResponse(worker, loop, request, code, transport);
+    return;
+  }
+
+  const char *reason = HttpProtocol::GetReasonString(code);
+  timespec begin, end;
+  gettime(CLOCK_MONOTONIC, &begin);
+  int nwritten = evhttp_send_reply_sync_direct(request, code, reason, data,
+                                               size, fd);
+  gettime(CLOCK_MONOTONIC, &end);
+  int64 delay = gettime_diff_us(begin, end);
+  transport->onFlushBegin(size);
+  transport->onFlushProgress(nwritten, delay);
+  getResponseQueue(loop).enqueue(worker, request, code, nwritten);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LibEventCompressionWorker
+
+void LibEventCompressionWorker::doJob(LibEventCompressionJob *job) {
+  evbuffer *buf = job->request->output_buffer;
+  int len = EVBUFFER_LENGTH(buf);
+  char *compressed =
+    ResponseCompressor::Compress((const char *)EVBUFFER_DATA(buf), len,
+                                 job->encoding);
+  if (compressed) {
+    evbuffer_drain(buf, EVBUFFER_LENGTH(buf));
+    evbuffer_add(buf, compressed, len);
+    free(compressed);
+  } else {
+    // send it as is, without claiming it's compressed
+    Logger::Error("Unable to compress response: encoding=%s level=%d len=%d",
+                  get_encoding_name(job->encoding),
+                  ResponseCompressor::GetLevel(job->encoding), len);
+    evhttp_remove_header(job->request->output_headers, "Content-Encoding");
+  }
+  job->server->onCompressedResponse(job->worker, job->loop, job->request,
+                                    job->code);
+  delete job;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LibEventLoop
+
+LibEventLoop::LibEventLoop(LibEventServer *server, int id)
+  : m_server(server), m_id(id), m_acceptSock(-1),
+    m_thread(this, &LibEventLoop::dispatch) {
+  m_eventBase = event_base_new();
+  m_http = evhttp_new(m_eventBase);
+  evhttp_set_connection_limit(m_http, RuntimeOption::ServerConnectionLimit);
+  evhttp_set_gencb(m_http, on_loop_request, this);
+#ifdef EVHTTP_PORTABLE_READ_LIMITING
+  evhttp_set_read_limit(m_http, RuntimeOption::RequestBodyReadLimit);
+#endif
+  m_responseQueue.create(m_eventBase, &m_connections);
+
+  if (!m_pipeControl.open()) {
+    throw FatalErrorException("unable to create pipe for event loop");
+  }
+  event_set(&m_eventControl, m_pipeControl.getOut(), EV_READ|EV_PERSIST,
+            on_loop_control, this);
+  event_base_set(m_eventBase, &m_eventControl);
+  event_add(&m_eventControl, NULL);
+}
+
+LibEventLoop::~LibEventLoop() {
+  // same as LibEventServer, the event base is leaked if the loop may still
+  // be running on it
+  if (m_http == NULL) {
+    event_base_free(m_eventBase);
+  }
+}
+
+bool LibEventLoop::start(int acceptSock) {
+  if (acceptSock < 0 || evhttp_accept_socket(m_http, acceptSock) < 0) {
+    return false;
+  }
+  m_acceptSock = acceptSock;
+  m_connections.create(m_eventBase, m_server->getEventLoopCount());
+  m_thread.start();
+  return true;
+}
+
+void LibEventLoop::waitForEnd() {
+  m_thread.waitForEnd();
+}
+
+void LibEventLoop::stop() {
+  if (m_http == NULL) return;
+  if (write(m_pipeControl.getIn(), "s", 1) < 0) {
+    // an error occured but we're in shutdown already, so ignore
+  }
+  m_thread.waitForEnd();
+  if (m_http) {
+    evhttp_free(m_http);
+    m_http = NULL;
+  }
+}
+
+void LibEventLoop::dropAcceptSocket() {
+  if (write(m_pipeControl.getIn(), "d", 1) < 0) {
+    Logger::Error("Unable to signal event loop %d", m_id);
+  }
+}
+
+void LibEventLoop::onControl() {
+  char buf[16];
+  int n = read(m_pipeControl.getOut(), buf, sizeof(buf));
+  for (int i = 0; i < n; i++) {
+    if (buf[i] == 'd' && m_acceptSock >= 0) {
+      if (evhttp_del_accept_socket(m_http, m_acceptSock) < 0) {
+        Logger::Error("Unable to delete accept socket from event loop %d",
+                      m_id);
+      }
+      m_acceptSock = -1;
+    }
+  }
+  event_base_loopbreak(m_eventBase);
+}
+
+void LibEventLoop::dispatch() {
+  while (m_server->getStatus() != Server::STOPPED) {
+    event_base_loop(m_eventBase, EVLOOP_ONCE);
+  }
+
+  event_del(&m_eventControl);
+
+  // flushing all responses
+  if (!m_responseQueue.empty()) {
+    m_responseQueue.process();
+  }
+  m_responseQueue.close();
+  m_connections.close();
+
+  // flusing all remaining events
+  if (RuntimeOption::ServerGracefulShutdownWait) {
+    dispatch_with_timeout(m_eventBase,
+                          RuntimeOption::ServerGracefulShutdownWait);
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // PendingResponseQueue
 
-PendingResponseQueue::PendingResponseQueue() {
+PendingResponseQueue::PendingResponseQueue() : m_connections(NULL) {
   ASSERT(RuntimeOption::ResponseQueueCount > 0);
   for (int i = 0; i < RuntimeOption::ResponseQueueCount; i++) {
     m_responseQueues.push_back(ResponseQueuePtr(new ResponseQueue()));
@@ -402,7 +770,9 @@ bool PendingResponseQueue::empty() {
   return true;
 }
 
-void PendingResponseQueue::create(event_base *eventBase) {
+void PendingResponseQueue::create(event_base *eventBase,
+                                  LibEventConnectionManager *connections) {
+  m_connections = connections;
   if (!m_ready.open()) {
     throw FatalErrorException("unable to create pipe for ready signal");
   }
@@ -478,6 +848,8 @@ void PendingResponseQueue::process() {
     Response &res = *responses[i];
     evhttp_request *request = res.request;
     int code = res.code;
+    // request may be gone once its response is sent
+    evhttp_connection *conn = request->evcon;
 
     bool skip_sync = false;
 #ifdef _EVENT_USE_OPENSSL
@@ -493,12 +865,16 @@ void PendingResponseQueue::process() {
         evhttp_send_reply_chunk(request, res.chunk);
       } else {
         evhttp_send_reply_end(request);
+        if (m_connections) m_connections->onResponseSent(conn);
       }
-    } else if (RuntimeOption::LibEventSyncSend && !skip_sync) {
-      evhttp_send_reply_sync_end(res.nwritten, request);
     } else {
-      const char *reason = HttpProtocol::GetReasonString(code);
-      evhttp_send_reply(request, code, reason, NULL);
+      if (RuntimeOption::LibEventSyncSend && !skip_sync) {
+        evhttp_send_reply_sync_end(res.nwritten, request);
+      } else {
+        const char *reason = HttpProtocol::GetReasonString(code);
+        evhttp_send_reply(request, code, reason, NULL);
+      }
+      if (m_connections) m_connections->onResponseSent(conn);
     }
   }
 }
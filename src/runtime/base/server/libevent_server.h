@@ -18,7 +18,10 @@
 #define __HTTP_SERVER_LIB_EVENT_SERVER_H__
 
 #include <runtime/base/server/server.h>
+#include <runtime/base/server/concurrency_limiter.h>
+#include <runtime/base/server/libevent_connection_manager.h>
 #include <runtime/base/server/libevent_transport.h>
+#include <runtime/base/server/shared_worker_pool.h>
 #include <runtime/base/timeout_thread.h>
 #include <util/job_queue.h>
 #include <util/process.h>
@@ -26,6 +29,8 @@
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+class LibEventServer;
+
 /**
  * Wrapping evhttp_request to keep track of queuing time: from onRequest() to
  * doJob().
@@ -33,12 +38,14 @@ namespace HPHP {
 DECLARE_BOOST_TYPES(LibEventJob);
 class LibEventJob {
 public:
-  LibEventJob(evhttp_request *req);
+  LibEventJob(evhttp_request *req, int loop = 0, int connRequests = 1);
 
   const timespec &getStartTimer() const { return start;}
   void stopTimer();
 
   evhttp_request *request;
+  int loop; // which event loop received the request
+  int connRequests; // requests so far on its connection, including this one
 
 private:
   timespec start;
@@ -65,10 +72,73 @@ public:
   virtual void onThreadEnter();
   virtual void onThreadExit();
 
+  /**
+   * For workers run by SharedWorkerPool threads instead of a dispatcher.
+   * Their threads outlive the server, so when it stops, the server has each
+   * of them release its handler with a LibEventPoolExitJob.
+   */
+  void attach(LibEventServer *server, int id);
+  RequestHandler *releaseHandler();
+
 private:
   RequestHandler *m_handler;
 };
 
+/**
+ * A request handed to SharedWorkerPool, run by the LibEventWorker the server
+ * keeps for that pool thread.
+ */
+class LibEventPoolJob : public SharedWorkerJob {
+public:
+  LibEventPoolJob(LibEventServer *server, LibEventJobPtr job)
+    : m_server(server), m_job(job) {}
+
+  virtual void run(int worker);
+
+private:
+  LibEventServer *m_server;
+  LibEventJobPtr m_job;
+};
+
+/**
+ * Tears down the handler of the LibEventWorker for one pool thread, on that
+ * thread, when the server stops.
+ */
+class LibEventPoolExitJob : public SharedWorkerJob {
+public:
+  LibEventPoolExitJob(LibEventServer *server) : m_server(server) {}
+
+  virtual void run(int worker);
+
+private:
+  LibEventServer *m_server;
+};
+
+/**
+ * A response whose body still needs to be compressed before it goes back to
+ * its event loop, see Transport::supportsCompressionOffload().
+ */
+class LibEventCompressionJob {
+public:
+  LibEventCompressionJob(LibEventServer *server, int worker, int loop,
+                         evhttp_request *request, int code, int encoding)
+    : server(server), worker(worker), loop(loop), request(request),
+      code(code), encoding(encoding) {}
+
+  LibEventServer *server;
+  int worker;
+  int loop;
+  evhttp_request *request;
+  int code;
+  int encoding;
+};
+
+class LibEventCompressionWorker
+  : public JobQueueWorker<LibEventCompressionJob*> {
+public:
+  virtual void doJob(LibEventCompressionJob *job);
+};
+
 /**
  * Helper class for queuing up response sending back to event loop.
  */
@@ -77,7 +147,7 @@ public:
   PendingResponseQueue();
 
   bool empty();
-  void create(event_base *eventBase);
+  void create(event_base *eventBase, LibEventConnectionManager *connections);
   void enqueue(int worker, evhttp_request *request, int code, int nwritten);
   void enqueue(int worker, evhttp_request *request, int code, evbuffer *chunk,
                bool firstChunk);
@@ -112,10 +182,62 @@ private:
   event m_event;
   CPipe m_ready;
   ResponseQueuePtrVec m_responseQueues;
+  LibEventConnectionManager *m_connections;
 
   void enqueue(int worker, ResponsePtr response);
 };
 
+/**
+ * An additional event loop of a LibEventServer, running on its own thread
+ * with its own event_base and evhttp. All loops accept connections from the
+ * server's listening socket; requests received by a loop have their
+ * responses sent back through that loop's own PendingResponseQueue.
+ */
+DECLARE_BOOST_TYPES(LibEventLoop);
+class LibEventLoop {
+public:
+  LibEventLoop(LibEventServer *server, int id);
+  ~LibEventLoop();
+
+  int getId() const { return m_id;}
+  LibEventServer *getServer() const { return m_server;}
+  PendingResponseQueue &getResponseQueue() { return m_responseQueue;}
+  LibEventConnectionManager &getConnections() { return m_connections;}
+
+  /**
+   * Starts accepting on the server's listening socket in a new thread.
+   */
+  bool start(int acceptSock);
+  void waitForEnd();
+
+  /**
+   * stop() waits for the loop's thread to flush its responses and exit.
+   * dropAcceptSocket() only asks the loop's thread to stop accepting new
+   * connections and returns right away.
+   */
+  void stop();
+  void dropAcceptSocket();
+
+  // called by the loop's thread
+  void dispatch();
+  void onControl();
+
+private:
+  LibEventServer *m_server;
+  int m_id;
+  int m_acceptSock;
+  event_base *m_eventBase;
+  evhttp *m_http;
+  PendingResponseQueue m_responseQueue;
+  LibEventConnectionManager m_connections;
+
+  // signals from other threads: 's' to stop, 'd' to drop accept socket
+  event m_eventControl;
+  CPipe m_pipeControl;
+
+  AsyncFunc<LibEventLoop> m_thread;
+};
+
 /**
  * Implementing an evhttp based HTTP server with JobQueueDispatcher. This
  * server will have one dispather thread and multiple worker threads.
@@ -129,33 +251,94 @@ public:
                  int timeoutSeconds);
   ~LibEventServer();
 
+  /**
+   * Runs "count" event loops instead of one. Has to be called before
+   * start(). The extra loops only serve plain HTTP; SSL connections and
+   * the takeover fd server stay on the main loop.
+   */
+  void setEventLoopCount(int count);
+  int getEventLoopCount() const { return m_loops.size() + 1;}
+
+  /**
+   * Requests turned away by the limiter get a 503 as they arrive, before
+   * they are queued.
+   */
+  void setConcurrencyLimiter(ConcurrencyLimiterPtr limiter) {
+    m_limiter = limiter;
+  }
+  bool admitRequest(evhttp_request *request, int loop);
+  void onDequeue(const LibEventJob &job);
+
+  /**
+   * Runs requests on SharedWorkerPool threads instead of this server's own.
+   * Has to be called before start(), and only for one server, as pool
+   * threads all count as page request threads.
+   */
+  void useSharedWorkerPool();
+  LibEventWorker *getPoolWorker(int id) { return m_poolWorkers[id];}
+
   // implemting Server
   virtual void start();
   virtual void waitForEnd();
   virtual void stop();
   virtual int getActiveWorker() {
+    if (m_sharedPool) {
+      return SharedWorkerPool::GetActiveWorker(SharedWorkerPool::PageJob);
+    }
     return m_dispatcher.getActiveWorker();
   }
   virtual int getQueuedJobs() {
+    if (m_sharedPool) {
+      return SharedWorkerPool::GetQueuedJobs(SharedWorkerPool::PageJob);
+    }
     return m_dispatcher.getQueuedJobs();
   }
+  virtual void getQueueWaitHistogram(std::vector<int64> &counts) {
+    if (m_sharedPool) {
+      SharedWorkerPool::GetQueueWaitHistogram(SharedWorkerPool::PageJob,
+                                              counts);
+      return;
+    }
+    m_dispatcher.getWaitHistogram(counts);
+  }
+  virtual void getConnectionStats(ServerConnectionStats &stats);
 
   void onThreadEnter();
 
   /**
    * Request handler called by evhttp library.
    */
-  void onRequest(evhttp_request *request);
+  void onRequest(evhttp_request *request, int loop = 0);
   void onChunkedRead();
 
+  /**
+   * Called by LibEventWorker before handling a request.
+   */
+  void onJobStart(const LibEventJob &job);
+
   /**
    * Called by LibEventTransport when a response is fully prepared.
    */
-  void onResponse(int worker, evhttp_request *request, int code,
+  void onResponse(int worker, int loop, evhttp_request *request, int code,
                   LibEventTransport* transport);
-  void onChunkedResponse(int worker, evhttp_request *request, int code,
-                         evbuffer *chunk, bool firstChunk);
-  void onChunkedResponseEnd(int worker, evhttp_request *request);
+  void onChunkedResponse(int worker, int loop, evhttp_request *request,
+                         int code, evbuffer *chunk, bool firstChunk);
+  void onChunkedResponseEnd(int worker, int loop, evhttp_request *request);
+  void onCompressedResponse(int worker, int loop, evhttp_request *request,
+                            int code);
+
+  /**
+   * Called by LibEventTransport for a static body, see
+   * Transport::sendStatic(). Headers go out from the worker thread, then as
+   * much of the body as the socket takes right away, written from "data" or
+   * sendfile()-ed from "fd". Only what is left gets copied into the
+   * connection's output buffer for the event loop to finish, read with
+   * pread() from "fd" when there is one, as "data" is NULL then.
+   */
+  void onDirectResponse(int worker, int loop, evhttp_request *request,
+                        int code, LibEventTransport *transport,
+                        const char *data, int size, int fd);
+  bool hasCompressionPool() const { return m_compressionDispatcher != NULL;}
   void onChunkedRequest(evhttp_request *request);
 
   /**
@@ -171,6 +354,11 @@ protected:
   virtual int getAcceptSocket();
   virtual int getAcceptSocketSSL();
 
+  /**
+   * Makes the extra event loops stop accepting on m_accept_sock.
+   */
+  void dropAcceptSocket();
+
   int m_accept_sock;
   int m_accept_sock_ssl;
   event_base *m_eventBase;
@@ -190,7 +378,27 @@ private:
   JobQueueDispatcher<LibEventJobPtr, LibEventWorker> m_dispatcher;
   AsyncFunc<LibEventServer> m_dispatcherThread;
 
+  // one worker per SharedWorkerPool thread, if useSharedWorkerPool()
+  bool m_sharedPool;
+  std::vector<LibEventWorker*> m_poolWorkers;
+
+  // compresses responses handed over by workers, see supportsCompressionOffload()
+  JobQueueDispatcher<LibEventCompressionJob*, LibEventCompressionWorker>
+    *m_compressionDispatcher;
+
   PendingResponseQueue m_responseQueue;
+  LibEventConnectionManager m_connections;
+
+  LibEventLoopPtrVec m_loops;
+  ConcurrencyLimiterPtr m_limiter;
+  std::vector<std::string> m_loopStats;
+
+  PendingResponseQueue &getResponseQueue(int loop) {
+    return loop ? m_loops[loop - 1]->getResponseQueue() : m_responseQueue;
+  }
+  LibEventConnectionManager &getConnections(int loop) {
+    return loop ? m_loops[loop - 1]->getConnections() : m_connections;
+  }
 
   // dispatcher thread runs this function
   void dispatch();
@@ -31,9 +31,9 @@ struct m_evkeyvalq {
 
 LibEventTransport::LibEventTransport(LibEventServer *server,
                                      evhttp_request *request,
-                                     int workerId)
+                                     int workerId, int loop /* = 0 */)
   : m_server(server), m_request(request), m_eventBasePostData(NULL),
-    m_workerId(workerId), m_sendStarted(false), m_sendEnded(false) {
+    m_workerId(workerId), m_loop(loop), m_sendStarted(false), m_sendEnded(false) {
   // HttpProtocol::PrepareSystemVariables needs this
   evbuffer *buf = m_request->input_buffer;
   ASSERT(buf);
@@ -243,18 +243,39 @@ bool LibEventTransport::isServerStopping() {
   return m_server->getStatus() == Server::STOPPED;
 }
 
+bool LibEventTransport::supportsCompressionOffload() {
+  return m_method != HEAD && m_server->hasCompressionPool();
+}
+
+bool LibEventTransport::supportsDirectSend() {
+  return m_method != HEAD && RuntimeOption::LibEventSyncSend;
+}
+
 void LibEventTransport::sendImpl(const void *data, int size, int code,
                                  bool chunked) {
-  ASSERT(data);
+  ASSERT(data || (isDirectSend() && getDirectSendFd() >= 0));
   ASSERT(!m_sendEnded);
   ASSERT(!m_sendStarted || chunked);
 
+  if (!m_sendStarted) {
+    // a streamed body the page didn't read all of has to be off the
+    // connection before the response goes out on it
+    while (hasMorePostData()) {
+      int delta = 0;
+      if (getMorePostData(delta) == NULL) break;
+    }
+  }
+
   if (chunked) {
     ASSERT(m_method != HEAD);
     evbuffer *chunk = evbuffer_new();
     evbuffer_add(chunk, data, size);
-    m_server->onChunkedResponse(m_workerId, m_request, code, chunk,
+    m_server->onChunkedResponse(m_workerId, m_loop, m_request, code, chunk,
                                !m_sendStarted);
+  } else if (isDirectSend()) {
+    m_server->onDirectResponse(m_workerId, m_loop, m_request, code, this,
+                               (const char *)data, size, getDirectSendFd());
+    m_sendEnded = true;
   } else {
     if (m_method != HEAD) {
       evbuffer_add(m_request->output_buffer, data, size);
@@ -264,7 +285,7 @@ void LibEventTransport::sendImpl(const void *data, int size, int code,
       snprintf(buf, sizeof(buf), "%d", size);
       addHeaderImpl("Content-Length", buf);
     }
-    m_server->onResponse(m_workerId, m_request, code, this);
+    m_server->onResponse(m_workerId, m_loop, m_request, code, this);
     m_sendEnded = true;
   }
   m_sendStarted = true;
@@ -272,7 +293,7 @@ void LibEventTransport::sendImpl(const void *data, int size, int code,
 
 void LibEventTransport::onSendEndImpl() {
   if (m_chunkedEncoding) {
-    m_server->onChunkedResponseEnd(m_workerId, m_request);
+    m_server->onChunkedResponseEnd(m_workerId, m_loop, m_request);
     m_sendEnded = true;
   } else {
     ASSERT(m_sendEnded); // otherwise, we didn't call send for this request
@@ -27,7 +27,7 @@ class LibEventServer;
 class LibEventTransport : public Transport {
 public:
   LibEventTransport(LibEventServer *server, evhttp_request *request,
-                    int workerId);
+                    int workerId, int loop = 0);
 
   /**
    * Implementing Transport...
@@ -50,6 +50,8 @@ public:
   virtual void sendImpl(const void *data, int size, int code, bool chunked);
   virtual void onSendEndImpl();
   virtual bool isServerStopping();
+  virtual bool supportsCompressionOffload();
+  virtual bool supportsDirectSend();
 
 private:
   LibEventServer *m_server;
@@ -57,6 +59,7 @@ private:
   struct event_base *m_eventBasePostData;
   struct event m_moreDataRead;
   int m_workerId;
+  int m_loop; // event loop that received the request
   std::string m_url;
   std::string m_remote_host;
   uint16 m_remote_port;
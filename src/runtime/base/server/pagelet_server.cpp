@@ -18,9 +18,11 @@
 #include <runtime/base/server/transport.h>
 #include <runtime/base/server/http_request_handler.h>
 #include <runtime/base/server/upload.h>
+#include <runtime/base/server/shared_worker_pool.h>
 #include <runtime/base/util/string_buffer.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/resource_data.h>
+#include <runtime/base/util/request_local.h>
 #include <runtime/ext/ext_server.h>
 #include <util/job_queue.h>
 #include <util/lock.h>
@@ -31,6 +33,43 @@ using namespace std;
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Notified whenever one of the tasks a request started has new results, so
+ * the request can sleep on all its tasks at once.
+ */
+class PageletCompletion : public Synchronizable {
+public:
+  void signal() {
+    Lock lock(this);
+    notifyAll();
+  }
+};
+DECLARE_BOOST_TYPES(PageletCompletion);
+
+class PageletRequestData : public RequestEventHandler {
+public:
+  virtual void requestInit() {
+    m_completion.reset();
+  }
+
+  virtual void requestShutdown() {
+    m_completion.reset();
+  }
+
+  PageletCompletionPtr getCompletion() {
+    if (!m_completion) {
+      m_completion = PageletCompletionPtr(new PageletCompletion());
+    }
+    return m_completion;
+  }
+
+private:
+  PageletCompletionPtr m_completion;
+};
+IMPLEMENT_STATIC_REQUEST_LOCAL(PageletRequestData, s_pagelet_data);
+
+///////////////////////////////////////////////////////////////////////////////
+
 class PageletTransport : public Transport, public Synchronizable {
 public:
   PageletTransport(CStrRef url, CArrRef headers, CStrRef postData,
@@ -121,9 +160,12 @@ public:
     }
   }
   virtual void onSendEndImpl() {
-    Lock lock(this);
-    m_done = true;
-    notify();
+    {
+      Lock lock(this);
+      m_done = true;
+      notify();
+    }
+    if (m_completion) m_completion->signal();
   }
   virtual bool isUploadedFile(CStrRef filename) {
     return m_rfc1867UploadedFiles.find(filename.c_str()) !=
@@ -147,9 +189,16 @@ public:
   }
 
   void addToPipeline(const string &s) {
-    Lock lock(this);
-    m_pipeline.push_back(s);
-    notify();
+    {
+      Lock lock(this);
+      m_pipeline.push_back(s);
+      notify();
+    }
+    if (m_completion) m_completion->signal();
+  }
+
+  void setCompletion(PageletCompletionPtr completion) {
+    m_completion = completion;
   }
 
   bool isPipelineEmpty() {
@@ -212,23 +261,63 @@ private:
   int m_code;
 
   deque<string> m_pipeline; // the intermediate pagelet results
+  PageletCompletionPtr m_completion; // of the request that started us
   set<string> m_rfc1867UploadedFiles;
   string m_files; // serialized to use as $_FILES
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static Mutex s_stats_mutex;
+static std::map<std::string, PageletStats> s_stats;
+
+static void record_stats(const char *url, int64 queueTimeUs,
+                         int64 execTimeUs) {
+  const char *query = strchr(url, '?');
+  string path = query ? string(url, query - url) : string(url);
+
+  Lock lock(s_stats_mutex);
+  PageletStats &stats = s_stats[path];
+  stats.count++;
+  stats.queueTimeUs += queueTimeUs;
+  stats.execTimeUs += execTimeUs;
+  if (queueTimeUs > stats.maxQueueTimeUs) stats.maxQueueTimeUs = queueTimeUs;
+  if (execTimeUs > stats.maxExecTimeUs) stats.maxExecTimeUs = execTimeUs;
+}
+
+static void run_pagelet(PageletTransport *job) {
+  try {
+    timespec start, end;
+    gettime(CLOCK_MONOTONIC, &start);
+    job->onRequestStart(job->getStartTimer());
+    HttpRequestHandler().handleRequest(job);
+    gettime(CLOCK_MONOTONIC, &end);
+    record_stats(job->getUrl(),
+                 gettime_diff_us(job->getStartTimer(), start),
+                 gettime_diff_us(start, end));
+    job->decRefCount();
+  } catch (...) {
+    Logger::Error("HttpRequestHandler leaked exceptions");
+  }
+}
+
 class PageletWorker : public JobQueueWorker<PageletTransport*> {
 public:
   virtual void doJob(PageletTransport *job) {
-    try {
-      job->onRequestStart(job->getStartTimer());
-      HttpRequestHandler().handleRequest(job);
-      job->decRefCount();
-    } catch (...) {
-      Logger::Error("HttpRequestHandler leaked exceptions");
-    }
+    run_pagelet(job);
+  }
+};
+
+class PageletPoolJob : public SharedWorkerJob {
+public:
+  PageletPoolJob(PageletTransport *job) : m_job(job) {}
+
+  virtual void run(int worker) {
+    run_pagelet(m_job);
   }
+
+private:
+  PageletTransport *m_job;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -278,13 +367,16 @@ void PageletServer::Restart() {
     delete s_dispatcher;
     s_dispatcher = NULL;
   }
-  if (RuntimeOption::PageletServerThreadCount > 0) {
+  if (RuntimeOption::PageletServerThreadCount > 0 &&
+      SharedWorkerPool::Enabled()) {
+    Logger::Info("pagelet server started on shared worker pool");
+  } else if (RuntimeOption::PageletServerThreadCount > 0) {
     s_dispatcher = new JobQueueDispatcher<PageletTransport*, PageletWorker>
       (RuntimeOption::PageletServerThreadCount,
        RuntimeOption::PageletServerThreadRoundRobin,
        RuntimeOption::PageletServerThreadDropCacheTimeoutSeconds,
        RuntimeOption::PageletServerThreadDropStack,
-       NULL);
+       NULL, false, RuntimeOption::PageletServerThreadJobStealing);
     Logger::Info("pagelet server started");
     s_dispatcher->start();
   }
@@ -298,16 +390,21 @@ Object PageletServer::TaskStart(CStrRef url, CArrRef headers,
     return null_object;
   }
   if (RuntimeOption::PageletServerQueueLimit > 0 &&
-      s_dispatcher->getQueuedJobs() > RuntimeOption::PageletServerQueueLimit) {
+      GetQueuedJobs() > RuntimeOption::PageletServerQueueLimit) {
     return null_object;
   }
   PageletTask *task = NEWOBJ(PageletTask)(url, headers, remote_host, post_data,
                                           get_uploaded_files(), files);
   Object ret(task);
   PageletTransport *job = task->getJob();
+  job->setCompletion(s_pagelet_data->getCompletion());
   job->incRefCount(); // paired with worker's decRefCount()
-  ASSERT(s_dispatcher);
-  s_dispatcher->enqueue(job);
+  if (s_dispatcher) {
+    s_dispatcher->enqueue(job);
+  } else {
+    SharedWorkerPool::Enqueue(SharedWorkerPool::PageletJob,
+                              new PageletPoolJob(job));
+  }
 
   return ret;
 }
@@ -329,6 +426,54 @@ String PageletServer::TaskResult(CObjRef task, Array &headers, int &code) {
   return ptask->getJob()->getResults(headers, code);
 }
 
+Array PageletServer::TaskWait(CArrRef tasks, int64 timeoutMs, bool waitAll) {
+  timespec deadline;
+  if (timeoutMs > 0) {
+    gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+  }
+
+  // Holding the lock while checking tasks means a task finishing right after
+  // it was checked cannot signal before we are waiting.
+  PageletCompletionPtr completion = s_pagelet_data->getCompletion();
+  Lock lock(completion.get());
+  while (true) {
+    Array ready = Array::Create();
+    bool allDone = true;
+    bool started = false;
+    for (ArrayIter iter(tasks); iter; ++iter) {
+      // tasks that didn't start are null, and nothing to wait for
+      if (iter.second().isNull()) continue;
+      started = true;
+      int64 status = TaskStatus(iter.second().toObject());
+      if (status != PAGELET_NOT_READY) {
+        ready.append(iter.first());
+      }
+      if (status != PAGELET_DONE) {
+        allDone = false;
+      }
+    }
+    if (waitAll ? allDone : (!ready.empty() || !started)) {
+      return ready;
+    }
+
+    if (timeoutMs < 0) {
+      completion->wait();
+    } else {
+      timespec now;
+      gettime(CLOCK_MONOTONIC, &now);
+      int64 remaining = timeoutMs ? gettime_diff_us(now, deadline) : 0;
+      if (remaining <= 0) return ready;
+      completion->wait(remaining / 1000000, (remaining % 1000000) * 1000);
+    }
+  }
+}
+
 void PageletServer::AddToPipeline(const string &s) {
   ASSERT(!s.empty());
   PageletTransport *job =
@@ -338,12 +483,32 @@ void PageletServer::AddToPipeline(const string &s) {
 }
 
 int PageletServer::GetActiveWorker() {
+  if (!s_dispatcher) {
+    return SharedWorkerPool::GetActiveWorker(SharedWorkerPool::PageletJob);
+  }
   return s_dispatcher->getActiveWorker();
 }
 
 int PageletServer::GetQueuedJobs() {
+  if (!s_dispatcher) {
+    return SharedWorkerPool::GetQueuedJobs(SharedWorkerPool::PageletJob);
+  }
   return s_dispatcher->getQueuedJobs();
 }
 
+void PageletServer::GetQueueWaitHistogram(std::vector<int64> &counts) {
+  if (s_dispatcher) {
+    s_dispatcher->getWaitHistogram(counts);
+  } else {
+    SharedWorkerPool::GetQueueWaitHistogram(SharedWorkerPool::PageletJob,
+                                            counts);
+  }
+}
+
+void PageletServer::GetStats(std::map<std::string, PageletStats> &stats) {
+  Lock lock(s_stats_mutex);
+  stats = s_stats;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
@@ -22,6 +22,22 @@
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Timing of finished pagelet requests to one URL.
+ */
+class PageletStats {
+public:
+  PageletStats()
+    : count(0), queueTimeUs(0), maxQueueTimeUs(0), execTimeUs(0),
+      maxExecTimeUs(0) {}
+
+  int64 count;
+  int64 queueTimeUs; // total over all requests
+  int64 maxQueueTimeUs;
+  int64 execTimeUs;  // total over all requests
+  int64 maxExecTimeUs;
+};
+
 class PageletServer {
 public:
   static bool Enabled();
@@ -47,6 +63,17 @@ public:
    */
   static String TaskResult(CObjRef task, Array &headers, int &code);
 
+  /**
+   * Block until any of the tasks has results, or until all of them are done
+   * if waitAll is true, for at most timeoutMs milliseconds, or forever if it
+   * is negative. Returns keys of the tasks that have results, in the order
+   * of the given array. All tasks a request starts share one condition
+   * variable, so this wakes up as soon as any of them makes progress.
+   * Null entries, for tasks that could not be started, are skipped: they are
+   * never returned as ready and don't hold up waitAll.
+   */
+  static Array TaskWait(CArrRef tasks, int64 timeoutMs, bool waitAll);
+
   /**
    * Add a piece of response to the pipeline.
    */
@@ -57,6 +84,12 @@ public:
    */
   static int GetActiveWorker();
   static int GetQueuedJobs();
+  static void GetQueueWaitHistogram(std::vector<int64> &counts);
+
+  /**
+   * Queue and execution time of finished requests, by URL without query.
+   */
+  static void GetStats(std::map<std::string, PageletStats> &stats);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
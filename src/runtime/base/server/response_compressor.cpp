@@ -0,0 +1,139 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/base/server/response_compressor.h>
+#include <runtime/base/runtime_option.h>
+#include <runtime/base/zend/zend_string.h>
+#include <util/lock.h>
+#include <list>
+
+using namespace std;
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class CompressedResponseCache {
+public:
+  CompressedResponseCache() : m_size(0), m_hits(0), m_misses(0) {}
+
+  bool find(const string &key, string &compressed) {
+    Lock lock(m_mutex);
+    EntryMap::iterator iter = m_map.find(key);
+    if (iter == m_map.end()) {
+      m_misses++;
+      return false;
+    }
+    // move to front as most recently used
+    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+    compressed = iter->second->second;
+    m_hits++;
+    return true;
+  }
+
+  void insert(const string &key, const char *data, int len, int64 capacity) {
+    // a single body shouldn't push out most of the cache
+    if (len > capacity / 4) return;
+    Lock lock(m_mutex);
+    if (m_map.find(key) != m_map.end()) return;
+    m_entries.push_front(Entry(key, string(data, len)));
+    m_map[key] = m_entries.begin();
+    m_size += len;
+    while (m_size > capacity && !m_entries.empty()) {
+      Entry &last = m_entries.back();
+      m_size -= last.second.size();
+      m_map.erase(last.first);
+      m_entries.pop_back();
+    }
+  }
+
+  int64 getHits() const { return m_hits;}
+  int64 getMisses() const { return m_misses;}
+
+private:
+  typedef pair<string, string> Entry; // key and compressed body
+  typedef hphp_string_map<list<Entry>::iterator> EntryMap;
+
+  Mutex m_mutex;
+  list<Entry> m_entries;
+  EntryMap m_map;
+  int64 m_size;
+  int64 m_hits;
+  int64 m_misses;
+};
+
+static CompressedResponseCache s_cache;
+
+static char *compress_body(const char *data, int &len, int encoding) {
+  StreamCompressor compressor(ResponseCompressor::GetLevel(encoding),
+                              encoding, encoding == CODING_GZIP);
+  return compressor.compress(data, len, true);
+}
+
+int ResponseCompressor::GetLevel(int encoding) {
+  switch (encoding) {
+  case CODING_GZIP:   return RuntimeOption::GzipCompressionLevel;
+  case CODING_BROTLI: return RuntimeOption::BrotliCompressionLevel;
+  case CODING_ZSTD:   return RuntimeOption::ZstdCompressionLevel;
+  }
+  return 0;
+}
+
+bool ResponseCompressor::IsEnabled(int encoding) {
+  return is_encoding_supported(encoding) && GetLevel(encoding) > 0;
+}
+
+bool ResponseCompressor::IsEnabled() {
+  return IsEnabled(CODING_GZIP) || IsEnabled(CODING_BROTLI) ||
+    IsEnabled(CODING_ZSTD);
+}
+
+char *ResponseCompressor::Compress(const char *data, int &len,
+                                   int encoding /* = CODING_GZIP */) {
+  int64 capacity = RuntimeOption::GzipCompressionCacheSize;
+  if (capacity <= 0) {
+    return compress_body(data, len, encoding);
+  }
+
+  int keyLen;
+  char *digest = string_md5(data, len, true, keyLen);
+  string key(digest, keyLen);
+  free(digest);
+  key.append((const char *)&len, sizeof(len));
+  key.push_back((char)encoding);
+
+  string compressed;
+  if (s_cache.find(key, compressed)) {
+    len = compressed.size();
+    return string_duplicate(compressed.data(), len);
+  }
+
+  char *ret = compress_body(data, len, encoding);
+  if (ret) {
+    s_cache.insert(key, ret, len, capacity);
+  }
+  return ret;
+}
+
+int64 ResponseCompressor::GetCacheHits() {
+  return s_cache.getHits();
+}
+
+int64 ResponseCompressor::GetCacheMisses() {
+  return s_cache.getMisses();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,62 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_RESPONSE_COMPRESSOR_H__
+#define __HPHP_RESPONSE_COMPRESSOR_H__
+
+#include <util/base.h>
+#include <util/compression.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Compresses whole (non-chunked) response bodies with the content encoding
+ * Transport negotiated. When GzipCompressionCacheSize is set, compressed
+ * bodies are kept in an LRU keyed by MD5 of the uncompressed body and the
+ * encoding, so endpoints sending out the same bytes
+ * again and again only pay for compression once. Safe to call from any
+ * thread, including ones without a request.
+ */
+class ResponseCompressor {
+public:
+  /**
+   * Same contract as StreamCompressor::compress(): returns malloc-ed
+   * compressed data and updates "len", or NULL on failure.
+   */
+  static char *Compress(const char *data, int &len,
+                        int encoding = CODING_GZIP);
+
+  /**
+   * Configured level of a content encoding, 0 if it is turned off.
+   */
+  static int GetLevel(int encoding);
+
+  /**
+   * Whether a content encoding is compiled in and turned on; without an
+   * encoding, whether any of them is.
+   */
+  static bool IsEnabled(int encoding);
+  static bool IsEnabled();
+
+  static int64 GetCacheHits();
+  static int64 GetCacheMisses();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_RESPONSE_COMPRESSOR_H__
@@ -83,6 +83,26 @@ public:
   virtual void handleRequest(Transport *transport) = 0;
 };
 
+/**
+ * Client connection counters of a server. Connections are "reused" by every
+ * request after their first one.
+ */
+class ServerConnectionStats {
+public:
+  ServerConnectionStats()
+    : open(0), idle(0), opened(0), closed(0), reused(0), evicted(0),
+      timedOut(0) {}
+
+  int64 open;
+  int64 idle;
+  int64 opened;
+  int64 closed;
+  int64 reused;
+  int64 evicted;  // closed for going over the idle limit
+  int64 timedOut; // closed for being idle too long
+  std::vector<int64> requestsPerConnection; // of closed ones, log2 buckets
+};
+
 /**
  * Base class of an HTTP server. Defining minimal interface an HTTP server
  * needs to implement.
@@ -160,6 +180,16 @@ public:
    */
   virtual int getQueuedJobs() = 0;
 
+  /**
+   * How long jobs waited in queue, see JobQueueWaitHistogram.
+   */
+  virtual void getQueueWaitHistogram(std::vector<int64> &counts) = 0;
+
+  /**
+   * Counters of client connections, if the server keeps them.
+   */
+  virtual void getConnectionStats(ServerConnectionStats &stats) {}
+
   /**
    * This is for TypedServer to specialize a worker class to use.
    */
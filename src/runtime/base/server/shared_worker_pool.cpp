@@ -0,0 +1,396 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#include <runtime/base/server/shared_worker_pool.h>
+#include <runtime/base/memory/memory_manager.h>
+#include <runtime/base/runtime_option.h>
+#include <runtime/base/timeout_thread.h>
+#include <util/job_queue.h>
+#include <util/lock.h>
+#include <util/logger.h>
+
+using namespace std;
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class SharedWorkerQueue : public SynchronizableMulti {
+public:
+  SharedWorkerQueue(int threadCount)
+    : SynchronizableMulti(RuntimeOption::ServerThreadRoundRobin ?
+                          1 : threadCount),
+      m_idle(threadCount), m_stopped(false), m_pinned(threadCount),
+      m_pinnedLeft(0) {
+    m_classes[SharedWorkerPool::PageJob].init
+      (RuntimeOption::WorkerPoolPageWeight,
+       RuntimeOption::WorkerPoolPageMinThreads);
+    m_classes[SharedWorkerPool::PageletJob].init
+      (RuntimeOption::WorkerPoolPageletWeight,
+       RuntimeOption::WorkerPoolPageletMinThreads);
+    m_classes[SharedWorkerPool::XboxJob].init
+      (RuntimeOption::WorkerPoolXboxWeight,
+       RuntimeOption::WorkerPoolXboxMinThreads);
+
+    // pages block on the pagelets and xbox messages they send, so those
+    // always keep a thread, or pages could take every thread and wait for
+    // work nobody is left to run
+    if (RuntimeOption::PageletServerThreadCount > 0) {
+      reserveOne(SharedWorkerPool::PageletJob);
+    }
+    if (RuntimeOption::XboxServerThreadCount > 0) {
+      reserveOne(SharedWorkerPool::XboxJob);
+    }
+
+    // reservations can't add up to more than the pool has, and the classes
+    // pages wait on get theirs first, short of the one thread pages need
+    int left = threadCount;
+    for (int i = SharedWorkerPool::JobClassCount - 1; i >= 0; i--) {
+      JobClassQueue &q = m_classes[i];
+      int most = i == SharedWorkerPool::PageJob ? left : left - 1;
+      if (most < 0) most = 0;
+      if (q.minThreads > most) {
+        if (i != SharedWorkerPool::PageJob) {
+          Logger::Warning("WorkerPool.ThreadCount %d is too small to keep "
+                          "%d threads for job class %d", threadCount,
+                          q.minThreads, i);
+        }
+        q.minThreads = most;
+      }
+      left -= q.minThreads;
+    }
+    pthread_cond_init(&m_idleCond, NULL);
+  }
+
+  ~SharedWorkerQueue() {
+    pthread_cond_destroy(&m_idleCond);
+  }
+
+  void enqueue(int cls, SharedWorkerJob *job) {
+    Lock lock(this);
+    JobClassQueue &q = m_classes[cls];
+    q.jobs.push_back(QueuedJob(job, JobQueueWaitHistogram::Now()));
+    q.queued = q.jobs.size();
+    notify();
+  }
+
+  /**
+   * Gives jobs[i] to thread i, and blocks until all of them are done.
+   */
+  void runOnEachThread(const vector<SharedWorkerJob*> &jobs) {
+    Lock lock(this);
+    for (unsigned int i = 0; i < jobs.size(); i++) {
+      if (i < m_pinned.size()) {
+        ASSERT(!m_pinned[i]);
+        m_pinned[i] = jobs[i];
+        m_pinnedLeft++;
+      } else {
+        delete jobs[i];
+      }
+    }
+    notifyAll(); // each of them has to find its own
+    while (m_pinnedLeft) {
+      pthread_cond_wait(&m_idleCond, &getMutex().getRaw());
+    }
+  }
+
+  /**
+   * Picks the next job as described in SharedWorkerPool, sleeping while no
+   * class may run one. Returns NULL once the pool is stopped and drained.
+   * A job given to this very thread by runOnEachThread() goes first, with
+   * "cls" set to -1.
+   */
+  SharedWorkerJob *dequeue(int id, int &cls) {
+    Lock lock(this);
+    bool flushed = false;
+    while (true) {
+      if (SharedWorkerJob *job = m_pinned[id]) {
+        m_pinned[id] = NULL;
+        cls = -1;
+        return job;
+      }
+      if ((cls = pickClass()) >= 0) {
+        break;
+      }
+      if (m_stopped) {
+        return NULL;
+      }
+      int timeout = RuntimeOption::ServerThreadDropCacheTimeoutSeconds;
+      if (timeout <= 0 || flushed) {
+        wait(id, false);
+      } else if (!wait(id, false, timeout)) {
+        // since we timed out, maybe we can turn idle without holding memory
+        if (pickClass() < 0) {
+          Util::flush_thread_caches();
+          if (RuntimeOption::ServerThreadDropStack && Util::s_stackLimit) {
+            Util::flush_thread_stack();
+          }
+          flushed = true;
+        }
+      }
+    }
+    JobClassQueue &q = m_classes[cls];
+    QueuedJob queued = q.jobs.front();
+    q.jobs.pop_front();
+    q.queued = q.jobs.size();
+    q.active++;
+    m_idle--;
+    q.waits.record(queued.second);
+    return queued.first;
+  }
+
+  void finish(int cls) {
+    Lock lock(this);
+    if (cls < 0) {
+      if (--m_pinnedLeft == 0) pthread_cond_broadcast(&m_idleCond);
+      return;
+    }
+    JobClassQueue &q = m_classes[cls];
+    q.active--;
+    m_idle++;
+    if (q.active == 0 && q.jobs.empty()) {
+      pthread_cond_broadcast(&m_idleCond);
+    }
+    // a freed reserved thread, or one more idle one, may let a waiting
+    // thread take a job it had to leave alone so far
+    if (pickClass() >= 0) {
+      notify();
+    }
+  }
+
+  void waitIdle(int cls) {
+    Lock lock(this);
+    JobClassQueue &q = m_classes[cls];
+    while (q.active || !q.jobs.empty()) {
+      pthread_cond_wait(&m_idleCond, &getMutex().getRaw());
+    }
+  }
+
+  void stop() {
+    Lock lock(this);
+    m_stopped = true;
+    notifyAll(); // so all waiting threads can find out queue is stopped
+  }
+
+  int getActiveWorker(int cls) const { return m_classes[cls].active;}
+  int getQueuedJobs(int cls) const { return m_classes[cls].queued;}
+  const JobQueueWaitHistogram &getWaitHistogram(int cls) const {
+    return m_classes[cls].waits;
+  }
+
+private:
+  typedef std::pair<SharedWorkerJob*, int64> QueuedJob; // and enqueue time
+
+  class JobClassQueue {
+  public:
+    JobClassQueue() : weight(1), minThreads(0), active(0), queued(0) {}
+
+    void init(int w, int m) {
+      weight = w > 0 ? w : 1;
+      minThreads = m > 0 ? m : 0;
+    }
+
+    deque<QueuedJob> jobs;
+    int weight;
+    int minThreads;
+    int active;
+    int queued;
+    JobQueueWaitHistogram waits;
+  };
+
+  JobClassQueue m_classes[SharedWorkerPool::JobClassCount];
+  int m_idle;
+  bool m_stopped;
+  pthread_cond_t m_idleCond; // also signals runOnEachThread() progress
+  vector<SharedWorkerJob*> m_pinned; // by thread id, see runOnEachThread()
+  int m_pinnedLeft;
+
+  void reserveOne(int cls) {
+    if (m_classes[cls].minThreads < 1) m_classes[cls].minThreads = 1;
+  }
+
+  int pickClass() {
+    int reserved = 0;
+    for (int i = 0; i < SharedWorkerPool::JobClassCount; i++) {
+      JobClassQueue &q = m_classes[i];
+      if (q.active < q.minThreads) {
+        if (!q.jobs.empty()) return i;
+        reserved += q.minThreads - q.active;
+      }
+    }
+    // a stopped pool only drains, with no more threads to save for anyone
+    if (!m_stopped && m_idle - 1 < reserved) return -1;
+
+    int best = -1;
+    for (int i = 0; i < SharedWorkerPool::JobClassCount; i++) {
+      JobClassQueue &q = m_classes[i];
+      if (q.jobs.empty()) continue;
+      if (best < 0) {
+        best = i;
+        continue;
+      }
+      // fewest running threads per weight after taking this job
+      JobClassQueue &b = m_classes[best];
+      if ((int64)(q.active + 1) * b.weight <
+          (int64)(b.active + 1) * q.weight) {
+        best = i;
+      }
+    }
+    return best;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class SharedWorker {
+public:
+  SharedWorker(SharedWorkerQueue *queue, TimeoutThread *timeout, int id)
+    : m_queue(queue), m_timeout(timeout), m_id(id) {}
+
+  void run() {
+    RequestInjectionData &data = ThreadInfo::s_threadInfo->m_reqInjectionData;
+    m_timeout->registerRequestThread(&data);
+
+    int cls;
+    while (SharedWorkerJob *job = m_queue->dequeue(m_id, cls)) {
+      // only page requests time out, just like on their own threads
+      data.timeoutSeconds = cls == SharedWorkerPool::PageJob ?
+        RuntimeOption::RequestTimeoutSeconds : -1;
+      try {
+        job->run(m_id);
+      } catch (...) {
+        Logger::Error("shared worker job leaked exceptions");
+      }
+      delete job;
+      m_queue->finish(cls);
+    }
+    MemoryManager::TheMemoryManager().getNoCheck()->cleanup();
+  }
+
+private:
+  SharedWorkerQueue *m_queue;
+  TimeoutThread *m_timeout;
+  int m_id;
+};
+
+class SharedWorkerThreads {
+public:
+  SharedWorkerThreads(int threadCount)
+    : m_queue(threadCount),
+      m_timeoutData(threadCount, RuntimeOption::RequestTimeoutSeconds),
+      m_timeoutThread(&m_timeoutData, &TimeoutThread::run) {
+    for (int i = 0; i < threadCount; i++) {
+      SharedWorker *worker = new SharedWorker(&m_queue, &m_timeoutData, i);
+      m_workers.push_back(worker);
+      m_funcs.push_back(new AsyncFunc<SharedWorker>(worker,
+                                                    &SharedWorker::run));
+    }
+  }
+
+  ~SharedWorkerThreads() {
+    for (unsigned int i = 0; i < m_funcs.size(); i++) {
+      delete m_funcs[i];
+      delete m_workers[i];
+    }
+  }
+
+  void start() {
+    for (unsigned int i = 0; i < m_funcs.size(); i++) {
+      m_funcs[i]->start();
+    }
+    m_timeoutThread.start();
+  }
+
+  void stop() {
+    m_queue.stop();
+    for (unsigned int i = 0; i < m_funcs.size(); i++) {
+      m_funcs[i]->waitForEnd();
+    }
+    m_timeoutData.stop();
+    m_timeoutThread.waitForEnd();
+  }
+
+  SharedWorkerQueue &getQueue() { return m_queue;}
+
+private:
+  SharedWorkerQueue m_queue;
+  TimeoutThread m_timeoutData;
+  AsyncFunc<TimeoutThread> m_timeoutThread;
+  vector<SharedWorker*> m_workers;
+  vector<AsyncFunc<SharedWorker>*> m_funcs;
+};
+
+static SharedWorkerThreads *s_threads;
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool SharedWorkerPool::Enabled() {
+  return RuntimeOption::WorkerPoolThreadCount > 0;
+}
+
+int SharedWorkerPool::GetThreadCount() {
+  return Enabled() ? RuntimeOption::WorkerPoolThreadCount : 0;
+}
+
+void SharedWorkerPool::Restart() {
+  if (s_threads) {
+    s_threads->stop();
+    delete s_threads;
+    s_threads = NULL;
+  }
+  if (Enabled()) {
+    s_threads = new SharedWorkerThreads(RuntimeOption::WorkerPoolThreadCount);
+    Logger::Info("shared worker pool started");
+    s_threads->start();
+  }
+}
+
+void SharedWorkerPool::Enqueue(JobClass cls, SharedWorkerJob *job) {
+  ASSERT(s_threads);
+  s_threads->getQueue().enqueue(cls, job);
+}
+
+void SharedWorkerPool::RunOnEachThread(
+  const std::vector<SharedWorkerJob*> &jobs) {
+  if (s_threads) {
+    s_threads->getQueue().runOnEachThread(jobs);
+    return;
+  }
+  for (unsigned int i = 0; i < jobs.size(); i++) {
+    jobs[i]->run(i);
+    delete jobs[i];
+  }
+}
+
+void SharedWorkerPool::WaitIdle(JobClass cls) {
+  if (s_threads) s_threads->getQueue().waitIdle(cls);
+}
+
+int SharedWorkerPool::GetActiveWorker(JobClass cls) {
+  return s_threads ? s_threads->getQueue().getActiveWorker(cls) : 0;
+}
+
+int SharedWorkerPool::GetQueuedJobs(JobClass cls) {
+  return s_threads ? s_threads->getQueue().getQueuedJobs(cls) : 0;
+}
+
+void SharedWorkerPool::GetQueueWaitHistogram(JobClass cls,
+                                             std::vector<int64> &counts) {
+  if (s_threads) s_threads->getQueue().getWaitHistogram(cls).get(counts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,95 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#ifndef __HTTP_SERVER_SHARED_WORKER_POOL_H__
+#define __HTTP_SERVER_SHARED_WORKER_POOL_H__
+
+#include <util/base.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * One piece of work for SharedWorkerPool. "worker" is the id of the pool
+ * thread running it, from 0 to the pool's thread count. The pool deletes
+ * the job after running it.
+ */
+class SharedWorkerJob {
+public:
+  virtual ~SharedWorkerJob() {}
+  virtual void run(int worker) = 0;
+};
+
+/**
+ * One set of threads serving page requests, pagelets and xbox messages, so
+ * a burst in one of them can use the threads the others leave idle instead
+ * of queuing behind its own fixed thread count.
+ *
+ * Every class of jobs has a weight and a number of reserved threads. An
+ * idle thread first serves a class that has jobs queued but fewer threads
+ * running than it reserves. Otherwise it serves the class with the fewest
+ * running threads per unit of weight, as long as enough idle threads are
+ * left to cover what the other classes reserve but don't use right now.
+ * Pagelets and xbox messages always reserve at least one thread while their
+ * servers are on, since pages block waiting for them.
+ *
+ * The pool is off unless WorkerPool.ThreadCount is set. Admin and satellite
+ * servers always keep threads of their own.
+ */
+class SharedWorkerPool {
+public:
+  enum JobClass {
+    PageJob,
+    PageletJob,
+    XboxJob,
+
+    JobClassCount
+  };
+
+  static bool Enabled();
+  static int GetThreadCount();
+
+  /**
+   * Stops running threads after they finish all queued jobs, then starts
+   * the pool over if it is enabled.
+   */
+  static void Restart();
+
+  static void Enqueue(JobClass cls, SharedWorkerJob *job);
+
+  /**
+   * Runs jobs[i] on pool thread i ahead of any queued job, and blocks until
+   * all of them are done. This is for state kept per pool thread, which has
+   * to be torn down on the thread that made it. Without a running pool, the
+   * jobs run right here.
+   */
+  static void RunOnEachThread(const std::vector<SharedWorkerJob*> &jobs);
+
+  /**
+   * Blocks until no job of the class is queued or running.
+   */
+  static void WaitIdle(JobClass cls);
+
+  static int GetActiveWorker(JobClass cls);
+  static int GetQueuedJobs(JobClass cls);
+  static void GetQueueWaitHistogram(JobClass cls, std::vector<int64> &counts);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HTTP_SERVER_SHARED_WORKER_POOL_H__
@@ -33,6 +33,14 @@ FileCachePtr StaticContentCache::TheFileCache;
 StaticContentCache::StaticContentCache() : m_totalSize(0) {
 }
 
+StringBufferPtr &StaticContentCache::ResourceFile::encoded(int encoding) {
+  switch (encoding) {
+  case CODING_BROTLI: return brotli;
+  case CODING_ZSTD:   return zstd;
+  }
+  return compressed;
+}
+
 void StaticContentCache::load() {
   Timer timer(Timer::WallTime, "loading static content");
 
@@ -94,15 +102,30 @@ void StaticContentCache::load() {
         f->file = sb;
         m_files[url] = f;
 
-        // prepare gzipped content, skipping image and swf files
+        // prepare compressed content at the highest levels that are still
+        // reasonable to load with, skipping image and swf files
         if (iter->second.find("image/") != 0 && iter->first != "swf") {
-          int len = sb->size();
-          char *data = gzencode(sb->data(), len, 9, CODING_GZIP);
-          if (data) {
-            if (len < sb->size()) {
-              f->compressed = StringBufferPtr(new StringBuffer(data, len));
-            } else {
-              free(data);
+          static const int encodings[][2] = {
+            { CODING_GZIP, 9 }, { CODING_BROTLI, 11 }, { CODING_ZSTD, 19 }
+          };
+          for (unsigned int j = 0;
+               j < sizeof(encodings)/sizeof(encodings[0]); j++) {
+            int encoding = encodings[j][0];
+            if (encoding == CODING_BROTLI &&
+                RuntimeOption::BrotliCompressionLevel <= 0) continue;
+            if (encoding == CODING_ZSTD &&
+                RuntimeOption::ZstdCompressionLevel <= 0) continue;
+            if (!is_encoding_supported(encoding)) continue;
+            int len = sb->size();
+            char *data = encode_with(sb->data(), len, encodings[j][1],
+                                     encoding);
+            if (data) {
+              if (len < sb->size()) {
+                f->encoded(encoding) =
+                  StringBufferPtr(new StringBuffer(data, len));
+              } else {
+                free(data);
+              }
             }
           }
         }
@@ -117,16 +140,21 @@ void StaticContentCache::load() {
 }
 
 bool StaticContentCache::find(const std::string &name, const char *&data,
-                              int &len, bool &compressed) const {
+                              int &len, bool &compressed,
+                              int &encoding) const {
   if (TheFileCache) {
+    if (encoding != CODING_GZIP) compressed = false;
+    encoding = CODING_GZIP;
     return data = TheFileCache->read(name.c_str(), len, compressed);
   }
 
   StringToResourceFilePtrMap::const_iterator iter = m_files.find(name);
   if (iter != m_files.end()) {
-    if (compressed && iter->second->compressed) {
-      data = iter->second->compressed->data();
-      len = iter->second->compressed->size();
+    StringBufferPtr variant;
+    if (compressed) variant = iter->second->encoded(encoding);
+    if (variant) {
+      data = variant->data();
+      len = variant->size();
     } else {
       compressed = false;
       data = iter->second->file->data();
@@ -37,10 +37,13 @@ public:
   void load();
 
   /**
-   * Find a file from cache.
+   * Find a file from cache. Pass in "compressed" and "encoding" to ask for
+   * a pre-compressed copy; on return "compressed" tells whether data is
+   * compressed, and if so "encoding" what with. File cache archives only
+   * keep gzip copies, and may hand those out when asked for other encodings.
    */
   bool find(const std::string &name, const char *&data, int &len,
-            bool &compressed) const;
+            bool &compressed, int &encoding) const;
 
 private:
   int m_totalSize;
@@ -48,7 +51,11 @@ private:
   DECLARE_BOOST_TYPES(ResourceFile);
   struct ResourceFile {
     StringBufferPtr file;
-    StringBufferPtr compressed;
+    StringBufferPtr compressed; // gzip
+    StringBufferPtr brotli;
+    StringBufferPtr zstd;
+
+    StringBufferPtr &encoded(int encoding);
   };
 
   StringToResourceFilePtrMap m_files;
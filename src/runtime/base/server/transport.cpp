@@ -18,6 +18,7 @@
 #include <runtime/base/server/server.h>
 #include <runtime/base/server/upload.h>
 #include <runtime/base/server/server_stats.h>
+#include <runtime/base/server/response_compressor.h>
 #include <runtime/base/file/file.h>
 #include <runtime/base/string_util.h>
 #include <runtime/base/time/datetime.h>
@@ -40,7 +41,9 @@ Transport::Transport()
     m_responseCode(-1), m_firstHeaderSet(false), m_firstHeaderLine(0),
     m_responseSize(0), m_responseTotalSize(0), m_responseSentSize(0),
     m_flushTimeUs(0), m_sendContentType(true),
-    m_compression(true), m_compressor(NULL), m_isSSL(false),
+    m_compression(true), m_compressor(NULL), m_compressionOffloaded(false),
+    m_encoding(CODING_GZIP), m_directSend(false), m_directSendFd(-1),
+    m_isSSL(false),
     m_compressionDecision(NotDecidedYet), m_threadType(RequestThread) {
   memset(&m_queueTime, 0, sizeof(m_queueTime));
   memset(&m_wallTime, 0, sizeof(m_wallTime));
@@ -446,6 +449,36 @@ bool Transport::acceptEncoding(const char *encoding) {
   return header.find(encoding) != string::npos;
 }
 
+/**
+ * Looks for one coding in a lower-cased Accept-Encoding header: 1 if it is
+ * listed, 0 if it is listed with "q=0", -1 if it is not listed at all.
+ */
+static int find_coding(const string &header, const char *coding) {
+  int len = strlen(coding);
+  for (size_t pos = header.find(coding); pos != string::npos;
+       pos = header.find(coding, pos + 1)) {
+    if (pos > 0 && header[pos-1] != ',' && !isspace(header[pos-1])) continue;
+    size_t end = pos + len;
+    while (end < header.size() && isspace(header[end])) end++;
+    if (end == header.size() || header[end] == ',') return 1;
+    if (header[end] != ';') continue;
+    size_t q = header.find("q=", end);
+    size_t next = header.find(',', end);
+    if (q == string::npos || (next != string::npos && q > next)) return 1;
+    return atof(header.c_str() + q + 2) > 0 ? 1 : 0;
+  }
+  return -1;
+}
+
+bool Transport::AcceptsCoding(const string &header, const char *coding,
+                              bool wildcard) {
+  ASSERT(coding && *coding);
+  string lower = Util::toLower(header);
+  int found = find_coding(lower, coding);
+  if (found < 0 && wildcard) found = find_coding(lower, "*");
+  return found > 0;
+}
+
 bool Transport::cookieExists(const char *name) {
   ASSERT(name && *name);
   string header = getHeader("Cookie");
@@ -491,7 +524,21 @@ bool Transport::decideCompression() {
     return true;
   }
 
-  if (acceptEncoding("gzip") ||
+  // brotli and zstd are only picked when client asks for them by name
+  static const int preferred[] = { CODING_BROTLI, CODING_ZSTD };
+  string header = getHeader("Accept-Encoding");
+  for (unsigned int i = 0; i < sizeof(preferred)/sizeof(preferred[0]); i++) {
+    int encoding = preferred[i];
+    if (ResponseCompressor::IsEnabled(encoding) &&
+        AcceptsCoding(header, get_encoding_name(encoding), false)) {
+      m_encoding = encoding;
+      m_compressionDecision = ShouldCompress;
+      return true;
+    }
+  }
+
+  if (AcceptsCoding(header, "gzip", true) ||
+      AcceptsCoding(header, "x-gzip", false) ||
       (!RuntimeOption::ForceCompressionCookie.empty() &&
        cookieExists(RuntimeOption::ForceCompressionCookie.c_str())) ||
       (!RuntimeOption::ForceCompressionParam.empty() &&
@@ -504,6 +551,15 @@ bool Transport::decideCompression() {
   return false;
 }
 
+bool Transport::isCompressionEnabled() const {
+  if (!m_compression) return false;
+  if (m_compressionDecision == NotDecidedYet) {
+    // m_encoding is only a default until decideCompression() picks one
+    return ResponseCompressor::IsEnabled();
+  }
+  return ResponseCompressor::IsEnabled(m_encoding);
+}
+
 std::string Transport::getHTTPVersion() const {
   return "1.1";
 }
@@ -621,7 +677,7 @@ void Transport::prepareHeaders(bool compressed, const void *data, int size) {
   }
 
   if (compressed) {
-    addHeaderImpl("Content-Encoding", "gzip");
+    addHeaderImpl("Content-Encoding", get_encoding_name(m_encoding));
     removeHeaderImpl("Content-Length");
     if (m_responseHeaders.find("Content-MD5") != m_responseHeaders.end()) {
       String response((const char *)data, size, AttachLiteral);
@@ -677,13 +733,27 @@ String Transport::prepareResponse(const void *data, int size, bool &compressed,
   // where we don't really know if next chunk will benefit from compresseion.
   if (m_chunkedEncoding || size > 1000 ||
       m_compressionDecision == HasToCompress) {
-    if (m_compressor == NULL) {
-      m_compressor = new StreamCompressor(RuntimeOption::GzipCompressionLevel,
-                                          CODING_GZIP, true);
+    if (!m_chunkedEncoding &&
+        RuntimeOption::GzipCompressionOffloadThreshold > 0 &&
+        size >= RuntimeOption::GzipCompressionOffloadThreshold &&
+        supportsCompressionOffload()) {
+      m_compressionOffloaded = true;
+      compressed = true;
+      return response;
     }
     int len = size;
-    char *compressedData =
-      m_compressor->compress((const char*)data, len, last);
+    char *compressedData;
+    if (m_chunkedEncoding) {
+      if (m_compressor == NULL) {
+        m_compressor =
+          new StreamCompressor(ResponseCompressor::GetLevel(m_encoding),
+                               m_encoding, m_encoding == CODING_GZIP);
+      }
+      compressedData = m_compressor->compress((const char*)data, len, last);
+    } else {
+      compressedData =
+        ResponseCompressor::Compress((const char*)data, len, m_encoding);
+    }
     if (compressedData) {
       String deleter(compressedData, len, AttachString);
       if (m_chunkedEncoding || len < size ||
@@ -692,8 +762,9 @@ String Transport::prepareResponse(const void *data, int size, bool &compressed,
         compressed = true;
       }
     } else {
-      Logger::Error("Unable to compress response: level=%d len=%d",
-                    RuntimeOption::GzipCompressionLevel, len);
+      Logger::Error("Unable to compress response: encoding=%s level=%d len=%d",
+                    get_encoding_name(m_encoding),
+                    ResponseCompressor::GetLevel(m_encoding), len);
     }
   }
 
@@ -722,9 +793,13 @@ void Transport::sendRawLocked(void *data, int size, int code /* = 200 */,
     return;
   }
 
-  // compression handling
+  // compression handling, with nothing to compress in a sendStatic() file
+  // sent straight from disk
   ServerStatsHelper ssh("send");
-  String response = prepareResponse(data, size, compressed, !chunked);
+  String response;
+  if (data) {
+    response = prepareResponse(data, size, compressed, !chunked);
+  }
 
   if (m_responseCode < 0) {
     m_responseCode = code;
@@ -737,15 +812,16 @@ void Transport::sendRawLocked(void *data, int size, int code /* = 200 */,
     m_headerSent = true;
   }
 
-  m_responseSize += response.size();
+  int sentSize = data ? response.size() : size;
+  m_responseSize += sentSize;
   ServerStats::SetThreadMode(ServerStats::Writing);
-  sendImpl(response.data(), response.size(), m_responseCode, chunked);
+  sendImpl(data ? response.data() : NULL, sentSize, m_responseCode, chunked);
   ServerStats::SetThreadMode(ServerStats::Processing);
 
   ServerStats::LogBytes(size);
   if (RuntimeOption::EnableStats && RuntimeOption::EnableWebStats) {
     ServerStats::Log("network.uncompressed", size);
-    ServerStats::Log("network.compressed", response.size());
+    ServerStats::Log("network.compressed", sentSize);
   }
 }
 
@@ -758,6 +834,44 @@ void Transport::sendRaw(void *data, int size, int code /* = 200 */,
   sendRawLocked(data, size, code, compressed, chunked, codeInfo);
 }
 
+/**
+ * Reads up to "size" bytes from the start of a file, fewer if it shrank.
+ */
+static String read_static_file(int fd, int size) {
+  char *buf = (char *)malloc(size + 1);
+  int len = 0;
+  while (len < size) {
+    ssize_t n = pread(fd, buf + len, size - len, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    len += n;
+  }
+  buf[len] = '\0';
+  return String(buf, len, AttachString);
+}
+
+void Transport::sendStatic(const char *data, int size, bool compressed,
+                           int fd /* = -1 */) {
+  FiberWriteLock lock(this);
+  ASSERT(data || (fd >= 0 && !compressed));
+  // a body compressed on the fly or sent in chunks is not where the
+  // caller's data lives
+  m_directSend = supportsDirectSend() && !m_chunkedEncoding &&
+    (compressed ||
+     (!isCompressionEnabled() && !RuntimeOption::ForceChunkedEncoding));
+  String body;
+  if (!data && !m_directSend) {
+    body = read_static_file(fd, size);
+    data = body.data();
+    size = body.size();
+    fd = -1;
+  }
+  m_directSendFd = fd;
+  sendRawLocked((void*)data, size, 200, compressed);
+  m_directSend = false;
+  m_directSendFd = -1;
+}
+
 void Transport::onSendEnd() {
   FiberWriteLock lock(this);
   if (m_compressor && m_chunkedEncoding) {
@@ -148,13 +148,36 @@ public:
   void setDefaultContentType(bool send) { m_sendContentType = send;}
 
   /**
-   * Can we gzip response?
+   * Can we compress response?
    */
   void enableCompression() { m_compression = true;}
   void disableCompression() { m_compression = false;}
-  bool isCompressionEnabled() const {
-    return m_compression && RuntimeOption::GzipCompressionLevel;
-  }
+  bool isCompressionEnabled() const;
+
+  /**
+   * Content encoding picked by decideCompression(), CODING_GZIP unless the
+   * client takes a better one that is turned on.
+   */
+  int getContentEncoding() const { return m_encoding;}
+
+  /**
+   * Whether the lower level transport can compress a large response after
+   * sendImpl() on a thread of its own. If so, prepareResponse() leaves the
+   * body uncompressed and isCompressionOffloaded() tells sendImpl() to have
+   * it compressed.
+   */
+  virtual bool supportsCompressionOffload() { return false;}
+  bool isCompressionOffloaded() const { return m_compressionOffloaded;}
+
+  /**
+   * Whether sendImpl() can write a sendStatic() body to the client straight
+   * from where it lives. If so, isDirectSend() is true during that
+   * sendImpl() and getDirectSendFd() is the file to sendfile() it from, or
+   * -1 to write it from memory.
+   */
+  virtual bool supportsDirectSend() { return false;}
+  bool isDirectSend() const { return m_directSend;}
+  int getDirectSendFd() const { return m_directSendFd;}
 
   /**
    * Set cookie response header.
@@ -262,6 +285,14 @@ public:
    */
   bool acceptEncoding(const char *encoding);
 
+  /**
+   * Whether an Accept-Encoding header takes a content coding: a whole,
+   * case-insensitive token match that honors "q=0". With "wildcard", a "*"
+   * entry also covers codings the header does not list.
+   */
+  static bool AcceptsCoding(const std::string &header, const char *coding,
+                            bool wildcard);
+
   /**
    * Test whether cookie header has the "name=".
    */
@@ -273,7 +304,8 @@ public:
   std::string getCookie(const std::string &name);
 
   /**
-   * Test whether client is okay to accept compressed response.
+   * Test whether client is okay to accept compressed response, and pick the
+   * content encoding to compress it with.
    */
   bool decideCompression();
 
@@ -314,6 +346,16 @@ public:
     sendRaw((void*)data.c_str(), data.length(), code, compressed, chunked,
             codeInfo);
   }
+
+  /**
+   * Sends a static file with code 200 without copying it into a response
+   * buffer where the transport allows. "data" has to stay valid until the
+   * response is finished, as with the static content cache. A file on disk
+   * comes as "fd" with a NULL "data" instead, and is only read into memory
+   * where it can't be sendfile()d. It's never mapped, which would raise
+   * SIGBUS once the file shrank while being served.
+   */
+  void sendStatic(const char *data, int size, bool compressed, int fd = -1);
   void redirect(const char *location, int code, const char *info );
 
   // TODO: support rfc1867
@@ -381,6 +423,10 @@ protected:
   bool m_sendContentType;
   bool m_compression;
   StreamCompressor *m_compressor;
+  bool m_compressionOffloaded;
+  bool m_directSend;
+  int m_directSendFd;
+  int m_encoding;
 
   bool m_isSSL;
 
@@ -234,7 +234,8 @@ static int read_post(multipart_buffer *self, char *buf, int bytes_to_read) {
     int extra_byte_read = 0;
     const void *extra = self->transport->getMorePostData(extra_byte_read);
     if (extra_byte_read == 0) break;
-    if (RuntimeOption::AlwaysPopulateRawPostData) {
+    if (RuntimeOption::AlwaysPopulateRawPostData &&
+        !RuntimeOption::StreamRequestBody) {
       self->post_data = (const char *)Util::buffer_append(
         self->post_data, self->post_size, extra, extra_byte_read);
       self->cursor = (char*)self->post_data + self->post_size;
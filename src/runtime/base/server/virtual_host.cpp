@@ -20,6 +20,7 @@
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/comparisons.h>
 #include <runtime/base/timeout_thread.h>
+#include <runtime/base/server/concurrency_limiter.h>
 #include <runtime/base/string_util.h>
 #include <util/util.h>
 
@@ -85,6 +86,8 @@ void VirtualHost::initRuntimeOption(Hdf overwrite) {
   m_runtimeOption.requestTimeoutSeconds = requestTimeoutSeconds;
   m_runtimeOption.maxPostSize = maxPostSize;
   m_runtimeOption.uploadMaxFileSize = uploadMaxFileSize;
+  m_runtimeOption.concurrencyPriority = ConcurrencyLimiter::ParsePriority
+    (overwrite["Server.ConcurrencyLimit.Priority"].get("normal"));
 }
 
 void VirtualHost::setRequestTimeoutSeconds() const {
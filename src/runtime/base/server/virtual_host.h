@@ -53,6 +53,9 @@ public:
   bool valid() const { return !(m_prefix.empty() && m_pattern.empty()); }
   bool match(const std::string &host) const;
   bool disabled() const { return m_disabled; }
+  int getConcurrencyPriority() const {
+    return m_runtimeOption.concurrencyPriority;
+  }
 
   // url rewrite rules
   bool rewriteURL(CStrRef host, String &url, bool &qsa, int &redirect) const;
@@ -96,6 +99,7 @@ private:
     int64 maxPostSize;
     int64 uploadMaxFileSize;
     std::vector<std::string> allowedDirectories;
+    int concurrencyPriority;
   };
 
   void initRuntimeOption(Hdf overwrite);
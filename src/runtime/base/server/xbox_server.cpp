@@ -18,6 +18,7 @@
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/server/rpc_request_handler.h>
 #include <runtime/base/server/satellite_server.h>
+#include <runtime/base/server/shared_worker_pool.h>
 #include <runtime/base/util/libevent_http_client.h>
 #include <runtime/ext/ext_json.h>
 #include <util/job_queue.h>
@@ -150,42 +151,67 @@ static IMPLEMENT_THREAD_LOCAL(XboxServerInfoPtr, s_xbox_server_info);
 static IMPLEMENT_THREAD_LOCAL(XboxRequestHandler, s_xbox_request_handler);
 ///////////////////////////////////////////////////////////////////////////////
 
+static RequestHandler *create_xbox_request_handler() {
+  if (!*s_xbox_server_info) {
+    *s_xbox_server_info = XboxServerInfoPtr(new XboxServerInfo());
+  }
+  if (RuntimeOption::XboxServerLogInfo) XboxRequestHandler::Info = true;
+  s_xbox_request_handler->setServerInfo(*s_xbox_server_info);
+  s_xbox_request_handler->setReturnEncodeType(RPCRequestHandler::Serialize);
+  if (s_xbox_request_handler->needReset() ||
+      s_xbox_request_handler->incRequest() >
+      (*s_xbox_server_info)->getMaxRequest()) {
+    Logger::Verbose("resetting xbox request handler");
+    s_xbox_request_handler.destroy();
+    s_xbox_request_handler->setServerInfo(*s_xbox_server_info);
+    s_xbox_request_handler->setReturnEncodeType(RPCRequestHandler::Serialize);
+    s_xbox_request_handler->incRequest();
+  }
+  return s_xbox_request_handler.get();
+}
+
+static void run_xbox(XboxTransport *job) {
+  try {
+    job->onRequestStart(job->getStartTimer());
+    create_xbox_request_handler()->handleRequest(job);
+    job->decRefCount();
+  } catch (...) {
+    Logger::Error("RpcRequestHandler leaked exceptions");
+  }
+}
+
 class XboxWorker : public JobQueueWorker<XboxTransport*, true> {
 public:
   virtual void doJob(XboxTransport *job) {
-    try {
-      job->onRequestStart(job->getStartTimer());
-      createRequestHandler()->handleRequest(job);
-      job->decRefCount();
-    } catch (...) {
-      Logger::Error("RpcRequestHandler leaked exceptions");
-    }
+    run_xbox(job);
   }
-private:
-  RequestHandler *createRequestHandler() {
-    if (!*s_xbox_server_info) {
-      *s_xbox_server_info = XboxServerInfoPtr(new XboxServerInfo());
-    }
-    if (RuntimeOption::XboxServerLogInfo) XboxRequestHandler::Info = true;
-    s_xbox_request_handler->setServerInfo(*s_xbox_server_info);
-    s_xbox_request_handler->setReturnEncodeType(RPCRequestHandler::Serialize);
-    if (s_xbox_request_handler->needReset() ||
-        s_xbox_request_handler->incRequest() >
-        (*s_xbox_server_info)->getMaxRequest()) {
-      Logger::Verbose("resetting xbox request handler");
-      s_xbox_request_handler.destroy();
-      s_xbox_request_handler->setServerInfo(*s_xbox_server_info);
-      s_xbox_request_handler->setReturnEncodeType(RPCRequestHandler::Serialize);
-      s_xbox_request_handler->incRequest();
-    }
-    return s_xbox_request_handler.get();
+};
+
+class XboxPoolJob : public SharedWorkerJob {
+public:
+  XboxPoolJob(XboxTransport *job) : m_job(job) {}
+
+  virtual void run(int worker) {
+    run_xbox(m_job);
   }
+
+private:
+  XboxTransport *m_job;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 static JobQueueDispatcher<XboxTransport*, XboxWorker> *s_dispatcher;
 
+static void enqueue_job(XboxTransport *job) {
+  if (s_dispatcher) {
+    s_dispatcher->enqueue(job);
+  } else {
+    SharedWorkerPool::Enqueue(SharedWorkerPool::XboxJob,
+                              new XboxPoolJob(job));
+  }
+}
+
 void XboxServer::Restart() {
   if (s_dispatcher) {
     s_dispatcher->stop();
@@ -193,13 +219,18 @@ void XboxServer::Restart() {
     s_dispatcher = NULL;
   }
 
-  if (RuntimeOption::XboxServerThreadCount > 0) {
+  if (RuntimeOption::XboxServerThreadCount > 0 &&
+      SharedWorkerPool::Enabled()) {
+    if (RuntimeOption::XboxServerLogInfo) {
+      Logger::Info("xbox server started on shared worker pool");
+    }
+  } else if (RuntimeOption::XboxServerThreadCount > 0) {
     s_dispatcher = new JobQueueDispatcher<XboxTransport*, XboxWorker>
       (RuntimeOption::XboxServerThreadCount,
        RuntimeOption::ServerThreadRoundRobin,
        RuntimeOption::ServerThreadDropCacheTimeoutSeconds,
        RuntimeOption::ServerThreadDropStack,
-       NULL);
+       NULL, false, RuntimeOption::XboxServerThreadJobStealing);
     if (RuntimeOption::XboxServerLogInfo) {
       Logger::Info("xbox server started");
     }
@@ -224,8 +255,7 @@ bool XboxServer::SendMessage(CStrRef message, Variant &ret, int timeout_ms,
     XboxTransport *job = new XboxTransport(message);
     job->incRefCount(); // paired with worker's decRefCount()
     job->incRefCount(); // paired with decRefCount() at below
-    ASSERT(s_dispatcher);
-    s_dispatcher->enqueue(job);
+    enqueue_job(job);
 
     if (timeout_ms <= 0) {
       timeout_ms = RuntimeOption::XboxDefaultLocalTimeoutMilliSeconds;
@@ -295,8 +325,7 @@ bool XboxServer::PostMessage(CStrRef message,
 
     XboxTransport *job = new XboxTransport(message);
     job->incRefCount(); // paired with worker's decRefCount()
-    ASSERT(s_dispatcher);
-    s_dispatcher->enqueue(job);
+    enqueue_job(job);
     return true;
 
   } else { // remote
@@ -356,10 +385,16 @@ StaticString XboxTask::s_class_name("XboxTask");
 ///////////////////////////////////////////////////////////////////////////////
 
 bool XboxServer::Available() {
-  return s_dispatcher->getActiveWorker() <
-         RuntimeOption::XboxServerThreadCount ||
-         s_dispatcher->getQueuedJobs() <
-         RuntimeOption::XboxServerMaxQueueLength;
+  int active, queued;
+  if (s_dispatcher) {
+    active = s_dispatcher->getActiveWorker();
+    queued = s_dispatcher->getQueuedJobs();
+  } else {
+    active = SharedWorkerPool::GetActiveWorker(SharedWorkerPool::XboxJob);
+    queued = SharedWorkerPool::GetQueuedJobs(SharedWorkerPool::XboxJob);
+  }
+  return active < RuntimeOption::XboxServerThreadCount ||
+         queued < RuntimeOption::XboxServerMaxQueueLength;
 }
 
 Object XboxServer::TaskStart(CStrRef message) {
@@ -375,8 +410,7 @@ Object XboxServer::TaskStart(CStrRef message) {
   if (transport) {
     job->setHost(transport->getHeader("Host"));
   }
-  ASSERT(s_dispatcher);
-  s_dispatcher->enqueue(job);
+  enqueue_job(job);
 
   return ret;
 }
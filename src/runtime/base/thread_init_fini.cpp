@@ -51,6 +51,7 @@ void init_thread_locals(void *arg /* = NULL */) {
   s_hasRenamedFunction.getCheck();
   if (has_eval_support) {
     Eval::VariableEnvironment::InitTempStack();
+    Eval::VariableEnvironment::InitSlotStack();
     ArgArray::s_stack.getCheck();
   }
 }
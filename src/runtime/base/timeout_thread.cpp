@@ -131,7 +131,7 @@ void TimeoutThread::onTimer(int index) {
   ASSERT(data);
   struct timeval timeout;
   timeout.tv_usec = 0;
-  if (data->started > 0) {
+  if (data->started > 0 && data->timeoutSeconds > 0) {
     time_t now = time(0);
     int delta = now - data->started;
     if (delta >= m_timeoutSeconds) {
@@ -99,6 +99,21 @@ static int64 ToKey(double d) { return (int64)d; }
 static VarNR ToKey(CStrRef s) { return s.toKey(); }
 static VarNR ToKey(CVarRef v) { return v.toKey(); }
 
+/**
+ * Objects of compiled classes whose declared properties all live inside the
+ * object can be created from their callbacks and have properties written by
+ * offset; anything else (eval'd classes, redeclared parents) can't.
+ */
+static const ObjectStaticCallbacks *
+get_unserialize_callbacks(ObjectData *obj, CStrRef clsName) {
+  const ObjectStaticCallbacks *osc = obj->o_get_callbacks();
+  if (!osc || osc->redeclaredParent || !osc->cls ||
+      !(*osc->cls)->isame(clsName.get())) {
+    return NULL;
+  }
+  return osc;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // private implementations
 
@@ -3803,14 +3818,22 @@ void Variant::unserialize(VariableUnserializer *uns) {
         throw Exception("Expected ':' but got '%c'", sep);
       }
 
+      VariableUnserializer::ClassCacheEntry &cls =
+        uns->getClassCacheEntry(clsName);
       Object obj;
-      try {
-        obj = create_object_only(clsName);
-      } catch (ClassNotFoundException &e) {
-        obj = create_object_only(s_PHP_Incomplete_Class);
-        obj->o_set(s_PHP_Incomplete_Class_Name, clsName);
+      if (cls.cb) {
+        obj = cls.cb->createOnly();
+      } else {
+        try {
+          obj = create_object_only(clsName);
+          cls.cb = get_unserialize_callbacks(obj.get(), clsName);
+        } catch (ClassNotFoundException &e) {
+          obj = create_object_only(s_PHP_Incomplete_Class);
+          obj->o_set(s_PHP_Incomplete_Class_Name, clsName);
+        }
       }
       operator=(obj);
+      bool useSlots = cls.cb && !obj->getAttribute(ObjectData::UseGet);
       int64 size = uns->readInt();
       char sep = uns->readChar();
       if (sep != ':') {
@@ -3823,6 +3846,15 @@ void Variant::unserialize(VariableUnserializer *uns) {
       if (size > 0) {
         for (int64 i = 0; i < size; i++) {
           String key = uns->unserializeKey().toString();
+          if (useSlots) {
+            hphp_hash_map<String, int, hphp_string_hash,
+                          hphp_string_same>::const_iterator it =
+              cls.props.find(key);
+            if (it != cls.props.end()) {
+              ((Variant*)((char*)obj.get() + it->second))->unserialize(uns);
+              continue;
+            }
+          }
           int subLen = 0;
           if (key.size() > 0 && key.charAt(0) == '\00') {
             if (key.charAt(1) == '*') {
@@ -3834,13 +3866,21 @@ void Variant::unserialize(VariableUnserializer *uns) {
               }
             }
           }
+          String propName = subLen != 0 ? key.substr(subLen) : key;
+          String context = subLen != 0 ?
+            (key.charAt(1) == '*' ? clsName :
+             String(key.data() + 1, subLen - 2, AttachLiteral)) :
+            null_string;
+          if (useSlots) {
+            Variant *slot =
+              obj->o_realProp(propName, ObjectData::RealPropWrite |
+                              ObjectData::RealPropNoDynamic, context);
+            if (slot) {
+              cls.props[key] = (char*)slot - (char*)obj.get();
+            }
+          }
           Variant tmp;
-          Variant &value = subLen != 0 ?
-            (key.charAt(1) == '*' ?
-             obj->o_lval(key.substr(subLen), tmp, clsName) :
-             obj->o_lval(key.substr(subLen), tmp,
-                         String(key.data() + 1, subLen - 2, AttachLiteral)))
-            : obj->o_lval(key, tmp);
+          Variant &value = obj->o_lval(propName, tmp, context);
           value.unserialize(uns);
         }
       }
@@ -27,6 +27,7 @@
 #include <runtime/base/array/array_iterator.h>
 #include <runtime/base/util/request_local.h>
 #include <runtime/ext/ext_json.h>
+#include <util/job_queue.h>
 
 using namespace std;
 
@@ -68,7 +69,9 @@ String VariableSerializer::serialize(CVarRef v, bool ret) {
     buf.setOutputLimit(RuntimeOption::SerializationSizeLimit);
   }
   m_valueCount = 1;
-  write(v);
+  if (!serializeParallel(v)) {
+    write(v);
+  }
   if (ret) {
     return m_buf->detach();
   } else {
@@ -733,6 +736,53 @@ void VariableSerializer::writeArrayKey(const ArrayData *arr, Variant key) {
   }
 }
 
+void VariableSerializer::writeScalarArrayKey(int64 ikey, CStrRef skey) {
+  ASSERT(!m_arrayInfos.back().is_object);
+  switch (m_type) {
+  case PrintR:
+    indent();
+    m_buf->append('[');
+    if (skey.isNull()) {
+      m_buf->append(ikey);
+    } else {
+      m_buf->append(skey.data(), skey.size());
+    }
+    m_buf->append("] => ");
+    break;
+  case VarExport:
+    indent();
+    if (skey.isNull()) {
+      write(ikey);
+    } else {
+      write(skey.data(), skey.size(), true);
+    }
+    m_buf->append(" => ");
+    break;
+  case VarDump:
+    indent();
+    if (skey.isNull()) {
+      m_buf->append('[');
+      m_buf->append(ikey);
+      m_buf->append("]=>\n");
+    } else {
+      m_buf->append("[\"");
+      m_buf->append(skey.data(), skey.size());
+      m_buf->append("\"]=>\n");
+    }
+    break;
+  case Serialize:
+    if (skey.isNull()) {
+      write(ikey);
+    } else {
+      write(skey.data(), skey.size());
+    }
+    break;
+  default:
+    ASSERT(false);
+    break;
+  }
+}
+
 void VariableSerializer::writeArrayValue(const ArrayData *arr, CVarRef value) {
   // Do not count referenced values after the first
   if ((m_type == Serialize || m_type == APCSerialize ||
@@ -821,6 +871,117 @@ void VariableSerializer::writeSerializableObject(CStrRef clsname,
   m_buf->append('}');
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// parallel serialization
+
+/**
+ * Keys and values of a large array are pulled out on the request thread, so
+ * workers only ever read scalar data and never touch reference counts or the
+ * request's memory manager.
+ */
+struct SerializeElement {
+  int64 ikey;
+  String skey; // null for integer keys
+  const Variant *value;
+};
+
+struct SerializeChunk {
+  SerializeChunk(VariableSerializer::Type type, int option, int maxCount)
+    : serializer(type, option, maxCount) {}
+  VariableSerializer serializer;
+  const ArrayData *arr;
+  const std::vector<SerializeElement> *elements;
+  size_t begin;
+  size_t end;
+  StringBuffer buf;
+};
+
+class SerializeChunkList : public std::vector<SerializeChunk*> {
+public:
+  ~SerializeChunkList() {
+    for (unsigned int i = 0; i < size(); i++) {
+      delete (*this)[i];
+    }
+  }
+};
+
+class SerializeChunkWorker : public JobQueueWorker<SerializeChunk*> {
+public:
+  virtual void doJob(SerializeChunk *chunk) {
+    VariableSerializer *serializer = &chunk->serializer;
+    const std::vector<SerializeElement> &elements = *chunk->elements;
+    for (size_t i = chunk->begin; i < chunk->end; i++) {
+      const SerializeElement &e = elements[i];
+      serializer->writeScalarArrayKey(e.ikey, e.skey);
+      serializer->writeArrayValue(chunk->arr, *e.value);
+    }
+  }
+};
+
+bool VariableSerializer::serializeParallel(CVarRef v) {
+  int64 threshold = RuntimeOption::ParallelSerializationThreshold;
+  int threadCount = RuntimeOption::ParallelSerializationThreadCount;
+  if (threshold <= 0 || threadCount <= 1) return false;
+  if (m_type != PrintR && m_type != VarExport && m_type != VarDump &&
+      m_type != Serialize) {
+    return false;
+  }
+  if (v.getRawType() != KindOfArray) return false;
+  const ArrayData *arr = v.getArrayData();
+  if (arr->size() < threshold || arr->isSharedMap()) return false;
+
+  std::vector<SerializeElement> elements;
+  elements.reserve(arr->size());
+  for (ArrayIter iter(arr); iter; ++iter) {
+    CVarRef value = iter.secondRef();
+    if (value.getRawType() > KindOfString) return false;
+    elements.push_back(SerializeElement());
+    SerializeElement &e = elements.back();
+    Variant key(iter.first());
+    if (key.isInteger()) {
+      e.ikey = key.toInt64();
+    } else {
+      e.ikey = 0;
+      e.skey = key.toString();
+    }
+    e.value = &value;
+  }
+
+  setReferenced(false);
+  incNestedLevel((void*)arr);
+  writeArrayHeader(arr, elements.size());
+
+  // a few chunks per thread, so uneven element sizes still balance out
+  size_t chunkCount = threadCount * 4;
+  size_t chunkSize = (elements.size() + chunkCount - 1) / chunkCount;
+  SerializeChunkList chunks;
+  JobQueueDispatcher<SerializeChunk*, SerializeChunkWorker>
+    dispatcher(threadCount, true, 0, false, NULL);
+  for (size_t begin = 0; begin < elements.size(); begin += chunkSize) {
+    SerializeChunk *chunk = new SerializeChunk(m_type, m_option, m_maxCount);
+    chunks.push_back(chunk);
+    chunk->serializer.m_buf = &chunk->buf;
+    chunk->serializer.m_indent = m_indent;
+    chunk->serializer.m_arrayInfos.push_back(m_arrayInfos.back());
+    chunk->arr = arr;
+    chunk->elements = &elements;
+    chunk->begin = begin;
+    chunk->end = std::min(begin + chunkSize, elements.size());
+    dispatcher.enqueue(chunk);
+  }
+  dispatcher.run();
+
+  for (unsigned int i = 0; i < chunks.size(); i++) {
+    m_buf->append(chunks[i]->buf.data(), chunks[i]->buf.size());
+  }
+  m_valueCount += elements.size();
+  m_arrayInfos.back().first_element = false;
+
+  writeArrayFooter(arr);
+  decNestedLevel((void*)arr);
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void VariableSerializer::indent() {
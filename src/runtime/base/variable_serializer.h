@@ -85,6 +85,9 @@ public:
 
   void writeArrayHeader(const ArrayData *arr, int size);
   void writeArrayKey(const ArrayData *arr, Variant key);
+  // Same as writeArrayKey() for a plain array, but never copies the key, so
+  // it is safe to call from parallel serialization workers.
+  void writeScalarArrayKey(int64 ikey, CStrRef skey);
   void writeArrayValue(const ArrayData *arr, CVarRef value);
   void writeArrayFooter(const ArrayData *arr);
   void writeSerializableObject(CStrRef clsname, CStrRef serialized);
@@ -129,6 +132,7 @@ private:
   };
   std::vector<ArrayInfo> m_arrayInfos;
 
+  bool serializeParallel(CVarRef v);
   void writePropertyPrivacy(CStrRef prop, const ClassInfo *cls);
   void writeSerializedProperty(CStrRef prop, const ClassInfo *cls);
 };
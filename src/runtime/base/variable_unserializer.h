@@ -18,10 +18,13 @@
 #define __HPHP_VARIABLE_UNSERIALIZER_H__
 
 #include <runtime/base/types.h>
+#include <runtime/base/complex_types.h>
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+struct ObjectStaticCallbacks;
+
 class VariableUnserializer {
 public:
   /**
@@ -69,6 +72,21 @@ public:
   }
   const char *head() { return m_buf; }
 
+  /**
+   * Class names resolved during this unserialize(), with the object offsets
+   * of declared properties keyed by their serialized (mangled) names. Only
+   * compiled classes whose properties all live in the object itself get
+   * "cb" set; everything else goes through create_object_only()/o_lval().
+   */
+  struct ClassCacheEntry {
+    ClassCacheEntry() : cb(NULL) {}
+    const ObjectStaticCallbacks *cb;
+    hphp_hash_map<String, int, hphp_string_hash, hphp_string_same> props;
+  };
+  ClassCacheEntry &getClassCacheEntry(CStrRef clsName) {
+    return m_classes[clsName];
+  }
+
  private:
   Type m_type;
   const char *m_buf;
@@ -76,6 +94,8 @@ public:
   std::vector<Variant*> m_refs;
   bool m_key;
   bool m_unknownSerializable;
+  hphp_hash_map<String, ClassCacheEntry, hphp_string_hash,
+                hphp_string_same> m_classes;
 
   void check() {
     if (m_buf >= m_end) {
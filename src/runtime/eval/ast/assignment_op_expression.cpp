@@ -18,6 +18,7 @@
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/strict_mode.h>
 #include <runtime/eval/ast/variable_expression.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 #include <util/parser/hphp.tab.hpp>
 
 namespace HPHP {
@@ -110,6 +111,20 @@ Variant VariableAssignmentExpression::refval(VariableEnvironment &env,
   return strongBind(eval(env));
 }
 
+void VariableAssignmentExpression::byteCode(ByteCodeProgram &code,
+                                            int dst) const {
+  if (!ByteCodeProgram::IsLowered(m_rhs.get())) {
+    // no gain from splitting "$a = f()" in two
+    Expression::byteCode(code, dst);
+    return;
+  }
+  int mark = code.regMark();
+  int rhs = code.operand(m_rhs.get());
+  code.releaseRegs(mark);
+  code.emit(ByteCodeProgram::StoreLocal, dst, rhs, 0,
+            static_cast<const VariableExpression *>(m_lhs.get()));
+}
+
 void VariableAssignmentExpression::dump(std::ostream &out) const {
   m_lhs->dump(out);
   out << " = ";
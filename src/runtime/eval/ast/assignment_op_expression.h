@@ -48,6 +48,7 @@ public:
                                const Location *loc);
   virtual Variant eval(VariableEnvironment &env) const;
   virtual Variant refval(VariableEnvironment &env, int strict = 2) const;
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump(std::ostream &out) const;
 private:
   LvalExpressionPtr m_lhs;
@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/binary_op_expression.h>
 #include <runtime/eval/ast/scalar_value_expression.h>
 #include <runtime/eval/ast/variable_expression.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 #include <util/parser/hphp.tab.hpp>
 
 namespace HPHP {
@@ -99,6 +100,29 @@ Expression *BinaryOpExpression::optimize(VariableEnvironment &env) {
       vce->addElement(m_exp2);
       return vce;
     }
+    // "a" . ($b . "c") can be spliced into one vector as long as neither
+    // side starts with a variable, which VectorConcatExpression::eval()
+    // reads out of order
+    std::vector<ExpressionPtr> rhs;
+    if (m_exp2->isKindOf(KindOfVectorConcatExpression)) {
+      rhs = static_cast<VectorConcatExpression *>(m_exp2.get())->exps();
+    } else if (m_exp2->isKindOf(KindOfBinaryOpExpression)) {
+      BinaryOpExpression *binOpExp =
+        static_cast<BinaryOpExpression *>(m_exp2.get());
+      if (binOpExp->m_op == '.') {
+        rhs.push_back(binOpExp->m_exp1);
+        rhs.push_back(binOpExp->m_exp2);
+      }
+    }
+    if (!rhs.empty() && !m_exp1->isKindOf(KindOfVariableExpression) &&
+        !rhs[0]->isKindOf(KindOfVariableExpression)) {
+      VectorConcatExpression *vce =
+        new VectorConcatExpression(m_exp1, loc());
+      for (unsigned int i = 0; i < rhs.size(); i++) {
+        vce->addElement(rhs[i]);
+      }
+      return vce;
+    }
   }
   setOperandKindOf();
   return NULL;
@@ -147,8 +171,21 @@ Variant BinaryOpExpression::eval(VariableEnvironment &env) const {
   default:
     assert(false);
   }
-  CVarRef v1 = *v1p;
-  CVarRef v2 = *v2p;
+  return evalOp(*v1p, *v2p);
+}
+
+void BinaryOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  if (dst == ByteCodeProgram::NoReg) dst = code.allocReg();
+  // Locals are only read when the op runs, after any code for the other
+  // operand, which keeps the VDR evaluation order of eval().
+  int mark = code.regMark();
+  int v1 = code.operand(m_exp1.get());
+  int v2 = code.operand(m_exp2.get());
+  code.releaseRegs(mark);
+  code.emit(ByteCodeProgram::BinOp, dst, v1, v2, this);
+}
+
+Variant BinaryOpExpression::evalOp(CVarRef v1, CVarRef v2) const {
   Variant::TypedValueAccessor acc1 = v1.getTypedAccessor();
   Variant::TypedValueAccessor acc2 = v2.getTypedAccessor();
   DataType t1 = Variant::GetAccessorType(acc1);
@@ -520,6 +557,10 @@ Expression *LogicalOrExpression::optimize(VariableEnvironment &env) {
   if (evalScalar(env, v)) {
     return new ScalarValueExpression(v, loc());
   }
+  // m_exp2 is never evaluated after a true scalar
+  if (m_exp1->evalScalar(env, v) && v.toBoolean()) {
+    return new ScalarValueExpression(true, loc());
+  }
   return NULL;
 }
 
@@ -527,6 +568,21 @@ Variant LogicalOrExpression::eval(VariableEnvironment &env) const {
   return m_exp1->eval(env) || m_exp2->eval(env);
 }
 
+void LogicalOrExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  if (dst == ByteCodeProgram::NoReg) dst = code.allocReg();
+  int mark = code.regMark();
+  int v1 = code.operand(m_exp1.get());
+  int shortCut = code.emit(ByteCodeProgram::JmpNZ, 0, v1);
+  code.releaseRegs(mark);
+  int v2 = code.operand(m_exp2.get());
+  code.releaseRegs(mark);
+  code.emit(ByteCodeProgram::Bool, dst, v2);
+  int done = code.emit(ByteCodeProgram::Jmp);
+  code.patch(shortCut, code.here());
+  code.emit(ByteCodeProgram::Bool, dst, code.constant(true_varNR));
+  code.patch(done, code.here());
+}
+
 bool LogicalOrExpression::evalScalar(
   VariableEnvironment &env, Variant &r) const {
   Variant v1;
@@ -565,6 +621,10 @@ Expression *LogicalAndExpression::optimize(VariableEnvironment &env) {
   if (evalScalar(env, v)) {
     return new ScalarValueExpression(v, loc());
   }
+  // m_exp2 is never evaluated after a false scalar
+  if (m_exp1->evalScalar(env, v) && !v.toBoolean()) {
+    return new ScalarValueExpression(false, loc());
+  }
   return NULL;
 }
 
@@ -572,6 +632,21 @@ Variant LogicalAndExpression::eval(VariableEnvironment &env) const {
   return m_exp1->eval(env) && m_exp2->eval(env);
 }
 
+void LogicalAndExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  if (dst == ByteCodeProgram::NoReg) dst = code.allocReg();
+  int mark = code.regMark();
+  int v1 = code.operand(m_exp1.get());
+  int shortCut = code.emit(ByteCodeProgram::JmpZ, 0, v1);
+  code.releaseRegs(mark);
+  int v2 = code.operand(m_exp2.get());
+  code.releaseRegs(mark);
+  code.emit(ByteCodeProgram::Bool, dst, v2);
+  int done = code.emit(ByteCodeProgram::Jmp);
+  code.patch(shortCut, code.here());
+  code.emit(ByteCodeProgram::Bool, dst, code.constant(false_varNR));
+  code.patch(done, code.here());
+}
+
 bool LogicalAndExpression::evalScalar(
   VariableEnvironment &env, Variant &r) const {
   Variant v1;
@@ -34,7 +34,9 @@ public:
   virtual Expression *optimize(VariableEnvironment &env);
   virtual bool evalScalar(VariableEnvironment &env, Variant &r) const;
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump(std::ostream &out) const;
+  Variant evalOp(CVarRef v1, CVarRef v2) const;
 private:
   enum OperandKindOf {
     VVN,
@@ -62,6 +64,7 @@ public:
   virtual Variant eval(VariableEnvironment &env) const;
   virtual void dump(std::ostream &out) const;
   void addElement(ExpressionPtr exp);
+  const std::vector<ExpressionPtr> &exps() const { return m_exps; }
 private:
   std::vector<ExpressionPtr> m_exps;
 };
@@ -73,6 +76,7 @@ public:
   virtual Expression *optimize(VariableEnvironment &env);
   virtual bool evalScalar(VariableEnvironment &env, Variant &r) const;
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump(std::ostream &out) const;
   ExpressionPtr m_exp1;
   ExpressionPtr m_exp2;
@@ -86,6 +90,7 @@ public:
   virtual Expression *optimize(VariableEnvironment &env);
   virtual bool evalScalar(VariableEnvironment &env, Variant &r) const;
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump(std::ostream &out) const;
   ExpressionPtr m_exp1;
   ExpressionPtr m_exp2;
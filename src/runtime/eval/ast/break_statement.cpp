@@ -16,7 +16,9 @@
 
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/break_statement.h>
+#include <runtime/eval/ast/scalar_value_expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -57,6 +59,27 @@ void BreakStatement::dump(std::ostream &out) const {
   out << ";\n";
 }
 
+void BreakStatement::byteCode(ByteCodeProgram &code) const {
+  int64 level = 1;
+  if (m_level) {
+    if (!m_level->isKindOf(Expression::KindOfScalarValueExpression)) {
+      Statement::byteCode(code);
+      return;
+    }
+    level = ScalarValueExpression::GetScalarValueByRef(m_level.get()).
+      toInt64();
+  }
+  if (level > code.loopDepth()) {
+    // leaves the compiled loops, evaluating it unwinds them at run time
+    Statement::byteCode(code);
+    return;
+  }
+  code.emitLine(this);
+  if (level > 0) {
+    code.addBreak(level, m_isBreak, code.emit(ByteCodeProgram::Jmp));
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
@@ -31,6 +31,7 @@ public:
   BreakStatement(STATEMENT_ARGS, ExpressionPtr level, bool isBreak);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   ExpressionPtr m_level;
@@ -92,12 +92,18 @@ void ClassVariable::eval(VariableEnvironment &env, Variant &res) const {
   res = m_value ? m_value->eval(env) : null_variant;
 }
 
+int ClassStatement::s_serial = 0;
+
 ClassStatement::ClassStatement(STATEMENT_ARGS, const string &name,
                                const string &parent, const string &doc)
   : Statement(STATEMENT_PASS), m_name(StringData::GetStaticString(name)),
     m_modifiers(0), m_attributes(0),
     m_parent(StringData::GetStaticString(parent)), m_docComment(doc),
-    m_delayDeclaration(false) { }
+    m_delayDeclaration(false), m_serial(atomic_inc(s_serial)) { }
+
+ClassStatement::~ClassStatement() {
+  ClassEvalTemplate::Forget(this);
+}
 
 void ClassStatement::finish() {
   if (findMethod("__get")) m_attributes        |= ObjectData::UseGet;
@@ -122,7 +128,7 @@ void ClassStatement::loadInterfaceStatements() const {
 }
 
 void ClassStatement::loadMethodTable(
-  ClassEvalState &ce, std::set<const ClassStatement*> &seen) const {
+  ClassEvalTemplate &ce, std::set<const ClassStatement*> &seen) const {
   // make sure classes don't define each other as their
   // own parents (no cycles in the inheritance tree).
   // omit this check for builtin classes (since we assume
@@ -133,8 +139,8 @@ void ClassStatement::loadMethodTable(
   } else {
     seen.insert(this);
   }
-  ce.setAttributes(m_attributes);
-  ClassEvalState::MethodTable &mtable = ce.getMethodTable();
+  ce.m_attributes |= m_attributes;
+  ClassEvalTemplate::MethodTable &mtable = ce.m_methodTable;
   if (!m_parent->empty()) {
     const ClassStatement* parent_cls = parentStatement();
     if (parent_cls) {
@@ -152,7 +158,7 @@ void ClassStatement::loadMethodTable(
         if (attr & ClassInfo::HasCallStatic) {
           o_attr |= ObjectData::HasCallStatic;
         }
-        ce.setAttributes(o_attr);
+        ce.m_attributes |= o_attr;
       }
       for (ClassInfo::MethodVec::const_iterator it = meths.begin();
            it != meths.end(); ++it) {
@@ -168,7 +174,7 @@ void ClassStatement::loadMethodTable(
   }
   for (vector<MethodStatementPtr>::const_iterator it = m_methodsVec.begin();
        it != m_methodsVec.end(); ++it) {
-    ClassEvalState::MethodTable::iterator mit =
+    ClassEvalTemplate::MethodTable::iterator mit =
       mtable.find((*it)->name().c_str());
     if (mit != mtable.end()) {
       int mods = mit->second.second;
@@ -210,14 +216,50 @@ void ClassStatement::loadMethodTable(
   hphp_const_char_imap<MethodStatementPtr>::const_iterator it =
     m_methods.find(m_name->data());
   if (it != m_methods.end()) {
-    ce.getConstructor() = it->second.get();
+    ce.m_constructor = it->second.get();
   }
   it = m_methods.find("__construct");
   if (it != m_methods.end()) {
-    ce.getConstructor() = it->second.get();
+    ce.m_constructor = it->second.get();
   }
 }
 
+bool ClassStatement::resolveAncestors(
+  vector<pair<const ClassStatement*, int> > &out) const {
+  // parents first, the way loadMethodTable() walks them
+  set<const ClassStatement*> seen;
+  for (const ClassStatement *cls = this; !cls->m_parent->empty(); ) {
+    if (!seen.insert(cls).second) return false;
+    cls = RequestEvalState::findClass(cls->m_parent, true);
+    out.push_back(make_pair(cls, cls ? cls->m_serial : 0));
+    if (!cls) break;
+  }
+  // then interfaces, the way semanticCheck() does
+  seen.clear();
+  return resolveInterfaces(out, !(m_modifiers & Interface), seen);
+}
+
+bool ClassStatement::resolveInterfaces(
+  vector<pair<const ClassStatement*, int> > &out, bool recursive,
+  set<const ClassStatement*> &path) const {
+  size_t first = out.size();
+  for (unsigned int i = 0; i < m_bases.size(); i++) {
+    const ClassStatement *iface = RequestEvalState::findClass(m_bases[i], true);
+    out.push_back(make_pair(iface, iface ? iface->m_serial : 0));
+  }
+  if (!recursive) return true;
+  if (!path.insert(this).second) return false;
+  if (const ClassStatement *parent = parentStatement()) {
+    if (!parent->resolveInterfaces(out, true, path)) return false;
+  }
+  for (unsigned int i = 0; i < m_bases.size(); i++) {
+    const ClassStatement *iface = out[first + i].first;
+    if (iface && !iface->resolveInterfaces(out, true, path)) return false;
+  }
+  path.erase(this);
+  return true;
+}
+
 Statement *ClassStatement::optimize(VariableEnvironment &env) {
   std::vector<ClassVariablePtr> variablesVec = m_variablesVec;
   for (unsigned int i = 0; i < m_variablesVec.size(); i++) {
@@ -1143,6 +1185,24 @@ void ClassLevelMethodOverrideCheckImpl(ClassProxyP parent,
   }
 }
 
+// debugging warnings raised by semantic checks on this thread, which
+// ClassEvalState needs to know about so it doesn't skip them next time
+static IMPLEMENT_THREAD_LOCAL(int, s_checkWarnings);
+
+static void check_debugging(const char *fmt, ...) {
+  ++*s_checkWarnings;
+  string msg;
+  va_list ap;
+  va_start(ap, fmt);
+  Util::string_vsnprintf(msg, fmt, ap);
+  va_end(ap);
+  raise_debugging(msg);
+}
+
+int ClassStatement::CheckWarnings() {
+  return *s_checkWarnings;
+}
+
 /**
  * Does child override parent's properties correctly?
  */
@@ -1183,7 +1243,7 @@ void ClassLevelPropertyOverrideCheckImpl(ClassProxyP parent,
   x.name(child).c_str(), x.name(childVariable).c_str(), \
   pn1,                   x.name(parent).c_str()
         if (x.isAbstract(child)) {
-          raise_debugging(RAISE_ARGUMENTS_PRIVACY);
+          check_debugging(RAISE_ARGUMENTS_PRIVACY);
         } else {
           raise_error(RAISE_ARGUMENTS_PRIVACY);
         }
@@ -1201,7 +1261,7 @@ void ClassLevelPropertyOverrideCheckImpl(ClassProxyP parent,
   x.name(parent).c_str(), x.name(parentVariable).c_str(), \
   x.name(child).c_str()
         if (x.isAbstract(child)) {
-          raise_debugging(RAISE_ARGUMENTS_INIT_VAL);
+          check_debugging(RAISE_ARGUMENTS_INIT_VAL);
         } else {
           raise_error(RAISE_ARGUMENTS_INIT_VAL);
         }
@@ -1214,7 +1274,7 @@ void ClassLevelPropertyOverrideCheckImpl(ClassProxyP parent,
   x.name(parent).c_str(), x.name(parentVariable).c_str(), \
   x.name(child).c_str(),  x.name(childVariable).c_str()
           if (x.isAbstract(child)) {
-            raise_debugging(RAISE_ARGUMENTS_STATIC_NONSTATIC);
+            check_debugging(RAISE_ARGUMENTS_STATIC_NONSTATIC);
           } else {
             raise_error(RAISE_ARGUMENTS_STATIC_NONSTATIC);
           }
@@ -1224,7 +1284,7 @@ void ClassLevelPropertyOverrideCheckImpl(ClassProxyP parent,
   x.name(parent).c_str(), x.name(parentVariable).c_str(), \
   x.name(child).c_str(),  x.name(childVariable).c_str()
           if (x.isAbstract(child)) {
-            raise_debugging(RAISE_ARGUMENTS_NONSTATIC_STATIC);
+            check_debugging(RAISE_ARGUMENTS_NONSTATIC_STATIC);
           } else {
             raise_error(RAISE_ARGUMENTS_NONSTATIC_STATIC);
           }
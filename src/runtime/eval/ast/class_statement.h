@@ -35,6 +35,7 @@ DECLARE_AST_PTR(ClassStatementMarker);
 class EvalObjectData;
 class ClassInfoEvaled;
 class ClassEvalState;
+class ClassEvalTemplate;
 
 struct SemanticExtractor;
 
@@ -77,6 +78,7 @@ public:
 
   ClassStatement(STATEMENT_ARGS, const std::string &name,
                  const std::string &parent, const std::string &doc);
+  ~ClassStatement();
   void finish();
   String name() const { return m_name; }
   String parent() const { return m_parent; }
@@ -124,9 +126,24 @@ public:
   void failPropertyAccess(CStrRef prop, const char *context,
       int mods) const;
   void toArray(Array &props, Array &vals) const;
-  void loadMethodTable(ClassEvalState &ce,
+  void loadMethodTable(ClassEvalTemplate &ce,
                        std::set<const ClassStatement*> &seen) const;
   void semanticCheck(const ClassStatement *cls) const;
+  /**
+   * Looks up, and autoloads, every parent and interface that
+   * loadMethodTable() and semanticCheck() would, and records what they
+   * resolved to. False if the parents form a cycle.
+   */
+  bool resolveAncestors(
+    std::vector<std::pair<const ClassStatement*, int> > &out) const;
+  /**
+   * Unique for the life of the process, unlike the address.
+   */
+  int serial() const { return m_serial; }
+  /**
+   * Number of debugging warnings semantic checks raised on this thread.
+   */
+  static int CheckWarnings();
   ClassStatementMarkerPtr getMarker();
   void delayDeclaration() { m_delayDeclaration = true; }
 protected:
@@ -147,6 +164,7 @@ protected:
   std::string m_docComment;
   ClassStatementMarkerPtr m_marker;
   bool m_delayDeclaration;
+  int m_serial;
 
   void loadProperties(ClassInfoEvaled &info) const;
   const MethodStatement* findParentMethod(const char* name,
@@ -157,7 +175,11 @@ protected:
       bool excludeParent) const;
   void abstractMethodCheck(hphp_const_char_imap<const char*> &abstracts,
       bool ifaces) const;
+  bool resolveInterfaces(
+    std::vector<std::pair<const ClassStatement*, int> > &out,
+    bool recursive, std::set<const ClassStatement*> &path) const;
 private:
+  static int s_serial;
 
   template <typename ParentClass, typename ChildClass>
   static void ClassLevelMethodOverrideCheck(ParentClass parent,
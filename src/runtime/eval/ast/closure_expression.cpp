@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/closure_expression.h>
 #include <runtime/eval/ast/function_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/parser/parser.h>
 
 #include <runtime/ext/ext_closure.h>
 
@@ -43,6 +44,17 @@ ClosureExpression::ClosureExpression(EXPRESSION_ARGS,
     }
   }
   reverse(m_vars.begin(), m_vars.end());
+
+  // the closure's env binds used variables by name unless they have a slot
+  for (unsigned int i = 0; i < m_vars.size(); i++) {
+    String name = m_vars[i]->getName();
+    if (VariableIndex::isSuperGlobal(name) == SgNormal) {
+      m_idx.push_back(parser->declareVariable(name));
+    } else {
+      m_vars[i]->clearIdx();
+      m_idx.push_back(-1);
+    }
+  }
 }
 
 Expression *ClosureExpression::optimize(VariableEnvironment &env) {
@@ -60,10 +72,12 @@ Variant ClosureExpression::eval(VariableEnvironment &env) const {
     if (!param->getSuperGlobal(sg)) {
       sg = VariableIndex::isSuperGlobal(name);
     }
+    Variant &var = m_idx[i] != -1 ?
+      env.getVarByIdx(name, m_idx[i]) : env.getVar(name, sg);
     if (param->isRef()) {
-      vars.append(ref(env.getVar(name, sg)));
+      vars.append(ref(var));
     } else {
-      vars.append(env.getVar(name, sg));
+      vars.append(var);
     }
   }
 
@@ -38,6 +38,7 @@ public:
 private:
   FunctionStatementPtr m_func;
   std::vector<ParameterPtr> m_vars;
+  std::vector<int> m_idx; // slots of m_vars in the enclosing scope
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/do_while_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -24,11 +25,20 @@ namespace Eval {
 
 DoWhileStatement::DoWhileStatement(STATEMENT_ARGS, StatementPtr body,
                                    ExpressionPtr cond)
-  : Statement(STATEMENT_PASS), m_cond(cond), m_body(body) {}
+  : Statement(STATEMENT_PASS), m_cond(cond), m_body(body), m_once(false) {}
 
 Statement *DoWhileStatement::optimize(VariableEnvironment &env) {
   Eval::optimize(env, m_cond);
   Eval::optimize(env, m_body);
+  Variant v;
+  if (m_cond && m_cond->evalScalar(env, v)) {
+    if (v.toBoolean()) {
+      m_cond.reset();
+    } else {
+      // do { ... } while (0), the body runs exactly once
+      m_once = true;
+    }
+  }
   return NULL;
 }
 
@@ -43,17 +53,36 @@ void DoWhileStatement::eval(VariableEnvironment &env) const {
     EVAL_STMT_HANDLE_GOTO_BEGIN(restart);
     if (m_body) EVAL_STMT_HANDLE_BREAK(m_body, env);
     EVAL_STMT_HANDLE_GOTO_END(restart);
-  } while (m_cond->eval(env));
+  } while (!m_once && (!m_cond || m_cond->eval(env)));
 }
 
 void DoWhileStatement::dump(std::ostream &out) const {
   out << "do {";
   if (m_body) m_body->dump(out);
   out << "}\nwhile (";
-  m_cond->dump(out);
+  if (m_cond) {
+    m_cond->dump(out);
+  } else {
+    out << "true";
+  }
   out << ");\n";
 }
 
+void DoWhileStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  code.pushLoop();
+  int begin = code.here();
+  code.emitTick();
+  if (m_body) m_body->byteCode(code);
+  int cond = code.here();
+  if (!m_cond) {
+    code.emit(ByteCodeProgram::Jmp, 0, 0, begin);
+  } else if (!m_once) {
+    code.patch(code.emitBranch(ByteCodeProgram::JmpNZ, m_cond.get()), begin);
+  }
+  code.popLoop(code.here(), cond);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
@@ -31,10 +31,12 @@ public:
   DoWhileStatement(STATEMENT_ARGS, StatementPtr body, ExpressionPtr cond);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   ExpressionPtr m_cond;
   StatementPtr m_body;
+  bool m_once; // condition is known to be false
 };
 
 ///////////////////////////////////////////////////////////////////////////////
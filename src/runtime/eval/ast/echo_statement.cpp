@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/echo_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 using namespace std;
 
@@ -50,6 +51,16 @@ void EchoStatement::dump(std::ostream &out) const {
   out << ";\n";
 }
 
+void EchoStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  for (vector<ExpressionPtr>::const_iterator it = m_args.begin();
+       it != m_args.end(); ++it) {
+    int mark = code.regMark();
+    code.emit(ByteCodeProgram::Echo, 0, code.operand(it->get()));
+    code.freeRegs(mark);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
@@ -31,6 +31,7 @@ public:
   EchoStatement(STATEMENT_ARGS, const std::vector<ExpressionPtr> &args);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   std::vector<ExpressionPtr> m_args;
@@ -15,6 +15,8 @@
 */
 
 #include <runtime/eval/ast/encaps_list_expression.h>
+#include <runtime/eval/ast/binary_op_expression.h>
+#include <runtime/eval/ast/scalar_value_expression.h>
 #include <runtime/ext/ext_process.h>
 
 namespace HPHP {
@@ -31,6 +33,26 @@ Expression *EncapsListExpression::optimize(VariableEnvironment &env) {
   for (unsigned int i = 0; i < m_encaps.size(); i++) {
     Eval::optimize(env, m_encaps[i]);
   }
+  if (m_shell || m_encaps.empty()) return NULL;
+
+  // a single concatenation into a buffer of the right size is cheaper than
+  // growing the result piece by piece
+  ExpressionPtr first = m_encaps[0];
+  unsigned int i = 1;
+  if (first->isKindOf(KindOfVariableExpression)) {
+    // VectorConcatExpression::eval() reads a leading variable last
+    first = new ScalarValueExpression(empty_string, loc());
+    i = 0;
+  }
+  VectorConcatExpression *vce = new VectorConcatExpression(first, loc());
+  for (; i < m_encaps.size(); i++) {
+    vce->addElement(m_encaps[i]);
+  }
+  if (vce->exps().size() > 1) return vce;
+  Variant v;
+  bool scalar = vce->exps()[0]->evalScalar(env, v);
+  delete vce;
+  if (scalar) return new ScalarValueExpression(v.toString(), loc());
   return NULL;
 }
 
@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/expr_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -46,6 +47,13 @@ void ExprStatement::dump(std::ostream &out) const {
   out << ";\n";
 }
 
+void ExprStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int mark = code.regMark();
+  m_exp->byteCode(code, ByteCodeProgram::NoReg);
+  code.freeRegs(mark);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
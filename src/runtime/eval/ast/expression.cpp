@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/ast/name.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 #include <util/parser/hphp.tab.hpp>
 
 namespace HPHP {
@@ -53,6 +54,10 @@ bool Expression::isRefParam() const {
   return false;
 }
 
+void Expression::byteCode(ByteCodeProgram &code, int dst) const {
+  code.emit(ByteCodeProgram::EvalExpr, dst, 0, 0, this);
+}
+
 void optimize(VariableEnvironment &env, ExpressionPtr &exp) {
   if (!exp) return; 
   if (ExpressionPtr optExp = exp->optimize(env)) {
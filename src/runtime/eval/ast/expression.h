@@ -103,6 +103,11 @@ public:
   virtual Variant evalExist(VariableEnvironment &env) const;
   virtual const LvalExpression *toLval() const;
   virtual bool isRefParam() const;
+  /**
+   * Lowers the expression into code, leaving its value in register dst,
+   * or nowhere if dst is ByteCodeProgram::NoReg.
+   */
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   KindOf getKindOf() const { return m_kindOf; }
 
 protected:
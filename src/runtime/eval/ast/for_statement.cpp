@@ -17,6 +17,8 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/for_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
+#include <runtime/eval/parser/parser.h>
 
 namespace HPHP {
 namespace Eval {
@@ -52,6 +54,20 @@ Statement *ForStatement::optimize(VariableEnvironment &env) {
     Eval::optimize(env, m_next[i]);
   }
   Eval::optimize(env, m_body);
+
+  // only the last condition decides, and scalars have no side effects
+  if (m_cond.empty()) return NULL;
+  Variant v;
+  for (unsigned int i = 0; i < m_cond.size(); i++) {
+    if (!m_cond[i]->evalScalar(env, v)) return NULL;
+  }
+  if (v.toBoolean()) {
+    // same as for (;;)
+    m_cond.clear();
+  } else if (!Parser::HasLabels()) {
+    m_next.clear();
+    m_body.reset();
+  }
   return NULL;
 }
 
@@ -106,6 +122,35 @@ void ForStatement::dump(std::ostream &out) const {
   out << "}\n";
 }
 
+static void byteCodeVector(const std::vector<ExpressionPtr> &v,
+                           ByteCodeProgram &code, unsigned int count) {
+  for (unsigned int i = 0; i < count; i++) {
+    int mark = code.regMark();
+    v[i]->byteCode(code, ByteCodeProgram::NoReg);
+    code.freeRegs(mark);
+  }
+}
+
+void ForStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  byteCodeVector(m_init, code, m_init.size());
+  int begin = code.here();
+  int exit = -1;
+  if (!m_cond.empty()) {
+    // only the last condition decides
+    byteCodeVector(m_cond, code, m_cond.size() - 1);
+    exit = code.emitBranch(ByteCodeProgram::JmpZ, m_cond.back().get());
+  }
+  code.pushLoop();
+  code.emitTick();
+  if (m_body) m_body->byteCode(code);
+  int next = code.here();
+  byteCodeVector(m_next, code, m_next.size());
+  code.emit(ByteCodeProgram::Jmp, 0, 0, begin);
+  if (exit >= 0) code.patch(exit, code.here());
+  code.popLoop(code.here(), next);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
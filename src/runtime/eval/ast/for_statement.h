@@ -35,6 +35,7 @@ public:
                StatementPtr body);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   std::vector<ExpressionPtr> m_init;
@@ -30,6 +30,7 @@
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/ast/scalar_expression.h>
 #include <runtime/eval/strict_mode.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/intercept.h>
 
@@ -38,13 +39,22 @@
 
 #include <util/parser/parser.h>
 #include <util/logger.h>
+#include <util/lock.h>
 #include <tbb/concurrent_hash_map.h>
 
 namespace HPHP {
+
+extern void (*dynamic_locals_report)(std::ostream &out);
+
 namespace Eval {
 using namespace std;
 ///////////////////////////////////////////////////////////////////////////////
 
+// function -> "file:line function: constructs" reading or writing its locals
+// by name, for as long as the function is around
+static Mutex s_dynamicLocalsMutex;
+static map<const FunctionStatement*, string> s_dynamicLocals;
+
 typedef tbb::concurrent_hash_map<StringData *, int,
                                  StringDataHashICompare> UserFunctionIdMap;
 static UserFunctionIdMap s_userFunctionIdMap;
@@ -204,12 +214,7 @@ Parameter *Parameter::optimize(VariableEnvironment &env) {
 
 Variant *Parameter::getParam(FuncScopeVariableEnvironment &fenv) const {
   ASSERT(fenv.getIdx(m_idx) == NULL);
-  CStrRef s = m_name->get(fenv);
-  AssocList &alist = fenv.getAssocList();
-  ASSERT(!alist.getPtr(s));
-  Variant *v = &alist.append(s);
-  fenv.setIdx(m_idx, v);
-  return v;
+  return &fenv.bindIdx(m_name->get(fenv), m_idx);
 }
 
 void Parameter::bind(FuncScopeVariableEnvironment &fenv, CVarRef val,
@@ -324,7 +329,7 @@ FunctionStatement::FunctionStatement(STATEMENT_ARGS, const string &name,
   : Statement(STATEMENT_PASS),
     m_invalid(0), m_maybeIntercepted(-1), m_yieldCount(0),
     m_name(StringData::GetStaticString(name)), m_closure(NULL),
-    m_docComment(doc),
+    m_hasGoto(false), m_byteCode(NULL), m_docComment(doc),
     m_callInfo((void*)Invoker, (void*)InvokerFewArgs, 0, 0, 0),
     m_closureCallInfo((void*)FSInvoker, (void*)FSInvokerFewArgs, 0, 0, 0) {
   m_id = UserFunctionIdTable::GetUserFunctionId(m_name);
@@ -332,6 +337,11 @@ FunctionStatement::FunctionStatement(STATEMENT_ARGS, const string &name,
 
 FunctionStatement::~FunctionStatement() {
   unregister_intercept_flag(&m_maybeIntercepted);
+  delete m_byteCode;
+  if (!m_dynamicLocals.empty()) {
+    Lock lock(s_dynamicLocalsMutex);
+    s_dynamicLocals.erase(this);
+  }
 }
 
 void FunctionStatement::init(void *parser, bool ref,
@@ -384,7 +394,71 @@ void FunctionStatement::init(void *parser, bool ref,
     }
   }
 
+  if (!m_dynamicLocals.empty()) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), ":%d ", m_loc.line0);
+    string line = string(m_loc.file) + buf + fullName().data() + ": " +
+      m_dynamicLocals;
+    Lock lock(s_dynamicLocalsMutex);
+    s_dynamicLocals[this] = line;
+  }
+
   m_injectionName = computeInjectionName();
+  if (RuntimeOption::EvalBytecodeInterpreter) {
+    s_byteCodeQueue->push_back(this);
+  }
+}
+
+void FunctionStatement::addDynamicLocal(const string &what, int line) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), " line %d", line);
+  if (!m_dynamicLocals.empty()) m_dynamicLocals += ", ";
+  m_dynamicLocals += what + buf;
+}
+
+void FunctionStatement::DynamicLocalsReport(ostream &out) {
+  vector<string> lines;
+  {
+    Lock lock(s_dynamicLocalsMutex);
+    for (map<const FunctionStatement*, string>::const_iterator it =
+           s_dynamicLocals.begin(); it != s_dynamicLocals.end(); ++it) {
+      lines.push_back(it->second);
+    }
+  }
+  sort(lines.begin(), lines.end());
+  for (unsigned int i = 0; i < lines.size(); i++) {
+    out << lines[i] << "\n";
+  }
+}
+
+static class DynamicLocalsReportInitializer {
+  public: DynamicLocalsReportInitializer() {
+    dynamic_locals_report = FunctionStatement::DynamicLocalsReport;
+  }
+} s_dynamicLocalsReportInitializer;
+
+IMPLEMENT_THREAD_LOCAL(FunctionStatement::FunctionStatementPtrVec,
+                       FunctionStatement::s_byteCodeQueue);
+
+void FunctionStatement::CompileQueuedByteCode() {
+  FunctionStatementPtrVec &queue = *s_byteCodeQueue;
+  for (unsigned int i = 0; i < queue.size(); i++) {
+    queue[i]->compileByteCode();
+  }
+  queue.clear();
+}
+
+void FunctionStatement::ClearQueuedByteCode() {
+  s_byteCodeQueue->clear();
+}
+
+void FunctionStatement::compileByteCode() {
+  // generators are resumed in the middle of their body and gotos jump
+  // into it, neither of which the straight-line program can do
+  if (!m_body || m_byteCode || hasYield() || m_hasGoto) return;
+  m_byteCode = new ByteCodeProgram(m_ref);
+  m_body->byteCode(*m_byteCode);
+  m_byteCode->finish();
 }
 
 String FunctionStatement::fullName() const {
@@ -543,7 +617,13 @@ Variant FunctionStatement::evalBody(VariableEnvironment &env) const {
   if (m_body) {
     restart:
     try {
-      m_body->eval(env);
+      if (m_byteCode && !(RuntimeOption::EnableDebugger &&
+                          ThreadInfo::s_threadInfo->
+                          m_reqInjectionData.debugger)) {
+        m_byteCode->execute(env);
+      } else {
+        m_body->eval(env);
+      }
     } catch (GotoException &e) {
       goto restart;
     } catch (UnlimitedGotoException &e) {
@@ -603,10 +683,13 @@ inline Variant FunctionStatement::invokeClosureCommon(
     int i = iter.first();
     CVarRef var = iter.secondRef();
     Parameter *param = vars[i].get();
+    Variant &local = param->getIdx() != -1 ?
+      fenv.getVarByIdx(param->getName(), param->getIdx()) :
+      fenv.get(param->getName());
     if (param->isRef()) {
-      fenv.get(param->getName()).assignRef(var);
+      local.assignRef(var);
     } else {
-      fenv.get(param->getName()).assignVal(var);
+      local.assignVal(var);
     }
   }
 
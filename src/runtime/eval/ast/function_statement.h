@@ -155,6 +155,28 @@ public:
     return ParserBase::IsClosureName(m_name->data());
   }
 
+  void setHasGoto() { m_hasGoto = true; }
+
+  /**
+   * Records a construct at line that can reach this function's locals by
+   * name. Functions without any resolve every local to its slot.
+   */
+  void addDynamicLocal(const std::string &what, int line);
+
+  /**
+   * Lists the functions still loaded that have dynamic locals, one
+   * "file:line function: constructs" line each.
+   */
+  static void DynamicLocalsReport(std::ostream &out);
+
+  /**
+   * With Eval.BytecodeInterpreter, lowers the bodies of the functions this
+   * thread parsed since the last call into byte code. Has to run after
+   * scalar values are registered, as the code points at them.
+   */
+  static void CompileQueuedByteCode();
+  static void ClearQueuedByteCode();
+
 protected:
   bool m_ref;
   bool m_hasCallToGetArgs;
@@ -167,6 +189,9 @@ protected:
 
   StatementListStatementPtr m_body;
   void *m_closure;
+  bool m_hasGoto;
+  ByteCodeProgram *m_byteCode;
+  std::string m_dynamicLocals;
 
   std::string m_docComment;
 
@@ -195,6 +220,10 @@ private:
                                   INVOKE_FEW_ARGS_IMPL_ARGS);
 
   std::string computeInjectionName() const;
+  void compileByteCode();
+
+  typedef std::vector<FunctionStatementPtr> FunctionStatementPtrVec;
+  static DECLARE_THREAD_LOCAL(FunctionStatementPtrVec, s_byteCodeQueue);
 
   CallInfo m_closureCallInfo;
   int m_id;
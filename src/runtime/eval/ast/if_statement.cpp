@@ -20,6 +20,8 @@
 #include <runtime/eval/ast/assignment_op_expression.h>
 #include <runtime/eval/ast/assignment_ref_expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
+#include <runtime/eval/parser/parser.h>
 
 namespace HPHP {
 namespace Eval {
@@ -66,6 +68,28 @@ Statement *IfStatement::optimize(VariableEnvironment &env) {
     Eval::optimize(env, m_branches[i]);
   }
   Eval::optimize(env, m_else);
+  if (Parser::HasLabels()) return NULL;
+
+  // drop branches with a false condition, and make the first branch with a
+  // true condition the last thing tried
+  vector<IfBranchPtr> branches;
+  for (unsigned int i = 0; i < m_branches.size(); i++) {
+    Variant v;
+    if (!m_branches[i]->cond()->evalScalar(env, v)) {
+      branches.push_back(m_branches[i]);
+      continue;
+    }
+    if (v.toBoolean()) {
+      m_else = m_branches[i]->body();
+      if (!m_else) {
+        // an empty body still has to stop the else from running
+        branches.push_back(m_branches[i]);
+      }
+      break;
+    }
+  }
+  m_branches.swap(branches);
+  if (m_branches.empty() && m_else) return m_else.get();
   return NULL;
 }
 
@@ -106,6 +130,22 @@ void IfStatement::dump(std::ostream &out) const {
   out << "\n";
 }
 
+void IfStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  vector<int> ends;
+  for (vector<IfBranchPtr>::const_iterator it = m_branches.begin();
+       it != m_branches.end(); ++it) {
+    int next = code.emitBranch(ByteCodeProgram::JmpZ, (*it)->cond().get());
+    if ((*it)->body()) (*it)->body()->byteCode(code);
+    ends.push_back(code.emit(ByteCodeProgram::Jmp));
+    code.patch(next, code.here());
+  }
+  if (m_else) m_else->byteCode(code);
+  for (unsigned int i = 0; i < ends.size(); i++) {
+    code.patch(ends[i], code.here());
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
@@ -47,6 +47,7 @@ public:
               StatementPtr els);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   std::vector<IfBranchPtr> m_branches;
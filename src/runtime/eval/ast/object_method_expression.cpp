@@ -20,6 +20,7 @@
 #include <runtime/eval/ast/class_statement.h>
 #include <runtime/eval/runtime/eval_state.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/method_cache.h>
 
 namespace HPHP {
 namespace Eval {
@@ -28,11 +29,14 @@ namespace Eval {
 ObjectMethodExpression::ObjectMethodExpression(EXPRESSION_ARGS,
                                                ExpressionPtr obj, NamePtr name,
                                                std::vector<ExpressionPtr> param)
-  : SimpleFunctionCallExpression(EXPRESSION_PASS, name, param), m_obj(obj) {}
+  : SimpleFunctionCallExpression(EXPRESSION_PASS, name, param), m_obj(obj) {
+  m_staticName = dynamic_cast<StringName *>(m_name.get()) != NULL;
+}
 
 Expression *ObjectMethodExpression::optimize(VariableEnvironment &env) {
   Eval::optimize(env, m_obj);
   SimpleFunctionCallExpression::optimize(env);
+  m_staticName = dynamic_cast<StringName *>(m_name.get()) != NULL;
   return NULL;
 }
 
@@ -44,20 +48,27 @@ Variant ObjectMethodExpression::eval(VariableEnvironment &env) const {
                 name.c_str());
   }
   EvalFrameInjection::EvalStaticClassNameHelper helper(obj.toObject());
+  ObjectData *o = obj.getObjectData();
   Variant cobj(env.currentObject());
-  const MethodStatement *ms = NULL;
-  if (cobj.is(KindOfObject) && obj.getObjectData() == cobj.getObjectData()) {
-    // Have to try current class first for private method
-    const ClassStatement *cls = env.currentClassStatement();
-    if (cls) {
-      const MethodStatement *ccms = cls->findMethod(name.c_str());
+  const ClassStatement *context = NULL;
+  if (cobj.is(KindOfObject) && o == cobj.getObjectData()) {
+    context = env.currentClassStatement();
+  }
+  const ClassEvalState *ce = m_staticName ? o->getClassEvalState() : NULL;
+  const MethodStatement *ms =
+    ce ? MethodCache::Find(this, ce, context) : NULL;
+  if (!ms) {
+    if (context) {
+      // Have to try current class first for private method
+      const MethodStatement *ccms = context->findMethod(name.c_str());
       if (ccms && ccms->getModifiers() & ClassStatement::Private) {
         ms = ccms;
       }
     }
-  }
-  if (!ms) {
-    ms = obj.getObjectData()->getMethodStatement(name.data());
+    if (!ms) {
+      ms = o->getMethodStatement(name.data());
+    }
+    if (ms && ce) MethodCache::Add(this, ce, context, ms);
   }
   SET_LINE;
   if (ms) {
@@ -35,6 +35,7 @@ public:
   virtual void dump(std::ostream &out) const;
 private:
   ExpressionPtr m_obj;
+  bool m_staticName; // resolved methods can be cached per call site
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -29,6 +29,11 @@ Expression *QOpExpression::optimize(VariableEnvironment &env) {
   Eval::optimize(env, m_cond);
   Eval::optimize(env, m_true);
   Eval::optimize(env, m_false);
+  Variant v;
+  if (m_cond->evalScalar(env, v)) {
+    if (!v.toBoolean()) return m_false.get();
+    return m_true ? m_true.get() : m_cond.get();
+  }
   return NULL;
 }
 
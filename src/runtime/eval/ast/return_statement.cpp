@@ -18,6 +18,7 @@
 #include <runtime/eval/ast/return_statement.h>
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -54,6 +55,21 @@ void ReturnStatement::dump(std::ostream &out) const {
   out << ";\n";
 }
 
+void ReturnStatement::byteCode(ByteCodeProgram &code) const {
+  if (m_value && code.refReturn()) {
+    Statement::byteCode(code);
+    return;
+  }
+  code.emitLine(this);
+  if (!m_value) {
+    code.emit(ByteCodeProgram::RetNull);
+    return;
+  }
+  int mark = code.regMark();
+  code.emit(ByteCodeProgram::Ret, 0, code.operand(m_value.get()));
+  code.releaseRegs(mark);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
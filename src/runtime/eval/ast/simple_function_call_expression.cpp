@@ -18,7 +18,11 @@
 #include <runtime/eval/ast/name.h>
 #include <runtime/base/string_util.h>
 #include <runtime/base/intercept.h>
+#include <runtime/base/class_info.h>
+#include <runtime/base/externals.h>
+#include <runtime/base/execution_context.h>
 #include <runtime/eval/ast/scalar_expression.h>
+#include <runtime/eval/ast/scalar_value_expression.h>
 #include <runtime/eval/ast/closure_expression.h>
 #include <runtime/eval/ast/class_statement.h>
 #include <runtime/eval/runtime/eval_state.h>
@@ -26,6 +30,9 @@
 #include <runtime/eval/ast/method_statement.h>
 #include <runtime/eval/parser/parser.h>
 #include <runtime/eval/ext/ext.h>
+#include <runtime/ext/profile/extprofile_array.h>
+#include <runtime/ext/profile/extprofile_string.h>
+#include <runtime/ext/profile/extprofile_variable.h>
 
 namespace HPHP {
 namespace Eval {
@@ -40,11 +47,74 @@ SimpleFunctionCallExpression::SimpleFunctionCallExpression
 (NamePtr name, const std::vector<ExpressionPtr> &params, const Location *loc) :
   FunctionCallExpression(params, loc), m_name(name) {}
 
+/**
+ * Single argument builtins common enough in eval'ed code to be called
+ * straight through their x_* entry instead of the generated few-args
+ * invoker, which re-checks the argument count and pads five null arguments
+ * on every call.
+ */
+#define DIRECT_BUILTINS(n)                                              \
+  n(count)                                                              \
+  n(sizeof)                                                             \
+  n(strlen)                                                             \
+  n(ord)                                                                \
+  n(is_null)                                                            \
+  n(is_bool)                                                            \
+  n(is_int)                                                             \
+  n(is_integer)                                                         \
+  n(is_long)                                                            \
+  n(is_float)                                                           \
+  n(is_double)                                                          \
+  n(is_real)                                                            \
+  n(is_numeric)                                                         \
+  n(is_string)                                                          \
+  n(is_scalar)                                                          \
+  n(is_array)                                                           \
+  n(is_object)                                                          \
+  n(is_resource)                                                        \
+  n(gettype)                                                            \
+  n(intval)                                                             \
+  n(floatval)                                                           \
+  n(doubleval)                                                          \
+  n(strval)
+
+#define DIRECT_BUILTIN(n)                                               \
+  static Variant direct_ ## n(CVarRef v) { return x_ ## n(v); }
+DIRECT_BUILTINS(DIRECT_BUILTIN)
+#undef DIRECT_BUILTIN
+
+static const struct {
+  const char *name;
+  BuiltinFunctionCallExpression::DirectInvoker invoker;
+} s_directBuiltins[] = {
+#define DIRECT_BUILTIN(n) { #n, direct_ ## n },
+  DIRECT_BUILTINS(DIRECT_BUILTIN)
+#undef DIRECT_BUILTIN
+};
+
+static BuiltinFunctionCallExpression::DirectInvoker
+find_direct_builtin(CStrRef name) {
+  for (unsigned int i = 0;
+       i < sizeof(s_directBuiltins) / sizeof(s_directBuiltins[0]); i++) {
+    if (strcasecmp(name.data(), s_directBuiltins[i].name) == 0) {
+      const ClassInfo::MethodInfo *info = ClassInfo::FindFunction(name);
+      if (info && (info->attribute & ClassInfo::AllowIntercept)) break;
+      return s_directBuiltins[i].invoker;
+    }
+  }
+  return NULL;
+}
+
 BuiltinFunctionCallExpression::BuiltinFunctionCallExpression(
   NamePtr name, const std::vector<ExpressionPtr> &params,
   const CallInfo *callInfo, const Location *loc) :
   SimpleFunctionCallExpression(name, params, loc),
-  m_callInfo(callInfo) {}
+  m_callInfo(callInfo), m_direct(NULL) {
+  if (m_params.size() == 1 && !m_params[0]->isRefParam() &&
+      !m_callInfo->isRef(0)) {
+    m_direct = find_direct_builtin(m_name->get());
+  }
+}
 
 UserFunctionCallExpression::UserFunctionCallExpression(
   NamePtr name, const std::vector<ExpressionPtr> &params,
@@ -58,6 +128,40 @@ OverrideFunctionCallExpression::OverrideFunctionCallExpression(
   SimpleFunctionCallExpression(name, params, loc),
   m_override(override) {}
 
+/**
+ * Calls a builtin marked foldable at parse time if all its arguments are
+ * scalars, the same way the compiler does it. Anything that raises an error
+ * is left for runtime.
+ */
+static Expression *fold_builtin(VariableEnvironment &env, CStrRef name,
+                                const vector<ExpressionPtr> &params,
+                                const Location *loc) {
+  const ClassInfo::MethodInfo *info = ClassInfo::FindFunction(name);
+  if (!info || !(info->attribute & ClassInfo::FunctionIsFoldable) ||
+      (info->attribute & ClassInfo::AllowIntercept)) {
+    return NULL;
+  }
+  Array args = Array::Create();
+  for (unsigned int i = 0; i < params.size(); i++) {
+    Variant v;
+    if (params[i]->isRefParam() || !params[i]->evalScalar(env, v)) {
+      return NULL;
+    }
+    args.append(v);
+  }
+  Variant r;
+  try {
+    g_context->setThrowAllErrors(true);
+    r = invoke_builtin(name.data(), args, -1, true);
+    g_context->setThrowAllErrors(false);
+  } catch (...) {
+    g_context->setThrowAllErrors(false);
+    return NULL;
+  }
+  if (r.isObject() || r.isResource()) return NULL;
+  return new ScalarValueExpression(r, loc);
+}
+
 Expression *SimpleFunctionCallExpression::optimize(VariableEnvironment &env) {
   Eval::optimize(env, m_name);
   FunctionCallExpression::optimize(env);
@@ -69,6 +173,9 @@ Expression *SimpleFunctionCallExpression::optimize(VariableEnvironment &env) {
       return new OverrideFunctionCallExpression(m_name, m_params, f, loc());
     }
     if (get_call_info_no_eval(ci, extra, func)) {
+      if (Expression *folded = fold_builtin(env, func, m_params, loc())) {
+        return folded;
+      }
       return new BuiltinFunctionCallExpression(m_name, m_params, ci, loc());
     }
     int userFuncId = UserFunctionIdTable::GetUserFunctionId(func);
@@ -126,6 +233,7 @@ Variant SimpleFunctionCallExpression::eval(VariableEnvironment &env) const {
 Variant BuiltinFunctionCallExpression::eval(VariableEnvironment &env) const {
   SET_LINE;
   if (!*s_hasRenamedFunction) {
+    if (m_direct) return m_direct(m_params[0]->eval(env));
     return strongBind(evalCallInfo(m_callInfo, NULL, env));
   }
   return SimpleFunctionCallExpression::eval(env);
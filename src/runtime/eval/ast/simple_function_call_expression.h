@@ -56,8 +56,11 @@ public:
                                 const std::vector<ExpressionPtr> &params,
                                 const CallInfo *callInfo, const Location *loc);
   virtual Variant eval(VariableEnvironment &env) const;
+  typedef Variant (*DirectInvoker)(CVarRef);
 private:
   const CallInfo *m_callInfo;
+  // set when the call site can skip the few-args invoker, see ctor
+  DirectInvoker m_direct;
 };
 
 class UserFunctionCallExpression : public SimpleFunctionCallExpression {
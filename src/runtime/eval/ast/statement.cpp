@@ -14,13 +14,14 @@
    +----------------------------------------------------------------------+
 */
 #include <runtime/eval/ast/statement.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
 ///////////////////////////////////////////////////////////////////////////////
 
 void Statement::byteCode(ByteCodeProgram &code) const {
-  throw FatalErrorException(0,"Cannot compile %s:%d", m_loc.file, m_loc.line1);
+  code.emit(ByteCodeProgram::EvalStmt, code.currentLoop(), 0, 0, this);
 }
 
 void optimize(VariableEnvironment &env, StatementPtr &stmt) {
@@ -18,6 +18,7 @@
 #include <runtime/eval/ast/static_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
 #include <runtime/eval/ast/name.h>
+#include <runtime/eval/parser/parser.h>
 
 namespace HPHP {
 namespace Eval {
@@ -27,10 +28,10 @@ using namespace std;
 StaticVariable::StaticVariable(CONSTRUCT_ARGS, const string &name,
                                ExpressionPtr val)
   : Construct(CONSTRUCT_PASS), m_name(Name::fromString(CONSTRUCT_PASS, name)),
-    m_val(val) {}
+    m_val(val), m_idx(parser->declareVariable(m_name->get())) {}
 
 void StaticVariable::set(VariableEnvironment &env) const {
-  env.flagStatic(m_name->get(env), m_name->hash());
+  env.flagStaticIdx(m_name->get(env), m_idx);
 }
 
 void StaticVariable::dump(std::ostream &out) const {
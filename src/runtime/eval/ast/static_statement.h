@@ -39,6 +39,7 @@ public:
 private:
   NamePtr m_name;
   ExpressionPtr m_val;
+  int m_idx;
 };
 
 class StaticStatement : public Statement {
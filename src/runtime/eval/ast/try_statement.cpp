@@ -14,8 +14,10 @@
    +----------------------------------------------------------------------+
 */
 
+#include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/try_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/parser/parser.h>
 
 using namespace std;
 
@@ -26,16 +28,26 @@ namespace Eval {
 CatchBlock::CatchBlock(CONSTRUCT_ARGS, const string &ename,
                        const string &vname, StatementPtr body)
   : Construct(CONSTRUCT_PASS), m_ename(ename),
-    m_vname(vname), m_sg(VariableIndex::isSuperGlobal(vname)), m_body(body) {}
+    m_vname(vname), m_sg(VariableIndex::isSuperGlobal(vname)),
+    m_idx(m_sg == SgNormal ? parser->declareVariable(String(vname)) : -1),
+    m_body(body) {}
 
 bool CatchBlock::match(CObjRef exn) const {
   return exn.instanceof(m_ename.c_str());
 }
 
+void CatchBlock::bind(CObjRef exn, VariableEnvironment &env) const {
+  if (m_idx != -1) {
+    env.getVarByIdx(m_vname, m_idx) = exn;
+  } else {
+    env.getVar(m_vname, m_sg) = exn;
+  }
+}
+
 bool CatchBlock::proc(CObjRef exn, VariableEnvironment &env) const {
   if (exn.instanceof(m_ename.c_str())) {
     if (m_body) {
-      env.getVar(m_vname, m_sg) = exn;
+      bind(exn, env);
       m_body->eval(env);
     }
     return true;
@@ -83,9 +95,7 @@ void TryStatement::eval(VariableEnvironment &env) const {
          it != m_catches.end(); ++it) {
       if ((*it)->match(e)) {
         if ((*it)->body()) {
-          String s = (*it)->vname();
-          SuperGlobal sg = (*it)->sg();
-          env.getVar(s, sg) = e;
+          (*it)->bind(e, env);
           EVAL_STMT((*it)->body(), env);
         }
         return;
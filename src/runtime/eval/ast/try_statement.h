@@ -33,6 +33,7 @@ public:
   CatchBlock *optimize(VariableEnvironment &env);
   bool proc(CObjRef exn, VariableEnvironment &env) const;
   bool match(CObjRef exn) const;
+  void bind(CObjRef exn, VariableEnvironment &env) const;
   const StatementPtr &body() const { return m_body; }
   const std::string &vname() const { return m_vname; }
   SuperGlobal sg() const { return m_sg; }
@@ -41,6 +42,7 @@ private:
   std::string m_ename;
   std::string m_vname;
   SuperGlobal m_sg;
+  int m_idx;
   StatementPtr m_body;
 };
 
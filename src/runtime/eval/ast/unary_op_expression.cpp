@@ -21,6 +21,7 @@
 #include <runtime/ext/ext_misc.h>
 #include <runtime/eval/eval.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -120,6 +121,18 @@ Variant UnaryOpExpression::refval(VariableEnvironment &env,
   return strongBind(Expression::refval(env, strict));
 }
 
+void UnaryOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  if (m_op != '!') {
+    Expression::byteCode(code, dst);
+    return;
+  }
+  if (dst == ByteCodeProgram::NoReg) dst = code.allocReg();
+  int mark = code.regMark();
+  int v = code.operand(m_exp.get());
+  code.releaseRegs(mark);
+  code.emit(ByteCodeProgram::Not, dst, v);
+}
+
 void UnaryOpExpression::dump(std::ostream &out) const {
   if (m_front) {
     dumpOp(out);
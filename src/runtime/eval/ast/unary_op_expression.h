@@ -33,6 +33,7 @@ public:
   virtual bool evalScalar(VariableEnvironment &env, Variant &r) const;
   virtual bool evalStaticScalar(VariableEnvironment &env, Variant &r) const;
   virtual Variant refval(VariableEnvironment &env, int strict = 2) const;
+  virtual void byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump(std::ostream &out) const;
   int getOp() const { return m_op; }
   Expression *getExpression() const { return m_exp.get(); }
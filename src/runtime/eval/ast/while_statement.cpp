@@ -17,6 +17,8 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/while_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/byte_code_program.h>
+#include <runtime/eval/parser/parser.h>
 
 namespace HPHP {
 namespace Eval {
@@ -29,6 +31,15 @@ WhileStatement::WhileStatement(STATEMENT_ARGS, ExpressionPtr cond,
 Statement *WhileStatement::optimize(VariableEnvironment &env) {
   Eval::optimize(env, m_cond);
   Eval::optimize(env, m_body);
+  Variant v;
+  if (m_cond && m_cond->evalScalar(env, v)) {
+    if (v.toBoolean()) {
+      // while (true) never needs to look at its condition again
+      m_cond.reset();
+    } else if (!Parser::HasLabels()) {
+      m_body.reset();
+    }
+  }
   return NULL;
 }
 
@@ -43,7 +54,7 @@ void WhileStatement::eval(VariableEnvironment &env) const {
   LOOP_COUNTER(1);
 
   begin:
-  if (m_cond->eval(env)) {
+  if (!m_cond || m_cond->eval(env)) {
     body:
     LOOP_COUNTER_CHECK_INFO(1);
     EVAL_STMT_HANDLE_GOTO_BEGIN(restart);
@@ -56,12 +67,29 @@ void WhileStatement::eval(VariableEnvironment &env) const {
 
 void WhileStatement::dump(std::ostream &out) const {
   out << "while (";
-  m_cond->dump(out);
+  if (m_cond) {
+    m_cond->dump(out);
+  } else {
+    out << "true";
+  }
   out << ") {";
   if (m_body) m_body->dump(out);
   out << "}\n";
 }
 
+void WhileStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int begin = code.here();
+  int exit = -1;
+  if (m_cond) exit = code.emitBranch(ByteCodeProgram::JmpZ, m_cond.get());
+  code.pushLoop();
+  code.emitTick();
+  if (m_body) m_body->byteCode(code);
+  code.emit(ByteCodeProgram::Jmp, 0, 0, begin);
+  if (exit >= 0) code.patch(exit, code.here());
+  code.popLoop(code.here(), begin);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
@@ -31,6 +31,7 @@ public:
   WhileStatement(STATEMENT_ARGS, ExpressionPtr cond, StatementPtr body);
   virtual Statement *optimize(VariableEnvironment &env);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump(std::ostream &out) const;
 private:
   ExpressionPtr m_cond;
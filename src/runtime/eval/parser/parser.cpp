@@ -69,6 +69,7 @@
 #include <runtime/eval/ast/goto_statement.h>
 #include <runtime/eval/ast/label_statement.h>
 #include <runtime/eval/ast/name.h>
+#include <runtime/eval/runtime/parse_cache.h>
 
 #include <util/preprocess.h>
 #include <runtime/base/runtime_option.h>
@@ -194,11 +195,28 @@ ParserFrameInjection::ParserFrameInjection(
 ///////////////////////////////////////////////////////////////////////////////
 // statics
 
+IMPLEMENT_THREAD_LOCAL(bool, Parser::s_hasLabels);
+
 StatementPtr Parser::ParseString(CStrRef input, const char *fileName,
                                  vector<StaticStatementPtr> &statics,
-                                 Block::VariableIndices &variableIndices) {
+                                 Block::VariableIndices &variableIndices,
+                                 const string &md5 /* = "" */) {
   ASSERT(!input.empty());
   Scanner scanner(input.data(), input.size(), RuntimeOption::ScannerType);
+  // with an md5, replay the tokens of an earlier parse or record them
+  string tokens, holder;
+  bool recording = false;
+  if (!md5.empty() && ParseCache::Enabled()) {
+    const char *cached;
+    int len;
+    if (ParseCache::Find(md5, RuntimeOption::ScannerType, cached, len,
+                         holder)) {
+      scanner.replay(cached, len);
+    } else {
+      scanner.record(&tokens);
+      recording = true;
+    }
+  }
   Parser parser(scanner, fileName ? fileName : "string", statics);
   if (!fileName) {
     if (parser.parse()) {
@@ -212,6 +230,9 @@ StatementPtr Parser::ParseString(CStrRef input, const char *fileName,
 
   try {
     if (parser.parse()) {
+      if (recording) {
+        ParseCache::Add(md5, RuntimeOption::ScannerType, tokens);
+      }
       variableIndices = parser.varIndices();
       return parser.getTree();
     }
@@ -230,6 +251,7 @@ Parser::Parser(Scanner &scanner, const char *fileName,
     : ParserBase(scanner, fileName), m_staticStatements(statics),
       m_errorHandled(false) {
   m_prependingStatements.push_back(vector<StatementPtr>());
+  *s_hasLabels = false;
 }
 
 string Parser::errString() {
@@ -434,14 +456,23 @@ void Parser::onStaticVariable(Token &out, Token *exprs, Token &var,
     push_back(StaticVariablePtr(new StaticVariable(this, var.text(), exp)));
 }
 
-LvalExpressionPtr Parser::makeStringVariable(CStrRef s) {
-  int idx = -1;
-  String svar = StringData::GetStaticString(s.get());
+int Parser::declareVariable(CStrRef name) {
+  String svar = StringData::GetStaticString(name.get());
   if (haveFunc()) {
-    idx = peekFunc()->declareVariable(svar);
-  } else {
-    idx = m_fileBlock.declareVariable(svar);
+    return peekFunc()->declareVariable(svar);
   }
+  return m_fileBlock.declareVariable(svar);
+}
+
+void Parser::onDynamicLocal(const char *what) {
+  if (haveFunc()) {
+    peekFunc()->addDynamicLocal(what, line1());
+  }
+}
+
+LvalExpressionPtr Parser::makeStringVariable(CStrRef s) {
+  String svar = StringData::GetStaticString(s.get());
+  int idx = declareVariable(svar);
   assert(idx != -1);
   if (svar.same(s_this)) {
     return NEW_EXP(ThisVariable, Name::fromString(this, svar), idx);
@@ -486,6 +517,7 @@ void Parser::onSynthesizedVariable(Token &out, Token &var) {
     // Synthesized variables are essentially like normal simple variables,
     // but they are always looked up by the name, becasue they might have
     // been synthesized out of its containing function.
+    onDynamicLocal(("synthesized $" + var.text()).c_str());
     out->exp() = NEW_EXP(Variable, Name::fromString(this, var.text()), -1);
   }
 }
@@ -555,6 +587,7 @@ ExpressionPtr Parser::getDynamicVariable(ExpressionPtr exp, bool encap) {
 }
 
 ExpressionPtr Parser::createDynamicVariable(ExpressionPtr exp) {
+  onDynamicLocal("variable variable");
   TempExpressionPtr temp(new TempExpression(exp, 0));
   ExpressionPtr variable = NEW_EXP(Variable, Name::fromExp(this, temp));
   TempExpressionListPtr ret(new TempExpressionList(variable));
@@ -585,6 +618,10 @@ void Parser::onCall(Token &out, bool dynamic, Token &name, Token &params,
   } else {
     const string &s = name.text();
     n = Name::fromString(this, s);
+    if (s == "extract" || s == "compact" || s == "get_defined_vars" ||
+        s == "parse_str") {
+      onDynamicLocal((s + "()").c_str());
+    }
     if((s == "func_num_args") ||
        (s == "func_get_args") ||
        (s == "func_get_arg")) {
@@ -919,6 +956,7 @@ void Parser::onUnaryOpExp(Token &out, Token &operand, int op, bool front) {
   case T_REQUIRE:
   case T_REQUIRE_ONCE:
     {
+      onDynamicLocal("include");
       IncludeExpressionPtr exp = NEW_EXP(Include, op == T_INCLUDE ||
                                          op == T_INCLUDE_ONCE,
                                          op == T_INCLUDE_ONCE ||
@@ -944,6 +982,7 @@ void Parser::onUnaryOpExp(Token &out, Token &operand, int op, bool front) {
     }
   default:
     {
+      if (op == T_EVAL) onDynamicLocal("eval");
       UnaryOpExpressionPtr exp = NEW_EXP(UnaryOp, operand->exp(), op,
                                          front);
       out->exp() = exp;
@@ -1550,6 +1589,7 @@ void Parser::onGlobal(Token &out, Token &expr) {
     }
   }
   if (!allStringNames) {
+    onDynamicLocal("global with a variable name");
     out->stmt() = NEW_STMT(Global, vars);
     return;
   }
@@ -1683,7 +1723,16 @@ void Parser::onThrow(Token &out, Token &expr) {
 void Parser::onClosure(Token &out, Token &ret, Token &ref, Token &params,
                        Token &cparams, Token &stmts) {
   Token func, name;
+  FunctionStatementPtr declared = peekFunc();
   onFunction(func, ret, ref, name, params, stmts);
+  if (func->stmt() != declared) {
+    // generator closures run a different function than the one the used
+    // variables got their slots in
+    const vector<ParameterPtr> &vars = cparams->params();
+    for (unsigned int i = 0; i < vars.size(); i++) {
+      vars[i]->clearIdx();
+    }
+  }
 
   out.reset();
   out->exp() = NEW_EXP(Closure, func->stmt()->unsafe_cast<FunctionStatement>(),
@@ -1697,7 +1746,8 @@ void Parser::onClosureParam(Token &out, Token *params, Token &param,
   } else {
     out.reset();
   }
-  ParameterPtr p(new Parameter(this, "", param.text(), 0, ref,
+  ParameterPtr p(new Parameter(this, "", param.text(),
+                               declareVariable(String(param.text())), ref,
                                ExpressionPtr(), 0));
   out->params().push_back(p);
 }
@@ -1705,11 +1755,14 @@ void Parser::onClosureParam(Token &out, Token *params, Token &param,
 void Parser::onLabel(Token &out, Token &label) {
   out.reset();
   out->stmt() = NEW_STMT(Label, label.text());
+  if (haveFunc()) peekFunc()->setHasGoto();
+  *s_hasLabels = true;
 }
 
 void Parser::onGoto(Token &out, Token &label, bool limited) {
   out.reset();
   out->stmt() = NEW_STMT(Goto, label.text(), limited);
+  if (haveFunc()) peekFunc()->setHasGoto();
 }
 
 void Parser::onTypeDecl(Token &out, Token &type, Token &decl) {
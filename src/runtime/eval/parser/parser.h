@@ -159,7 +159,15 @@ class Parser : public ParserBase {
 public:
   static StatementPtr ParseString(CStrRef input, const char *fileName,
                                   std::vector<StaticStatementPtr> &statics,
-                                  Block::VariableIndices &variableIndice);
+                                  Block::VariableIndices &variableIndice,
+                                  const std::string &md5 = "");
+
+  /**
+   * Whether the last ParseString() on this thread saw any goto labels.
+   * Optimizations that drop statements must not run if so, since a label
+   * inside the dropped code could still be jumped to.
+   */
+  static bool HasLabels() { return *s_hasLabels; }
 
 public:
   Parser(Scanner &scanner, const char *fileName,
@@ -304,6 +312,18 @@ public:
   bool haveFunc() const;
   FunctionStatementPtr peekFunc() const;
 
+  /**
+   * Slot of a plain variable in the current function, or in the pseudomain
+   * outside of functions.
+   */
+  int declareVariable(CStrRef name);
+  /**
+   * Records a construct that can reach the current function's locals by
+   * name, for FunctionStatement::DynamicLocalsReport(). It doesn't change
+   * how any access is resolved.
+   */
+  void onDynamicLocal(const char *what);
+
   const Block::VariableIndices &varIndices() const {
     return m_fileBlock.varIndices();
   }
@@ -332,6 +352,8 @@ private:
   std::vector<bool> m_hasCallToGetArgs;
   std::vector<std::vector<StatementPtr> > m_prependingStatements;
 
+  static DECLARE_THREAD_LOCAL(bool, s_hasLabels);
+
   ExpressionPtr getDynamicVariable(ExpressionPtr exp, bool encap);
   ExpressionPtr createDynamicVariable(ExpressionPtr exp);
   NamePtr procStaticClassName(Token &className, bool text);
@@ -0,0 +1,327 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/ast/expression.h>
+#include <runtime/eval/ast/binary_op_expression.h>
+#include <runtime/eval/ast/scalar_value_expression.h>
+#include <runtime/eval/ast/statement.h>
+#include <runtime/eval/ast/unary_op_expression.h>
+#include <runtime/eval/ast/variable_expression.h>
+#include <runtime/eval/runtime/byte_code_program.h>
+#include <runtime/eval/runtime/variable_environment.h>
+
+namespace HPHP {
+namespace Eval {
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+/**
+ * Per-call registers. Zeroed memory is a valid uninitialized Variant, so
+ * small register files are just a stack buffer.
+ */
+class RegisterFile {
+public:
+  RegisterFile(int count) : m_count(count) {
+    if (count <= InlineCount) {
+      m_regs = (Variant *)m_inline;
+      memset(m_inline, 0, sizeof(Variant) * count);
+    } else {
+      m_regs = (Variant *)calloc(count, sizeof(Variant));
+    }
+  }
+  ~RegisterFile() {
+    for (int i = 0; i < m_count; i++) {
+      m_regs[i].unset();
+    }
+    if (m_regs != (Variant *)m_inline) free(m_regs);
+  }
+  Variant *regs() const { return m_regs; }
+private:
+  static const int InlineCount = 16;
+  int m_count;
+  Variant *m_regs;
+  char m_inline[sizeof(Variant) * InlineCount];
+};
+}
+
+ByteCodeProgram::ByteCodeProgram(bool refReturn)
+  : m_refReturn(refReturn), m_regTop(0) {}
+
+bool ByteCodeProgram::IsLowered(const Expression *exp) {
+  switch (exp->getKindOf()) {
+  case Expression::KindOfVariableExpression:
+  case Expression::KindOfScalarValueExpression:
+  case Expression::KindOfBinaryOpExpression:
+  case Expression::KindOfLogicalOrExpression:
+  case Expression::KindOfLogicalAndExpression:
+  case Expression::KindOfVariableAssignmentExpression:
+    return true;
+  case Expression::KindOfUnaryOpExpression:
+    return static_cast<const UnaryOpExpression *>(exp)->getOp() == '!';
+  default:
+    break;
+  }
+  return false;
+}
+
+int ByteCodeProgram::emit(Op op, int a /* = 0 */, int b /* = 0 */,
+                          int c /* = 0 */, const void *p /* = NULL */) {
+  if ((op == EvalExpr || op == StoreLocal) && a >= 0) {
+    // may hold on to an object, whose destructor must not be delayed
+    m_dirty[a] = true;
+  }
+  Instruction ins = { op, a, b, c, p };
+  m_code.push_back(ins);
+  return m_code.size() - 1;
+}
+
+int ByteCodeProgram::emitBranch(Op op, const Expression *cond) {
+  ASSERT(op == JmpZ || op == JmpNZ);
+  int mark = regMark();
+  int pos = emit(op, 0, operand(cond));
+  freeRegs(mark);
+  return pos;
+}
+
+int ByteCodeProgram::allocReg() {
+  if (m_regTop == (int)m_dirty.size()) {
+    m_dirty.push_back(false);
+  }
+  return m_regTop++;
+}
+
+void ByteCodeProgram::freeRegs(int mark) {
+  int lo = -1, hi = -1;
+  for (int i = mark; i < (int)m_dirty.size(); i++) {
+    if (m_dirty[i]) {
+      if (lo < 0) lo = i;
+      hi = i + 1;
+      m_dirty[i] = false;
+    }
+  }
+  if (lo >= 0) emit(Free, lo, hi);
+  m_regTop = mark;
+}
+
+int ByteCodeProgram::operand(const Expression *exp) {
+  switch (exp->getKindOf()) {
+  case Expression::KindOfVariableExpression:
+    return local(static_cast<const VariableExpression *>(exp));
+  case Expression::KindOfScalarValueExpression:
+    return constant(ScalarValueExpression::GetScalarValueByRef(
+                      const_cast<Expression *>(exp)));
+  default:
+    break;
+  }
+  int reg = allocReg();
+  exp->byteCode(*this, reg);
+  return (reg << 2) | RegOperand;
+}
+
+int ByteCodeProgram::constant(CVarRef v) {
+  m_constants.push_back(&v);
+  return ((m_constants.size() - 1) << 2) | ConstOperand;
+}
+
+int ByteCodeProgram::local(const VariableExpression *exp) {
+  m_locals.push_back(exp);
+  return ((m_locals.size() - 1) << 2) | LocalOperand;
+}
+
+void ByteCodeProgram::pushLoop() {
+  Loop loop;
+  loop.parent = currentLoop();
+  loop.breakTarget = loop.continueTarget = -1;
+  m_loops.push_back(loop);
+  m_loopStack.push_back(m_loops.size() - 1);
+}
+
+void ByteCodeProgram::popLoop(int breakTarget, int continueTarget) {
+  ASSERT(!m_loopStack.empty());
+  Loop &loop = m_loops[m_loopStack.back()];
+  loop.breakTarget = breakTarget;
+  loop.continueTarget = continueTarget;
+  for (unsigned int i = 0; i < loop.breaks.size(); i++) {
+    patch(loop.breaks[i], breakTarget);
+  }
+  for (unsigned int i = 0; i < loop.continues.size(); i++) {
+    patch(loop.continues[i], continueTarget);
+  }
+  loop.breaks.clear();
+  loop.continues.clear();
+  m_loopStack.pop_back();
+}
+
+void ByteCodeProgram::addBreak(int level, bool isBreak, int pos) {
+  ASSERT(level > 0 && level <= loopDepth());
+  Loop &loop = m_loops[m_loopStack[m_loopStack.size() - level]];
+  if (isBreak) {
+    loop.breaks.push_back(pos);
+  } else {
+    loop.continues.push_back(pos);
+  }
+}
+
+void ByteCodeProgram::finish() {
+  ASSERT(m_loopStack.empty());
+  emit(End);
+}
+
+inline CVarRef ByteCodeProgram::fetch(int operand, Variant *regs,
+                                      VariableEnvironment &env) const {
+  int idx = operand >> 2;
+  switch (operand & 3) {
+  case RegOperand:   return regs[idx];
+  case ConstOperand: return *m_constants[idx];
+  default:           break;
+  }
+  return m_locals[idx]->getRefCheck(env);
+}
+
+bool ByteCodeProgram::unwindBreak(int loop, VariableEnvironment &env,
+                                  int &pc) const {
+  // same as EVAL_STMT_HANDLE_BREAK at each of the enclosing loops
+  while (loop >= 0) {
+    const Loop &l = m_loops[loop];
+    int hb = env.handleBreak();
+    if (hb == 2) {
+      pc = l.breakTarget;
+      return true;
+    }
+    if (hb == 3) {
+      pc = l.continueTarget;
+      return true;
+    }
+    loop = l.parent;
+  }
+  return false;
+}
+
+void ByteCodeProgram::execute(VariableEnvironment &env) const {
+  DECLARE_THREAD_INFO;
+  RegisterFile file(m_dirty.size());
+  Variant *regs = file.regs();
+  const Instruction *code = &m_code[0];
+  const Instruction *ins = code;
+
+  static void *const dispatch[] = {
+    &&op_Line, &&op_Tick, &&op_BinOp, &&op_Bool, &&op_Not, &&op_StoreLocal,
+    &&op_EvalExpr, &&op_EvalStmt, &&op_Echo, &&op_Jmp, &&op_JmpZ,
+    &&op_JmpNZ, &&op_Ret, &&op_RetNull, &&op_Free, &&op_End,
+  };
+
+#define DISPATCH() goto *dispatch[ins->op]
+#define NEXT() ++ins; DISPATCH()
+#define JUMP(target) ins = code + (target); DISPATCH()
+#define FETCH(operand) fetch(operand, regs, env)
+
+  DISPATCH();
+
+op_Line: {
+    const Location *loc = ((const Construct *)ins->p)->loc();
+    set_line(loc->line0, loc->char0, loc->line1, loc->char1);
+    NEXT();
+  }
+op_Tick: {
+    LOOP_COUNTER_CHECK_INFO(1);
+    NEXT();
+  }
+op_BinOp: {
+    const BinaryOpExpression *exp = (const BinaryOpExpression *)ins->p;
+    regs[ins->a] = exp->evalOp(FETCH(ins->b), FETCH(ins->c));
+    NEXT();
+  }
+op_Bool: {
+    regs[ins->a] = FETCH(ins->b).toBoolean();
+    NEXT();
+  }
+op_Not: {
+    regs[ins->a] = !FETCH(ins->b).toBoolean();
+    NEXT();
+  }
+op_StoreLocal: {
+    CVarRef rhs = FETCH(ins->b);
+    Variant &lhs = ((const VariableExpression *)ins->p)->getRef(env);
+    lhs.assignVal(rhs);
+    if (ins->a >= 0) regs[ins->a] = lhs;
+    NEXT();
+  }
+op_EvalExpr: {
+    const Expression *exp = (const Expression *)ins->p;
+    if (ins->a >= 0) {
+      regs[ins->a] = exp->eval(env);
+    } else {
+      exp->eval(env);
+    }
+    NEXT();
+  }
+op_EvalStmt: {
+    ((const Statement *)ins->p)->eval(env);
+    if (UNLIKELY(env.isEscaping())) {
+      int pc;
+      if (!env.isReturning() && unwindBreak(ins->a, env, pc)) {
+        JUMP(pc);
+      }
+      return;
+    }
+    NEXT();
+  }
+op_Echo: {
+    echo(FETCH(ins->b).toString());
+    NEXT();
+  }
+op_Jmp: {
+    JUMP(ins->c);
+  }
+op_JmpZ: {
+    if (!FETCH(ins->b).toBoolean()) {
+      JUMP(ins->c);
+    }
+    NEXT();
+  }
+op_JmpNZ: {
+    if (FETCH(ins->b).toBoolean()) {
+      JUMP(ins->c);
+    }
+    NEXT();
+  }
+op_Ret: {
+    env.setRet(FETCH(ins->b));
+    return;
+  }
+op_RetNull: {
+    env.setRet();
+    return;
+  }
+op_Free: {
+    for (int i = ins->a; i < ins->b; i++) {
+      regs[i].unset();
+    }
+    NEXT();
+  }
+op_End:
+  return;
+
+#undef FETCH
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
@@ -0,0 +1,169 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __EVAL_RUNTIME_BYTE_CODE_PROGRAM_H__
+#define __EVAL_RUNTIME_BYTE_CODE_PROGRAM_H__
+
+#include <runtime/eval/base/eval_base.h>
+
+namespace HPHP {
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+class Construct;
+class Expression;
+class Statement;
+class VariableExpression;
+class VariableEnvironment;
+
+/**
+ * A function body lowered from the eval AST into a linear register program.
+ *
+ * Operands are encoded in one int: locals are read straight out of their
+ * variable slots, scalars out of the AST's ScalarValueExpressions, and
+ * everything else out of a per-call register file. Constructs without a
+ * byteCode() lowering compile to EvalExpr/EvalStmt, which just run the
+ * original AST node, so any function body can be compiled.
+ */
+class ByteCodeProgram {
+public:
+  enum Op {
+    Line,        // set_line() to p's location
+    Tick,        // loop back-edge, checks request timeout
+    BinOp,       // r[a] = p->evalOp(b, c), p being a BinaryOpExpression
+    Bool,        // r[a] = (bool)b
+    Not,         // r[a] = !b
+    StoreLocal,  // local p = b; r[a] = local p
+    EvalExpr,    // r[a] = p->eval(env)
+    EvalStmt,    // p->eval(env), a being the innermost loop
+    Echo,        // echo b
+    Jmp,         // goto c
+    JmpZ,        // if (!b) goto c
+    JmpNZ,       // if (b) goto c
+    Ret,         // return b
+    RetNull,     // return;
+    Free,        // unset r[a] .. r[b - 1]
+    End,
+  };
+
+  struct Instruction {
+    Op op;
+    int a;
+    int b;
+    int c;
+    const void *p;
+  };
+
+  /**
+   * "No result wanted" destination register.
+   */
+  static const int NoReg = -1;
+
+  ByteCodeProgram(bool refReturn);
+
+  /**
+   * Runs the program against a function's environment. Leaves env
+   * returning, or still breaking if a break went past the outermost loop,
+   * exactly as evaluating the function body's statements would.
+   */
+  void execute(VariableEnvironment &env) const;
+
+  bool refReturn() const { return m_refReturn; }
+
+  /**
+   * Compiling helpers used by Expression::byteCode() and
+   * Statement::byteCode().
+   */
+  int emit(Op op, int a = 0, int b = 0, int c = 0, const void *p = NULL);
+  int here() const { return m_code.size(); }
+  void patch(int pos, int target) { m_code[pos].c = target; }
+
+  void emitLine(const Construct *c) { emit(Line, 0, 0, 0, c); }
+  void emitTick() {
+#ifdef INFINITE_LOOP_DETECTION
+    emit(Tick);
+#endif
+  }
+  /**
+   * Conditional jump on an expression's value, to be patch()-ed.
+   */
+  int emitBranch(Op op, const Expression *cond);
+
+  int allocReg();
+  int regMark() const { return m_regTop; }
+  void releaseRegs(int mark) { m_regTop = mark; }
+  /**
+   * Same as releaseRegs(), but also drops values that may hold on to
+   * objects or big strings, so they don't outlive their statement.
+   */
+  void freeRegs(int mark);
+
+  /**
+   * Operand for an expression's value: locals and scalars are used in
+   * place, anything else is evaluated into a fresh register first.
+   */
+  int operand(const Expression *exp);
+  int constant(CVarRef v);
+  int local(const VariableExpression *exp);
+
+  void pushLoop();
+  void popLoop(int breakTarget, int continueTarget);
+  int loopDepth() const { return m_loopStack.size(); }
+  int currentLoop() const {
+    return m_loopStack.empty() ? -1 : m_loopStack.back();
+  }
+  void addBreak(int level, bool isBreak, int pos);
+
+  /**
+   * Resolves pending jumps and appends End; called once compiling is done.
+   */
+  void finish();
+
+  static bool IsLowered(const Expression *exp);
+
+private:
+  enum OperandKind {
+    RegOperand,
+    ConstOperand,
+    LocalOperand,
+  };
+
+  struct Loop {
+    int parent;
+    int breakTarget;
+    int continueTarget;
+    std::vector<int> breaks;
+    std::vector<int> continues;
+  };
+
+  bool m_refReturn;
+  std::vector<Instruction> m_code;
+  std::vector<const Variant *> m_constants;
+  std::vector<const VariableExpression *> m_locals;
+  std::vector<Loop> m_loops;
+  std::vector<int> m_loopStack;
+  int m_regTop;
+  std::vector<bool> m_dirty;
+
+  CVarRef fetch(int operand, Variant *regs, VariableEnvironment &env) const;
+  bool unwindBreak(int loop, VariableEnvironment &env, int &pc) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
+
+#endif /* __EVAL_RUNTIME_BYTE_CODE_PROGRAM_H__ */
@@ -52,6 +52,7 @@ public:
   virtual CStrRef o_getClassNameHook() const;
   virtual const MethodStatement *getMethodStatement(const char* name) const;
   virtual const MethodStatement *getConstructorStatement() const;
+  virtual const ClassEvalState *getClassEvalState() const { return &m_cls;}
 
   virtual bool o_get_call_info_hook(const char *clsname,
                                     MethodCallPackage &mcp, int64 hash = -1);
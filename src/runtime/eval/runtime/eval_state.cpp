@@ -30,6 +30,8 @@
 #include <runtime/eval/runtime/eval_object_data.h>
 #include <runtime/eval/ast/method_statement.h>
 #include <runtime/eval/eval.h>
+#include <runtime/base/server/server_stats.h>
+#include <util/lock.h>
 
 namespace HPHP {
 namespace Eval {
@@ -43,23 +45,86 @@ void CodeContainer::release() {
 StringCodeContainer::StringCodeContainer(StatementPtr s) : m_s(s) {}
 StringCodeContainer::~StringCodeContainer() {}
 
+// at most this many sets of ancestors are remembered for a class
+#define CLASS_TEMPLATES_PER_CLASS 4
+
+typedef hphp_hash_map<const ClassStatement *,
+                      vector<ClassEvalTemplatePtr>,
+                      pointer_hash<ClassStatement> > ClassTemplateMap;
+// never freed, as classes can outlive static destruction
+static Mutex &s_classTemplateMutex = *new Mutex();
+static ClassTemplateMap &s_classTemplates = *new ClassTemplateMap();
+
+ClassEvalTemplatePtr
+ClassEvalTemplate::Find(const ClassStatement *cls,
+                        const Ancestors &ancestors) {
+  Lock lock(s_classTemplateMutex);
+  ClassTemplateMap::const_iterator it = s_classTemplates.find(cls);
+  if (it != s_classTemplates.end()) {
+    const vector<ClassEvalTemplatePtr> &templates = it->second;
+    for (unsigned int i = 0; i < templates.size(); i++) {
+      if (templates[i]->m_ancestors == ancestors) return templates[i];
+    }
+  }
+  return ClassEvalTemplatePtr();
+}
+
+void ClassEvalTemplate::Add(const ClassStatement *cls,
+                            const Ancestors &ancestors,
+                            ClassEvalTemplatePtr t) {
+  t->m_ancestors = ancestors;
+  Lock lock(s_classTemplateMutex);
+  vector<ClassEvalTemplatePtr> &templates = s_classTemplates[cls];
+  if (templates.size() >= CLASS_TEMPLATES_PER_CLASS) {
+    // requests still using the oldest one keep their own reference
+    templates.erase(templates.begin());
+  }
+  templates.push_back(t);
+}
+
+void ClassEvalTemplate::Forget(const ClassStatement *cls) {
+  Lock lock(s_classTemplateMutex);
+  s_classTemplates.erase(cls);
+}
+
+const ClassEvalState::MethodTable ClassEvalState::s_noMethods;
+
 void ClassEvalState::init(const ClassStatement *cls) {
   m_class = cls;
 }
 
 const MethodStatement *ClassEvalState::getMethod(const char *m) {
   if (!m_doneSemanticCheck) semanticCheck();
-  MethodTable::const_iterator it = m_methodTable.find(m);
-  if (it == m_methodTable.end()) return NULL;
+  const MethodTable &methods = m_template->m_methodTable;
+  MethodTable::const_iterator it = methods.find(m);
+  if (it == methods.end()) return NULL;
   return it->second.first;
 }
 
 void ClassEvalState::semanticCheck() {
   if (!m_doneSemanticCheck) {
+    ClassEvalTemplate::Ancestors ancestors;
+    bool resolved = m_class->resolveAncestors(ancestors);
+    if (resolved) {
+      m_template = ClassEvalTemplate::Find(m_class, ancestors);
+      if (m_template) {
+        ServerStats::Log("eval.class_template.hit", 1);
+        m_doneSemanticCheck = true;
+        return;
+      }
+    }
+    int warnings = ClassStatement::CheckWarnings();
+    ClassEvalTemplatePtr t(new ClassEvalTemplate());
     set<const ClassStatement *> seen;
-    m_class->loadMethodTable(*this, seen);
+    m_class->loadMethodTable(*t, seen);
     m_class->semanticCheck(NULL);
+    m_template = t;
     m_doneSemanticCheck = true;
+    // warnings have to be raised again by every request
+    if (resolved && ClassStatement::CheckWarnings() == warnings) {
+      ServerStats::Log("eval.class_template.miss", 1);
+      ClassEvalTemplate::Add(m_class, ancestors, t);
+    }
   }
 }
 
@@ -81,14 +146,7 @@ void ClassEvalState::initializeStatics() {
 void ClassEvalState::fiberInit(ClassEvalState &oces,
                                FiberReferenceMap &refMap) {
   m_class = oces.m_class;
-  if (oces.m_constructor) {
-    m_constructor = oces.m_constructor;
-  }
-
-  for (MethodTable::const_iterator it = oces.m_methodTable.begin();
-       it != oces.m_methodTable.end(); ++it) {
-    m_methodTable[it->first] = it->second;
-  }
+  if (oces.m_template) m_template = oces.m_template;
   m_initializedStatics |= oces.m_initializedStatics;
   m_initializedInstance |= oces.m_initializedInstance;
   m_doneSemanticCheck |= oces.m_doneSemanticCheck;
@@ -119,13 +177,7 @@ void ClassEvalState::fiberExit(ClassEvalState &oces,
     m_initializedStatics |= oces.m_initializedStatics;
   }
 
-  if (oces.m_constructor) {
-    m_constructor = oces.m_constructor;
-  }
-  for (MethodTable::const_iterator it = oces.m_methodTable.begin();
-       it != oces.m_methodTable.end(); ++it) {
-    m_methodTable[it->first] = it->second;
-  }
+  if (oces.m_template) m_template = oces.m_template;
   m_initializedInstance |= oces.m_initializedInstance;
   m_doneSemanticCheck |= oces.m_doneSemanticCheck;
 }
@@ -35,12 +35,49 @@ class PhpFile;
 class Function;
 class EvalObjectData;
 
-class ClassEvalState {
+/**
+ * The parts of a class's ClassEvalState that only depend on its declaration
+ * and on the classes its parent and interface names resolve to. The first
+ * request to declare a class with a given set of ancestors builds and checks
+ * one, and later requests with the same ancestors share it read-only instead
+ * of building their own. Each class keeps a few, for classes whose parents
+ * differ from one request to the next. Hits and misses go to ServerStats as
+ * "eval.class_template.hit" and "eval.class_template.miss".
+ */
+class ClassEvalTemplate {
 public:
   typedef hphp_const_char_imap<std::pair<const MethodStatement*, int> >
     MethodTable;
-  ClassEvalState() : m_class(NULL), m_constructor(NULL),
-                     m_attributes(0),
+  /**
+   * What each parent and interface name resolved to, in the order
+   * ClassStatement::resolveAncestors() looks them up. Classes are paired
+   * with their serial number, so a freed class whose address got reused
+   * doesn't match.
+   */
+  typedef std::vector<std::pair<const ClassStatement*, int> > Ancestors;
+
+  ClassEvalTemplate() : m_constructor(NULL), m_attributes(0) {}
+
+  static boost::shared_ptr<ClassEvalTemplate>
+  Find(const ClassStatement *cls, const Ancestors &ancestors);
+  static void Add(const ClassStatement *cls, const Ancestors &ancestors,
+                  boost::shared_ptr<ClassEvalTemplate> t);
+  /**
+   * Called when a class is freed.
+   */
+  static void Forget(const ClassStatement *cls);
+
+  MethodTable m_methodTable;
+  const MethodStatement *m_constructor;
+  int m_attributes;
+  Ancestors m_ancestors;
+};
+typedef boost::shared_ptr<ClassEvalTemplate> ClassEvalTemplatePtr;
+
+class ClassEvalState {
+public:
+  typedef ClassEvalTemplate::MethodTable MethodTable;
+  ClassEvalState() : m_class(NULL),
                      m_initializedInstance(false),
                      m_initializedStatics(false),
                      m_doneSemanticCheck(false)
@@ -50,17 +87,18 @@ public:
     return m_class;
   }
   const MethodStatement *getMethod(const char *m);
-  MethodTable &getMethodTable() {
-    return m_methodTable;
+  const MethodTable &getMethodTable() const {
+    return m_template ? m_template->m_methodTable : s_noMethods;
   }
-  const MethodStatement* &getConstructor() {
-    return m_constructor;
+  const MethodStatement *getConstructor() const {
+    return m_template ? m_template->m_constructor : NULL;
   }
   LVariableTable &getStatics() {
     return m_statics;
   }
-  void setAttributes(int attrs) { m_attributes |= attrs; }
-  int getAttributes() const { return m_attributes; }
+  int getAttributes() const {
+    return m_template ? m_template->m_attributes : 0;
+  }
   void initializeInstance();
   void initializeStatics();
   void semanticCheck();
@@ -71,11 +109,11 @@ public:
   void fiberExitStatics(ClassEvalState &oces, FiberReferenceMap &refMap,
                         FiberAsyncFunc::Strategy default_strategy);
 private:
+  static const MethodTable s_noMethods;
+
   const ClassStatement *m_class;
-  MethodTable m_methodTable;
-  const MethodStatement *m_constructor;
+  ClassEvalTemplatePtr m_template;
   LVariableTable m_statics;
-  int m_attributes;
   bool m_initializedInstance;
   bool m_initializedStatics;
   bool m_doneSemanticCheck;
@@ -26,12 +26,21 @@
 #include <runtime/eval/runtime/eval_state.h>
 #include <runtime/base/server/source_root_info.h>
 #include <runtime/eval/ast/scalar_value_expression.h>
+#include <runtime/eval/ast/function_statement.h>
+#include <runtime/eval/runtime/parse_cache.h>
+#include <runtime/eval/runtime/stat_cache.h>
+#include <runtime/base/program_functions.h>
+#include <util/job_queue.h>
+#include <util/util.h>
+#include <util/logger.h>
 
 using namespace std;
 
 namespace HPHP {
 
+extern bool has_eval_support;
 extern bool (*file_dump)(const char *filename);
+extern void (*parse_time_histogram)(std::vector<int64> &counts);
 
 namespace Eval {
 ///////////////////////////////////////////////////////////////////////////////
@@ -84,6 +93,7 @@ hphp_hash_map<string, PhpFile*, string_hash> FileRepository::s_md5Files;
 static class FileDumpInitializer {
   public: FileDumpInitializer() {
     file_dump = FileRepository::fileDump;
+    parse_time_histogram = FileRepository::GetParseTimeHistogram;
   }
 } s_fileDumpInitializer;
 
@@ -280,16 +290,28 @@ bool FileRepository::readFile(const string &name,
   return true;
 }
 
+static JobQueueWaitHistogram s_parseTimes;
+
+void FileRepository::GetParseTimeHistogram(std::vector<int64> &counts) {
+  s_parseTimes.get(counts);
+}
+
 PhpFile *FileRepository::parseFile(const std::string &name,
                                    const FileInfo &fileInfo) {
+  int64 start = JobQueueWaitHistogram::Now();
   vector<StaticStatementPtr> sts;
   Block::VariableIndices variableIndices;
   if (RuntimeOption::EnableEvalOptimization) {
     ScalarValueExpression::initScalarValues();
   }
+  string md5 = fileInfo.m_md5;
+  if (md5.empty() && ParseCache::Enabled()) {
+    md5 = StringUtil::MD5(fileInfo.m_inputString).c_str();
+  }
+  FunctionStatement::ClearQueuedByteCode();
   StatementPtr stmt =
     Parser::ParseString(fileInfo.m_inputString, name.c_str(),
-                        sts, variableIndices);
+                        sts, variableIndices, md5);
   if (stmt && RuntimeOption::EnableEvalOptimization) {
     DummyVariableEnvironment env;
     stmt->optimize(env);
@@ -298,15 +320,106 @@ PhpFile *FileRepository::parseFile(const std::string &name,
     if (RuntimeOption::EnableEvalOptimization) {
       ScalarValueExpression::registerScalarValues();
     } 
+    FunctionStatement::CompileQueuedByteCode();
     PhpFile *p = new PhpFile(stmt, sts, variableIndices,
                              name, fileInfo.m_srcRoot,
                              fileInfo.m_relPath, fileInfo.m_md5);
+    s_parseTimes.record(start);
     return p;
   }
   return NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// preparsing
+
+static volatile bool s_preparseStopping = false;
+
+class PreparseWorker : public JobQueueWorker<std::string> {
+public:
+  virtual void onThreadEnter() {
+    hphp_session_init();
+  }
+
+  virtual void doJob(std::string name) {
+    if (s_preparseStopping) return;
+    struct stat s;
+    if (!FileRepository::findFile(name, &s)) return;
+    // key it the way requests will look it up, which is by real path when
+    // symlinks count, see RequestEvalState::includeFile()
+    string path = name;
+    char rpath[PATH_MAX];
+    if ((RuntimeOption::CheckSymLink || name[0] != '/') &&
+        realpath(name.c_str(), rpath)) {
+      path = rpath;
+    }
+    try {
+      // s_files keeps its own reference
+      PhpFile *f = FileRepository::checkoutFile(path, s);
+      if (f && f->decRef() == 0) {
+        FileRepository::onZeroRef(f);
+      }
+    } catch (Exception &e) {
+      Logger::Warning("Unable to preparse %s: %s", name.c_str(),
+                      e.getMessage().c_str());
+    } catch (...) {
+      Logger::Warning("Unable to preparse %s", name.c_str());
+    }
+  }
+
+  virtual void onThreadExit() {
+    hphp_session_exit();
+  }
+};
+
+static JobQueueDispatcher<std::string, PreparseWorker> *s_preparser = NULL;
+
+void FileRepository::StartPreparse() {
+  if (!has_eval_support || RuntimeOption::EvalPreparseThreads <= 0 ||
+      s_preparser) {
+    return;
+  }
+
+  vector<string> files;
+  const string &root = RuntimeOption::SourceRoot;
+  if (!RuntimeOption::EvalPreparseFileList.empty()) {
+    ifstream in(RuntimeOption::EvalPreparseFileList.c_str());
+    if (in.fail()) {
+      Logger::Error("Unable to read %s",
+                    RuntimeOption::EvalPreparseFileList.c_str());
+      return;
+    }
+    string line;
+    while (getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      files.push_back(line[0] == '/' || root.empty() ? line : root + line);
+    }
+  } else if (!root.empty()) {
+    Util::find(files, root, "", true);
+  }
+  if (files.empty()) return;
+
+  Logger::Info("preparsing %d files on %d threads", (int)files.size(),
+               RuntimeOption::EvalPreparseThreads);
+  s_preparseStopping = false;
+  s_preparser = new JobQueueDispatcher<std::string, PreparseWorker>
+    (RuntimeOption::EvalPreparseThreads, false, 0, false, NULL);
+  s_preparser->start();
+  for (unsigned int i = 0; i < files.size(); i++) {
+    s_preparser->enqueue(files[i]);
+  }
+}
+
+void FileRepository::StopPreparse() {
+  if (!s_preparser) return;
+  s_preparseStopping = true;
+  s_preparser->stop();
+  delete s_preparser;
+  s_preparser = NULL;
+}
+
 bool FileRepository::fileStat(const string &name, struct stat *s) {
+  if (StatCache::Enabled()) return StatCache::Stat(name, s);
   return stat(name.c_str(), s) == 0;
 }
 
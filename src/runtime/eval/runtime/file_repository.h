@@ -108,6 +108,21 @@ public:
   static PhpFile *parseFile(const std::string &name, const FileInfo &fileInfo);
   static String translateFileName(const std::string &file);
   static void onZeroRef(PhpFile *f);
+
+  /**
+   * Parses files into s_files on Eval.PreparseThreads background threads,
+   * either the ones listed in Eval.PreparseFileList or every PHP file under
+   * SourceRoot, so first requests don't parse them one by one. Files go in
+   * under their real paths with Server.CheckSymLink on, like requests look
+   * them up. StopPreparse() drops files still waiting to be parsed.
+   */
+  static void StartPreparse();
+  static void StopPreparse();
+
+  /**
+   * How long parseFile() took per file, in JobQueueWaitHistogram buckets.
+   */
+  static void GetParseTimeHistogram(std::vector<int64> &counts);
 private:
   static ReadWriteMutex s_lock;
   static hphp_hash_map<std::string, PhpFileWrapper*, string_hash> s_files;
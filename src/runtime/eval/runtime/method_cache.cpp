@@ -0,0 +1,69 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/runtime/method_cache.h>
+#include <runtime/base/server/server_stats.h>
+
+namespace HPHP { namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+IMPLEMENT_REQUEST_LOCAL(MethodCache, MethodCache::s_methodCache);
+
+MethodCache::MethodCache() : m_generation(0), m_hits(0), m_misses(0) {
+  memset(m_entries, 0, sizeof(m_entries));
+}
+
+void MethodCache::requestInit() {
+  if (++m_generation == 0) {
+    memset(m_entries, 0, sizeof(m_entries));
+    m_generation = 1;
+  }
+  m_hits = m_misses = 0;
+}
+
+void MethodCache::requestShutdown() {
+  if (m_hits) ServerStats::Log("eval.method_cache.hit", m_hits);
+  if (m_misses) ServerStats::Log("eval.method_cache.miss", m_misses);
+}
+
+const MethodStatement *MethodCache::Find(const void *site,
+                                         const ClassEvalState *cls,
+                                         const ClassStatement *context) {
+  MethodCache *cache = s_methodCache.get();
+  const Entry &e = Slot(cache, site, cls);
+  if (e.site == site && e.cls == cls && e.context == context &&
+      e.generation == cache->m_generation) {
+    cache->m_hits++;
+    return e.ms;
+  }
+  cache->m_misses++;
+  return NULL;
+}
+
+void MethodCache::Add(const void *site, const ClassEvalState *cls,
+                      const ClassStatement *context,
+                      const MethodStatement *ms) {
+  MethodCache *cache = s_methodCache.get();
+  Entry &e = Slot(cache, site, cls);
+  e.site = site;
+  e.cls = cls;
+  e.context = context;
+  e.ms = ms;
+  e.generation = cache->m_generation;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}}
@@ -0,0 +1,80 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_EVAL_METHOD_CACHE_H__
+#define __HPHP_EVAL_METHOD_CACHE_H__
+
+#include <runtime/base/util/request_local.h>
+
+namespace HPHP { namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+class ClassEvalState;
+class ClassStatement;
+class MethodStatement;
+
+/**
+ * Methods that ObjectMethodExpression call sites resolved, keyed by call site
+ * and receiver class. Classes, and so their method tables, can differ from
+ * one request to the next, so entries only live for the request they were
+ * made in. Hits and misses go to ServerStats as "eval.method_cache.hit" and
+ * "eval.method_cache.miss".
+ */
+class MethodCache : public RequestEventHandler {
+public:
+  MethodCache();
+  virtual void requestInit();
+  virtual void requestShutdown();
+
+  /**
+   * "context" is the calling class when the receiver is $this, as its
+   * private methods come first then, and NULL otherwise.
+   */
+  static const MethodStatement *Find(const void *site,
+                                     const ClassEvalState *cls,
+                                     const ClassStatement *context);
+  static void Add(const void *site, const ClassEvalState *cls,
+                  const ClassStatement *context, const MethodStatement *ms);
+
+  DECLARE_STATIC_REQUEST_LOCAL(MethodCache, s_methodCache);
+
+private:
+  static const int Size = 4096; // power of 2
+
+  struct Entry {
+    const void *site;
+    const ClassEvalState *cls;
+    const ClassStatement *context;
+    const MethodStatement *ms;
+    unsigned int generation;
+  };
+
+  Entry m_entries[Size];
+  unsigned int m_generation; // entries of earlier requests don't match
+  int64 m_hits;
+  int64 m_misses;
+
+  static Entry &Slot(MethodCache *cache, const void *site,
+                     const ClassEvalState *cls) {
+    size_t h = ((size_t)site >> 4) ^ ((size_t)cls >> 3);
+    return cache->m_entries[(h ^ (h >> 12)) & (Size - 1)];
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}}
+
+#endif // __HPHP_EVAL_METHOD_CACHE_H__
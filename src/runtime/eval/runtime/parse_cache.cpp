@@ -0,0 +1,264 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/runtime/parse_cache.h>
+#include <util/lock.h>
+#include <util/atomic.h>
+#include <util/hash.h>
+#include <util/logger.h>
+#include <util/util.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+using namespace std;
+
+namespace HPHP {
+
+extern void (*parse_cache_stats)(std::ostream &out);
+
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Cache file layout: a Header, then Header::count Entries sorted by md5 and
+ * scanner type, then the token streams the entries point at.
+ */
+static const char s_magic[8] = {'H', 'P', 'H', 'P', 'P', 'C', 0, 0};
+static const uint32 s_version = 1; // bump when token streams change format
+static const int MD5_LEN = 32;
+
+struct ParseCacheHeader {
+  char magic[8];
+  uint32 version;
+  uint32 count;
+  char compilerId[48];
+};
+
+struct ParseCacheEntry {
+  char md5[MD5_LEN];
+  int32 type;
+  uint32 length;
+  uint64 offset;
+  int64 checksum;
+};
+
+typedef std::map<std::pair<std::string, int>, std::string> AddedMap;
+
+static Mutex s_mutex;
+static volatile bool s_loaded = false;
+static void *s_base = NULL;
+static size_t s_size = 0;
+static const ParseCacheEntry *s_entries = NULL;
+static uint32 s_count = 0;
+static AddedMap s_added;
+static size_t s_flushed = 0;
+static int64 s_hits = 0;
+static int64 s_misses = 0;
+
+static void compiler_id(char (&id)[48]) {
+  memset(id, 0, sizeof(id));
+#ifdef COMPILER_ID
+  strncpy(id, COMPILER_ID, sizeof(id) - 1);
+#endif
+}
+
+static void load() {
+  const char *name = RuntimeOption::EvalParseCacheFile.c_str();
+  int fd = open(name, O_RDONLY);
+  if (fd == -1) return; // nothing cached yet
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) == 0 &&
+      sbuf.st_size >= (off_t)sizeof(ParseCacheHeader)) {
+    void *addr = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      Logger::Error("Unable to mmap %s: %s", name,
+                    Util::safe_strerror(errno).c_str());
+    } else {
+      const ParseCacheHeader *header = (const ParseCacheHeader *)addr;
+      char id[48];
+      compiler_id(id);
+      if (memcmp(header->magic, s_magic, sizeof(s_magic)) == 0 &&
+          header->version == s_version &&
+          memcmp(header->compilerId, id, sizeof(id)) == 0 &&
+          sizeof(ParseCacheHeader) +
+          (uint64)header->count * sizeof(ParseCacheEntry) <=
+          (uint64)sbuf.st_size) {
+        s_base = addr;
+        s_size = sbuf.st_size;
+        s_entries = (const ParseCacheEntry *)(header + 1);
+        s_count = header->count;
+      } else {
+        Logger::Info("Ignoring parse cache %s written by another build", name);
+        munmap(addr, sbuf.st_size);
+      }
+    }
+  }
+  close(fd);
+}
+
+static int compare(const ParseCacheEntry &e, const char *md5, int type) {
+  int c = memcmp(e.md5, md5, MD5_LEN);
+  if (c) return c;
+  return e.type < type ? -1 : (e.type > type ? 1 : 0);
+}
+
+static const char *stream_of(const ParseCacheEntry &e) {
+  if (e.offset > s_size || e.length > s_size - e.offset) return NULL;
+  const char *tokens = (const char *)s_base + e.offset;
+  if (hash_string_cs(tokens, e.length) != e.checksum) return NULL;
+  return tokens;
+}
+
+bool ParseCache::Find(const string &md5, int type,
+                      const char *&tokens, int &len, string &holder) {
+  if (!s_loaded) {
+    Lock lock(s_mutex);
+    if (!s_loaded) {
+      load();
+      s_loaded = true;
+    }
+  }
+  if (md5.size() != MD5_LEN) return false;
+
+  uint32 lo = 0, hi = s_count;
+  while (lo < hi) {
+    uint32 mid = lo + (hi - lo) / 2;
+    int c = compare(s_entries[mid], md5.data(), type);
+    if (c == 0) {
+      tokens = stream_of(s_entries[mid]);
+      if (!tokens) break;
+      len = s_entries[mid].length;
+      atomic_add(s_hits, (int64)1);
+      return true;
+    }
+    if (c < 0) lo = mid + 1; else hi = mid;
+  }
+
+  {
+    Lock lock(s_mutex);
+    AddedMap::const_iterator it = s_added.find(make_pair(md5, type));
+    if (it != s_added.end()) {
+      holder = it->second;
+      tokens = holder.data();
+      len = holder.size();
+      atomic_add(s_hits, (int64)1);
+      return true;
+    }
+  }
+  atomic_add(s_misses, (int64)1);
+  return false;
+}
+
+void ParseCache::Add(const string &md5, int type, const string &tokens) {
+  if (md5.size() != MD5_LEN) return;
+  Lock lock(s_mutex);
+  s_added.insert(make_pair(make_pair(md5, type), tokens));
+}
+
+void ParseCache::Flush() {
+  Lock lock(s_mutex);
+  if (s_added.size() == s_flushed) return;
+
+  // merge the mapped entries with the added ones, keeping the sort order
+  vector<ParseCacheEntry> entries;
+  vector<const char *> streams;
+  AddedMap::const_iterator it = s_added.begin();
+  uint32 i = 0;
+  while (i < s_count || it != s_added.end()) {
+    ParseCacheEntry e;
+    const char *tokens;
+    if (it == s_added.end() ||
+        (i < s_count && compare(s_entries[i], it->first.first.data(),
+                                it->first.second) < 0)) {
+      e = s_entries[i++];
+      tokens = stream_of(e);
+      if (!tokens) continue;
+    } else {
+      memcpy(e.md5, it->first.first.data(), MD5_LEN);
+      e.type = it->first.second;
+      e.length = it->second.size();
+      e.checksum = hash_string_cs(it->second.data(), e.length);
+      tokens = it->second.data();
+      if (i < s_count && compare(s_entries[i], e.md5, e.type) == 0) i++;
+      ++it;
+    }
+    entries.push_back(e);
+    streams.push_back(tokens);
+  }
+
+  ParseCacheHeader header;
+  memcpy(header.magic, s_magic, sizeof(s_magic));
+  header.version = s_version;
+  header.count = entries.size();
+  compiler_id(header.compilerId);
+  uint64 offset = sizeof(header) + entries.size() * sizeof(ParseCacheEntry);
+  for (unsigned int j = 0; j < entries.size(); j++) {
+    entries[j].offset = offset;
+    offset += entries[j].length;
+  }
+
+  // write a new file and rename it over the old one, so processes that have
+  // the old one mapped keep reading it
+  const string &name = RuntimeOption::EvalParseCacheFile;
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".tmp.%d", (int)getpid());
+  string tmp = name + suffix;
+  FILE *f = fopen(tmp.c_str(), "w");
+  if (!f) {
+    Logger::Error("Unable to write %s: %s", tmp.c_str(),
+                  Util::safe_strerror(errno).c_str());
+    return;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+    (entries.empty() ||
+     fwrite(&entries[0], sizeof(ParseCacheEntry), entries.size(), f) ==
+     entries.size());
+  for (unsigned int j = 0; ok && j < entries.size(); j++) {
+    ok = fwrite(streams[j], 1, entries[j].length, f) == entries[j].length;
+  }
+  if (fclose(f) != 0) ok = false;
+  if (!ok || rename(tmp.c_str(), name.c_str()) != 0) {
+    Logger::Error("Unable to write %s: %s", name.c_str(),
+                  Util::safe_strerror(errno).c_str());
+    unlink(tmp.c_str());
+    return;
+  }
+  s_flushed = s_added.size();
+}
+
+void ParseCache::Stats(ostream &out) {
+  Lock lock(s_mutex);
+  size_t bytes = 0;
+  for (AddedMap::const_iterator it = s_added.begin(); it != s_added.end();
+       ++it) {
+    bytes += it->second.size();
+  }
+  out << "hits " << s_hits << "\n"
+      << "misses " << s_misses << "\n"
+      << "entries " << s_count << "\n"
+      << "added " << s_added.size() << "\n"
+      << "bytes " << s_size + bytes << "\n";
+}
+
+static class ParseCacheStatsInitializer {
+  public: ParseCacheStatsInitializer() {
+    parse_cache_stats = ParseCache::Stats;
+  }
+} s_parseCacheStatsInitializer;
+
+///////////////////////////////////////////////////////////////////////////////
+}}
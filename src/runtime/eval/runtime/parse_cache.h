@@ -0,0 +1,66 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_EVAL_PARSE_CACHE_H__
+#define __HPHP_EVAL_PARSE_CACHE_H__
+
+#include <runtime/base/runtime_option.h>
+
+namespace HPHP { namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Token streams of parsed files, kept in a single mmapped file across
+ * restarts (Eval.ParseCacheFile). A stream is keyed by the md5 of the source
+ * and the scanner type it was lexed with, and the file is only used if the
+ * same build wrote it, so a warm start replays tokens into the parser instead
+ * of lexing every file again. Streams recorded in this process are written
+ * out at exit.
+ */
+class ParseCache {
+public:
+  static bool Enabled() {
+    return !RuntimeOption::EvalParseCacheFile.empty();
+  }
+
+  /**
+   * Points "tokens" at the stream of a source, which stays valid for the rest
+   * of the process, except that streams recorded by this process are copied
+   * into "holder".
+   */
+  static bool Find(const std::string &md5, int type,
+                   const char *&tokens, int &len, std::string &holder);
+
+  /**
+   * Keeps the stream of a successfully parsed source for Flush().
+   */
+  static void Add(const std::string &md5, int type, const std::string &tokens);
+
+  /**
+   * Writes the cache file again if this process recorded any streams.
+   */
+  static void Flush();
+
+  /**
+   * "hits", "misses", "entries", "added" and "bytes" lines.
+   */
+  static void Stats(std::ostream &out);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}}
+
+#endif // __HPHP_EVAL_PARSE_CACHE_H__
@@ -0,0 +1,287 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/runtime/stat_cache.h>
+#include <util/lock.h>
+#include <util/async_func.h>
+#include <util/logger.h>
+#include <util/util.h>
+#include <util/atomic.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace HPHP { namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+static const uint32 WATCH_MASK =
+  IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE |
+  IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+struct StatCacheEntry {
+  bool exists;
+  bool revalidate; // not everything the path depends on is watched
+  time_t checked;
+  struct stat st;
+};
+
+typedef hphp_hash_map<string, StatCacheEntry, string_hash> StatCacheMap;
+
+class StatCacheWatcher {
+public:
+  void run();
+};
+
+static ReadWriteMutex s_lock;
+static StatCacheMap s_entries;
+// every directory a cached path goes through, by name with a trailing '/',
+// and the other way around; one directory can have several names
+static hphp_hash_map<string, int, string_hash> s_dirWatches;
+static hphp_hash_map<int, vector<string> > s_watchedDirs;
+static int64 s_invalidations = 0;
+static int64 s_misses = 0;
+static int s_fd = -1;
+static bool s_started = false;
+static volatile bool s_stopping = false;
+static StatCacheWatcher s_watcher;
+static AsyncFunc<StatCacheWatcher> *s_thread = NULL;
+
+/**
+ * Needs the write lock. Returns the watch of a directory, or -1 if it can't
+ * be watched.
+ */
+static int watch_dir(const string &dir) {
+  if (!s_started) {
+    s_started = true;
+    s_fd = inotify_init();
+    if (s_fd < 0) {
+      Logger::Warning("inotify unavailable, revalidating stat cache every "
+                      "%d seconds: %s", RuntimeOption::EvalStatCacheRevalidate,
+                      Util::safe_strerror(errno).c_str());
+    } else {
+      s_thread = new AsyncFunc<StatCacheWatcher>(&s_watcher,
+                                                 &StatCacheWatcher::run);
+      s_thread->start();
+    }
+  }
+  if (s_fd < 0) return -1;
+
+  hphp_hash_map<string, int, string_hash>::const_iterator it =
+    s_dirWatches.find(dir);
+  if (it != s_dirWatches.end()) return it->second;
+  int wd = inotify_add_watch(s_fd, dir.c_str(), WATCH_MASK);
+  if (wd < 0) {
+    // a missing directory may show up later, others won't get any better
+    if (errno != ENOENT) s_dirWatches[dir] = -1;
+    return -1;
+  }
+  s_dirWatches[dir] = wd;
+  s_watchedDirs[wd].push_back(dir);
+  return wd;
+}
+
+/**
+ * Needs the write lock. Forgets everything at or under "dir", which ends
+ * with '/', since its name may now lead somewhere else.
+ */
+static void drop_dir(const string &dir) {
+  for (hphp_hash_map<string, int, string_hash>::iterator iter =
+         s_dirWatches.begin(); iter != s_dirWatches.end(); ) {
+    if (iter->first.compare(0, dir.size(), dir) != 0) {
+      ++iter;
+      continue;
+    }
+    int wd = iter->second;
+    if (wd >= 0) {
+      vector<string> &names = s_watchedDirs[wd];
+      vector<string>::iterator name =
+        std::find(names.begin(), names.end(), iter->first);
+      if (name != names.end()) names.erase(name);
+      if (names.empty()) {
+        s_watchedDirs.erase(wd);
+        inotify_rm_watch(s_fd, wd);
+      }
+    }
+    s_dirWatches.erase(iter++);
+  }
+  for (StatCacheMap::iterator iter = s_entries.begin();
+       iter != s_entries.end(); ) {
+    if (iter->first.compare(0, dir.size(), dir) == 0) {
+      s_entries.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+/**
+ * Needs the write lock. Something happened to "path" in a watched directory.
+ */
+static void invalidate(const string &path) {
+  s_entries.erase(path);
+  // a directory, or a symlink to one, that cached paths go through
+  string dir = path + "/";
+  if (s_dirWatches.find(dir) != s_dirWatches.end()) {
+    drop_dir(dir);
+  }
+}
+
+static bool is_symlink(const string &path) {
+  struct stat ls;
+  return lstat(path.c_str(), &ls) == 0 && S_ISLNK(ls.st_mode);
+}
+
+bool StatCache::Stat(const string &path, struct stat *s) {
+  // relative paths depend on the current directory, and have no root for
+  // the directory walk below to end at
+  if (path.empty() || path[0] != '/') {
+    return stat(path.c_str(), s) == 0;
+  }
+  size_t pos = path.rfind('/');
+
+  time_t now = time(NULL);
+  {
+    ReadLock lock(s_lock);
+    StatCacheMap::const_iterator it = s_entries.find(path);
+    if (it != s_entries.end() &&
+        (!it->second.revalidate ||
+         now - it->second.checked < RuntimeOption::EvalStatCacheRevalidate)) {
+      if (!it->second.exists) return false;
+      *s = it->second.st;
+      return true;
+    }
+  }
+  atomic_add(s_misses, (int64)1);
+
+  // Every directory on the way is watched, so renaming any of them, or
+  // pointing a symlink in the path somewhere else, shows up as an event on
+  // the one above it. Watch before stat(), so no change after it can be
+  // missed, and only take the write lock for directories not watched yet.
+  vector<string> dirs;
+  for (size_t p = pos; ; p = path.rfind('/', p - 1)) {
+    dirs.push_back(path.substr(0, p + 1));
+    if (p == 0) break;
+  }
+  bool watched = true;
+  bool known = true;
+  int64 invalidations;
+  {
+    ReadLock lock(s_lock);
+    for (unsigned int i = 0; i < dirs.size() && known; i++) {
+      hphp_hash_map<string, int, string_hash>::const_iterator it =
+        s_dirWatches.find(dirs[i]);
+      if (it == s_dirWatches.end()) {
+        known = false;
+      } else if (it->second < 0) {
+        watched = false;
+      }
+    }
+    invalidations = s_invalidations;
+  }
+  if (!known) {
+    WriteLock lock(s_lock);
+    watched = true;
+    for (unsigned int i = 0; i < dirs.size(); i++) {
+      if (watch_dir(dirs[i]) < 0) watched = false;
+    }
+    invalidations = s_invalidations;
+  }
+
+  StatCacheEntry entry;
+  entry.exists = stat(path.c_str(), &entry.st) == 0;
+  entry.checked = now;
+  entry.revalidate = !watched;
+  // Changes to a symlink's target, or above a symlinked directory's target,
+  // don't show up on any directory of the path itself.
+  if (entry.exists && !entry.revalidate) {
+    entry.revalidate = is_symlink(path);
+    for (unsigned int i = 0; i + 1 < dirs.size() && !entry.revalidate; i++) {
+      entry.revalidate = is_symlink(dirs[i].substr(0, dirs[i].size() - 1));
+    }
+  }
+  if (entry.exists) *s = entry.st;
+
+  WriteLock lock(s_lock);
+  // an event between stat() and here may be about this very path
+  if (invalidations == s_invalidations) {
+    s_entries[path] = entry;
+  }
+  return entry.exists;
+}
+
+int64 StatCache::GetMisses() {
+  return s_misses;
+}
+
+void StatCacheWatcher::run() {
+  char buf[64 * 1024]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  while (!s_stopping) {
+    pollfd fds;
+    fds.fd = s_fd;
+    fds.events = POLLIN;
+    if (poll(&fds, 1, 1000) <= 0) continue; // timeout to check s_stopping
+    int len = read(s_fd, buf, sizeof(buf));
+    if (len <= 0) continue;
+
+    WriteLock lock(s_lock);
+    s_invalidations++;
+    for (char *p = buf; p < buf + len; ) {
+      inotify_event *e = (inotify_event *)p;
+      p += sizeof(inotify_event) + e->len;
+      if (e->mask & IN_Q_OVERFLOW) {
+        // events were lost, including maybe ones about directories
+        drop_dir("/");
+        continue;
+      }
+      hphp_hash_map<int, vector<string> >::const_iterator it =
+        s_watchedDirs.find(e->wd);
+      if (it == s_watchedDirs.end()) continue;
+      vector<string> names = it->second; // drop_dir() may change it
+      for (unsigned int i = 0; i < names.size(); i++) {
+        if (e->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+          drop_dir(names[i]);
+        } else if (e->len) {
+          invalidate(names[i] + e->name);
+        }
+      }
+    }
+  }
+}
+
+void StatCache::Stop() {
+  if (s_thread) {
+    s_stopping = true;
+    s_thread->waitForEnd();
+    delete s_thread;
+    s_thread = NULL;
+  }
+  WriteLock lock(s_lock);
+  if (s_fd >= 0) {
+    close(s_fd);
+    s_fd = -1;
+  }
+  s_entries.clear();
+  s_dirWatches.clear();
+  s_watchedDirs.clear();
+  s_started = false;
+  s_stopping = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}}
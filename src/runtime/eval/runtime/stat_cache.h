@@ -0,0 +1,61 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_EVAL_STAT_CACHE_H__
+#define __HPHP_EVAL_STAT_CACHE_H__
+
+#include <runtime/base/runtime_option.h>
+#include <sys/stat.h>
+
+namespace HPHP { namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * stat() results of included files, kept across requests (Eval.StatCache).
+ * Every directory of a cached path, up to the root, is watched with inotify,
+ * and a watcher thread drops entries as their files change, so an unchanged
+ * include costs no system call at all. Renaming a directory, or pointing a
+ * symlinked one somewhere else, drops everything under it.
+ *
+ * inotify can't see changes to a symlink's target, or to the directories
+ * above a symlinked directory's target. So symlinks, paths through them,
+ * and paths with a directory that can't be watched, are stat()ed again once
+ * their entry is older than Eval.StatCacheRevalidate seconds.
+ */
+class StatCache {
+public:
+  static bool Enabled() { return RuntimeOption::EvalStatCache;}
+
+  /**
+   * Same as stat(), for absolute paths.
+   */
+  static bool Stat(const std::string &path, struct stat *s);
+
+  /**
+   * How many Stat() calls had to stat() the path.
+   */
+  static int64 GetMisses();
+
+  /**
+   * Drops all entries and stops the watcher thread.
+   */
+  static void Stop();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}}
+
+#endif // __HPHP_EVAL_STAT_CACHE_H__
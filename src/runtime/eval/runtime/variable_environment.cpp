@@ -81,24 +81,69 @@ void VariableEnvironment::InitTempStack() {
   s_tempStack.getCheck();
 }
 
+#define SLOT_STACK_SIZE 16384
+
+/**
+ * Slot tables of all live environments on a thread. Environments are only
+ * ever created on the C++ stack, so their tables are freed in the reverse
+ * order they were taken, and a call never has to malloc one. Frames that
+ * don't fit any more, in very deep recursion, get theirs from the heap.
+ */
+class SlotStack {
+public:
+  SlotStack() : m_size(0) {}
+  ~SlotStack() {
+    assert(m_size == 0);
+  }
+  Variant **alloc(int size) {
+    ASSERT(size > 0);
+    if (UNLIKELY(m_size + size > SLOT_STACK_SIZE)) {
+      return (Variant **)calloc(size, sizeof(Variant *));
+    }
+    Variant **slots = m_stack + m_size;
+    memset(slots, 0, size * sizeof(Variant *));
+    m_size += size;
+    return slots;
+  }
+  void release(Variant **slots, int size) {
+    if (slots < m_stack || slots >= m_stack + SLOT_STACK_SIZE) {
+      free(slots);
+      return;
+    }
+    ASSERT(slots + size == m_stack + m_size);
+    m_size -= size;
+  }
+private:
+  Variant *m_stack[SLOT_STACK_SIZE];
+  int m_size;
+};
+IMPLEMENT_THREAD_LOCAL_NO_CHECK(SlotStack, s_slotStack);
+
+void VariableEnvironment::InitSlotStack() {
+  s_slotStack.getCheck();
+}
+
 VariableEnvironment::VariableEnvironment()
     : m_currentClass(NULL), m_breakLevel(0), m_returning(false),
-      m_closure(NULL)
+      m_closure(NULL), m_byIdx(NULL), m_slotCount(0)
 {
 }
 
+VariableEnvironment::~VariableEnvironment() {
+  if (m_byIdx) s_slotStack->release(m_byIdx, m_slotCount);
+}
+
+void VariableEnvironment::allocSlots(int count) {
+  ASSERT(!m_byIdx);
+  if (count > 0) {
+    m_byIdx = s_slotStack->alloc(count);
+    m_slotCount = count;
+  }
+}
+
 void VariableEnvironment::flagGlobal(CStrRef name, int idx) {
   if (isKindOf(KindOfFuncScopeVariableEnvironment)) {
-    FuncScopeVariableEnvironment *fenv =
-      static_cast<FuncScopeVariableEnvironment *>(this);
-    Variant *var = fenv->getIdx(idx);
-    if (!var) {
-      AssocList &alist = fenv->getAssocList();
-      ASSERT(!alist.getPtr(name));
-      var = &alist.append(name);
-      fenv->setIdx(idx, var);
-    }
-    var->assignRef(get_globals()->get(name));
+    getVarByIdx(name, idx).assignRef(get_globals()->get(name));
     return;
   }
   getVar(name, SgNormal).assignRef(get_globals()->get(name));
@@ -139,6 +184,12 @@ void VariableEnvironment::setIdx(int idx, Variant *v) {
   throw FatalErrorException("setIdx not supported in this env");
 }
 
+Variant &VariableEnvironment::bindIdx(CStrRef name, int idx) {
+  Variant *v = &getVar(name, SgNormal);
+  setIdx(idx, v);
+  return *v;
+}
+
 Array VariableEnvironment::getDefinedVariables() const {
   return Array::Create();
 }
@@ -194,7 +245,7 @@ FuncScopeVariableEnvironment::FuncScopeVariableEnvironment(
   : m_func(func), m_staticEnv(NULL), m_argc(0),
     m_argStart(RequestEvalState::argStack().pos()) {
   m_kindOf = KindOfFuncScopeVariableEnvironment;
-  m_byIdx.resize(func->varIndices().size(), NULL);
+  allocSlots(func->varIndices().size());
 }
 
 FuncScopeVariableEnvironment::~FuncScopeVariableEnvironment() {
@@ -202,7 +253,7 @@ FuncScopeVariableEnvironment::~FuncScopeVariableEnvironment() {
   ASSERT(RequestEvalState::argStack().pos() == m_argStart);
 }
 
-void FuncScopeVariableEnvironment::flagStatic(CStrRef name, int64 hash) {
+Variant &FuncScopeVariableEnvironment::getStaticVar(CStrRef name) {
   if (!m_staticEnv) {
     void *closure = getClosure();
     if (UNLIKELY(closure != NULL)) {
@@ -226,7 +277,15 @@ void FuncScopeVariableEnvironment::flagStatic(CStrRef name, int64 hash) {
   if (!m_staticEnv->exists(name.data())) {
     m_staticEnv->getVar(name, SgNormal) = m_func->getStaticValue(*this, name);
   }
-  getVar(name, SgNormal).assignRef(m_staticEnv->getVar(name, SgNormal));
+  return m_staticEnv->getVar(name, SgNormal);
+}
+
+void FuncScopeVariableEnvironment::flagStatic(CStrRef name, int64 hash) {
+  getVar(name, SgNormal).assignRef(getStaticVar(name));
+}
+
+void FuncScopeVariableEnvironment::flagStaticIdx(CStrRef name, int idx) {
+  getVarByIdx(name, idx).assignRef(getStaticVar(name));
 }
 
 void FuncScopeVariableEnvironment::setIdx(int idx, Variant *v) {
@@ -234,6 +293,15 @@ void FuncScopeVariableEnvironment::setIdx(int idx, Variant *v) {
   m_byIdx[idx] = v;
 }
 
+Variant &FuncScopeVariableEnvironment::bindIdx(CStrRef name, int idx) {
+  // a declared name is only ever added to the list together with its slot
+  ASSERT(m_byIdx[idx] == NULL);
+  ASSERT(!m_alist.getPtr(name));
+  Variant *v = &m_alist.append(name);
+  m_byIdx[idx] = v;
+  return *v;
+}
+
 bool FuncScopeVariableEnvironment::refReturn() const {
   return m_func->refReturn();
 }
@@ -308,7 +376,7 @@ NestedVariableEnvironment::NestedVariableEnvironment
  CObjRef current_object /* = Object() */)
   : m_ext(ext), m_block(blk), m_params(params) {
   m_kindOf = KindOfNestedVariableEnvironment;
-  m_byIdx.resize(m_block.varIndices().size(), NULL);
+  allocSlots(m_block.varIndices().size());
   if (!current_object.isNull()) setCurrentObject(current_object);
 }
 
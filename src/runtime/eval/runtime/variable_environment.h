@@ -42,6 +42,7 @@ public:
     KindOfDummyVariableEnvironment,
   };
   VariableEnvironment();
+  virtual ~VariableEnvironment();
   void setCurrentObject(CObjRef co);
   void setCurrentClass(const char* cls);
   virtual void flagStatic(CStrRef name, int64 hash = -1) = 0;
@@ -51,6 +52,19 @@ public:
   Variant *getIdx(int idx) { return m_byIdx[idx]; }
   bool isKindOf(KindOf kindOf) { return m_kindOf == kindOf; }
   virtual void setIdx(int idx, Variant *v);
+  /**
+   * The variable in slot idx, which the parser gave to the plain (not
+   * superglobal) variable name. The slot is bound on first use.
+   */
+  Variant &getVarByIdx(CStrRef name, int idx) {
+    if (Variant *v = m_byIdx[idx]) return *v;
+    return bindIdx(name, idx);
+  }
+  virtual Variant &bindIdx(CStrRef name, int idx);
+  /**
+   * Same as flagStatic(), for a static variable the parser gave a slot to.
+   */
+  virtual void flagStaticIdx(CStrRef name, int idx) { flagStatic(name); }
   Variant &currentObject() { return m_currentObject; }
   virtual const char* currentClass() const;
   virtual const ClassStatement *currentClassStatement() const;
@@ -116,7 +130,10 @@ public:
   Variant getTempVariable(int index);
   void releaseTempVariables(int size, int oldPrevSize);
   static void InitTempStack();
+  static void InitSlotStack();
 protected:
+  void allocSlots(int count);
+
   Variant m_currentObject;
   const char* m_currentClass;
   int m_breakLevel;
@@ -125,7 +142,8 @@ protected:
   std::string m_label;
   bool m_limitedGoto;
   Variant m_ret;
-  std::vector<Variant*> m_byIdx;
+  Variant **m_byIdx;
+  int m_slotCount;
   KindOf m_kindOf;
 };
 
@@ -153,7 +171,9 @@ public:
   FuncScopeVariableEnvironment(const FunctionStatement *func);
   ~FuncScopeVariableEnvironment();
   virtual void flagStatic(CStrRef name, int64 hash = -1);
+  virtual void flagStaticIdx(CStrRef name, int idx);
   virtual void setIdx(int idx, Variant *v);
+  virtual Variant &bindIdx(CStrRef name, int idx);
   virtual bool refReturn() const;
   virtual Array getParams() const;
   virtual Variant &getVar(CStrRef s, SuperGlobal sg);
@@ -162,8 +182,8 @@ public:
   void incArgc() { m_argc++; }
   virtual Array getDefinedVariables() const;
   virtual ObjectData *getContinuation() const;
-  AssocList &getAssocList() { return m_alist; }
 private:
+  Variant &getStaticVar(CStrRef name);
 
   const FunctionStatement *m_func;
   LVariableTable *m_staticEnv;
@@ -1058,20 +1058,25 @@ static Variant php_mysql_fetch_hash(CVarRef result, int result_type) {
   MySQLResult *res = get_result(result);
   if (res == NULL) return false;
 
-  Array ret;
+  // Rows are created at their final size, and column names come from the
+  // result's field info so every row shares the same key strings.
+  int fields = res->getFieldCount();
   if (res->isLocalized()) {
     if (!res->fetchRow()) return false;
+    if (fields == 0) return Array::Create();
 
-    for (int i = 0; i < res->getFieldCount(); i++) {
+    ArrayInit ret(result_type == MYSQL_BOTH ? fields * 2 : fields);
+    for (int i = 0; i < fields; i++) {
+      Variant data = res->getField(i);
       if (result_type & MYSQL_NUM) {
-        ret.set(i, res->getField(i));
+        ret.set((int64)i, data);
       }
       if (result_type & MYSQL_ASSOC) {
         MySQLFieldInfo *info = res->getFieldInfo(i);
-        ret.set(info->name->toString(), res->getField(i));
+        ret.set(info->name->toString(), data);
       }
     }
-    return ret;
+    return Array(ret.create());
   }
 
   MYSQL_RES *mysql_result = res->get();
@@ -1084,25 +1089,25 @@ static Variant php_mysql_fetch_hash(CVarRef result, int result_type) {
     return false;
   }
 
-  mysql_field_seek(mysql_result, 0);
+  MYSQL_FIELD *mysql_fields = mysql_fetch_fields(mysql_result);
+  if (!mysql_fields || fields == 0) return Array::Create();
 
-  MYSQL_FIELD *mysql_field;
-  int i;
-  for (mysql_field = mysql_fetch_field(mysql_result), i = 0; mysql_field;
-       mysql_field = mysql_fetch_field(mysql_result), i++) {
+  ArrayInit ret(result_type == MYSQL_BOTH ? fields * 2 : fields);
+  for (int i = 0; i < fields; i++) {
     Variant data;
     if (mysql_row[i]) {
       data = mysql_makevalue(String(mysql_row[i], mysql_row_lengths[i],
-                                    CopyString), mysql_field);
+                                    CopyString), mysql_fields + i);
     }
     if (result_type & MYSQL_NUM) {
-      ret.set(i, data);
+      ret.set((int64)i, data);
     }
     if (result_type & MYSQL_ASSOC) {
-      ret.set(String(mysql_field->name, CopyString), data);
+      MySQLFieldInfo *info = res->getFieldInfo(i);
+      ret.set(info->name->toString(), data);
     }
   }
-  return ret;
+  return Array(ret.create());
 }
 
 Variant f_mysql_fetch_row(CVarRef result) {
@@ -1130,6 +1135,54 @@ Variant f_mysql_fetch_object(CVarRef result,
   return false;
 }
 
+Variant f_mysql_fetch_all_columns(CVarRef result) {
+  MySQLResult *res = get_result(result);
+  if (res == NULL) return false;
+
+  int fields = res->getFieldCount();
+  if (fields == 0 || !res->getFieldInfo(0)) return Array::Create();
+
+  // One array per column, presized to the result's total row count. That
+  // over-allocates when some rows were fetched already, as neither kind of
+  // result tells how many are left without walking them.
+  int64 rows = res->getRowCount();
+  std::vector<Array> columns(fields);
+  for (int i = 0; i < fields; i++) {
+    columns[i] = rows > 0 ? Array(ArrayInit(rows).create()) : Array::Create();
+  }
+
+  if (res->isLocalized()) {
+    while (res->fetchRow()) {
+      for (int i = 0; i < fields; i++) {
+        columns[i].append(res->getField(i));
+      }
+    }
+  } else {
+    MYSQL_RES *mysql_result = res->get();
+    MYSQL_FIELD *mysql_fields = mysql_fetch_fields(mysql_result);
+    MYSQL_ROW mysql_row;
+    while ((mysql_row = mysql_fetch_row(mysql_result))) {
+      unsigned long *mysql_row_lengths = mysql_fetch_lengths(mysql_result);
+      if (!mysql_row_lengths) break;
+      for (int i = 0; i < fields; i++) {
+        Variant data;
+        if (mysql_row[i]) {
+          data = mysql_makevalue(String(mysql_row[i], mysql_row_lengths[i],
+                                        CopyString), mysql_fields + i);
+        }
+        columns[i].append(data);
+      }
+    }
+  }
+
+  ArrayInit ret(fields);
+  for (int i = 0; i < fields; i++) {
+    MySQLFieldInfo *info = res->getFieldInfo(i);
+    ret.set(info->name->toString(), columns[i]);
+  }
+  return Array(ret.create());
+}
+
 Variant f_mysql_fetch_lengths(CVarRef result) {
   MySQLResult *res = get_result(result);
   if (res == NULL) return false;
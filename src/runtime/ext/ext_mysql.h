@@ -375,6 +375,8 @@ Variant f_mysql_fetch_assoc(CVarRef result);
 
 Variant f_mysql_fetch_array(CVarRef result, int result_type = 3);
 
+Variant f_mysql_fetch_all_columns(CVarRef result);
+
 Variant f_mysql_fetch_lengths(CVarRef result);
 
 Variant f_mysql_fetch_object(CVarRef result, CStrRef class_name = "stdClass",
@@ -145,6 +145,30 @@ String f_pagelet_server_task_result(CObjRef task, VRefParam headers,
   return response;
 }
 
+Array f_pagelet_server_tasks_start(CArrRef requests) {
+  Array tasks = Array::Create();
+  for (ArrayIter iter(requests); iter; ++iter) {
+    CVarRef request = iter.secondRef();
+    Object task;
+    if (request.isArray()) {
+      Array params = request.toArray();
+      task = f_pagelet_server_task_start(params["url"].toString(),
+                                         params["headers"].toArray(),
+                                         params["post_data"].toString(),
+                                         params["files"].toArray());
+    } else {
+      task = f_pagelet_server_task_start(request.toString());
+    }
+    tasks.set(iter.first(), task);
+  }
+  return tasks;
+}
+
+Array f_pagelet_server_tasks_wait(CArrRef tasks, int64 timeout_ms /* = -1 */,
+                                  bool wait_all /* = false */) {
+  return PageletServer::TaskWait(tasks, timeout_ms, wait_all);
+}
+
 void f_pagelet_server_flush() {
   ExecutionContext *context = g_context.getNoCheck();
   Transport *transport = context->getTransport();
@@ -259,6 +259,12 @@ inline Variant x_mysql_fetch_array(CVarRef result, int result_type = 3) {
   return f_mysql_fetch_array(result, result_type);
 }
 
+inline Variant x_mysql_fetch_all_columns(CVarRef result) {
+  FUNCTION_INJECTION_BUILTIN(mysql_fetch_all_columns);
+  TAINT_OBSERVER(TAINT_BIT_ALL, TAINT_BIT_NONE);
+  return f_mysql_fetch_all_columns(result);
+}
+
 inline Variant x_mysql_fetch_lengths(CVarRef result) {
   FUNCTION_INJECTION_BUILTIN(mysql_fetch_lengths);
   return f_mysql_fetch_lengths(result);
@@ -55,6 +55,16 @@ inline String x_pagelet_server_task_result(CObjRef task, VRefParam headers, VRef
   return f_pagelet_server_task_result(task, headers, code);
 }
 
+inline Array x_pagelet_server_tasks_start(CArrRef requests) {
+  FUNCTION_INJECTION_BUILTIN(pagelet_server_tasks_start);
+  return f_pagelet_server_tasks_start(requests);
+}
+
+inline Array x_pagelet_server_tasks_wait(CArrRef tasks, int64 timeout_ms = -1, bool wait_all = false) {
+  FUNCTION_INJECTION_BUILTIN(pagelet_server_tasks_wait);
+  return f_pagelet_server_tasks_wait(tasks, timeout_ms, wait_all);
+}
+
 inline void x_pagelet_server_flush() {
   FUNCTION_INJECTION_BUILTIN(pagelet_server_flush);
   f_pagelet_server_flush();
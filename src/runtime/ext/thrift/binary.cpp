@@ -16,6 +16,7 @@
 */
 
 #include <runtime/ext/thrift/transport.h>
+#include <runtime/ext/thrift/struct_spec.h>
 #include <runtime/ext/ext_thrift.h>
 #include <runtime/base/base_includes.h>
 #include <util/logger.h>
@@ -38,7 +39,8 @@ const int8_t T_EXCEPTION = 3;
 const int INVALID_DATA = 1;
 const int BAD_VERSION = 4;
 
-void binary_deserialize_spec(CObjRef zthis, PHPInputTransport& transport, CArrRef spec);
+void binary_deserialize_spec(CObjRef zthis, PHPInputTransport& transport,
+                             ThriftStructSpec& spec);
 void binary_serialize_spec(CObjRef zthis, PHPOutputTransport& transport, CArrRef spec);
 void binary_serialize(int8_t thrift_typeID, PHPOutputTransport& transport, CVarRef value, CArrRef fieldspec);
 void skip_element(long thrift_typeID, PHPInputTransport& transport);
@@ -86,15 +88,15 @@ Variant binary_deserialize(int8_t thrift_typeID, PHPInputTransport& transport,
         skip_element(T_STRUCT, transport);
         return null;
       }
-      Variant spec = get_static_property(structType, "_TSPEC");
-      if (!spec.is(KindOfArray)) {
+      ThriftStructSpec *spec = ThriftStructSpec::Get(structType);
+      if (!spec) {
         char errbuf[128];
         snprintf(errbuf, 128, "spec for %s is wrong type: %d\n",
                  structType.data(), ret.getType());
         throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
         return null;
       }
-      binary_deserialize_spec(ret, transport, spec.toArray());
+      binary_deserialize_spec(ret, transport, *spec);
       return ret;
     } break;
     case T_BOOL: {
@@ -139,10 +141,7 @@ Variant binary_deserialize(int8_t thrift_typeID, PHPInputTransport& transport,
     case T_STRING: {
       uint32_t size = transport.readU32();
       if (size && (size + 1)) {
-        char* strbuf = (char*) malloc(size + 1);
-        transport.readBytes(strbuf, size);
-        strbuf[size] = '\0';
-        return String(strbuf, size, AttachString);
+        return transport.readString(size);
       } else {
         return "";
       }
@@ -290,27 +289,17 @@ inline bool ttypes_are_compatible(int8_t t1, int8_t t2) {
 }
 
 void binary_deserialize_spec(CObjRef zthis, PHPInputTransport& transport,
-                             CArrRef spec) {
+                             ThriftStructSpec& spec) {
   // SET and LIST have 'elem' => array('type', [optional] 'class')
   // MAP has 'val' => array('type', [optiona] 'class')
   while (true) {
-    Variant val;
-
     int8_t ttype = transport.readI8();
     if (ttype == T_STOP) return;
     int16_t fieldno = transport.readI16();
-    if (!(val = spec.rvalAt(fieldno)).isNull()) {
-      Array fieldspec = val.toArray();
-      // pull the field name
-      // zend hash tables use the null at the end in the length... so strlen(hash key) + 1.
-      String varname = fieldspec.rvalAt(s_var).toString();
-
-      // and the type
-      int8_t expected_ttype = fieldspec.rvalAt(s_type).toInt64();
-
-      if (ttypes_are_compatible(ttype, expected_ttype)) {
-        Variant rv = binary_deserialize(ttype, transport, fieldspec);
-        zthis->set(varname, rv);
+    if (ThriftFieldSpec *field = spec.getField(fieldno)) {
+      if (ttypes_are_compatible(ttype, field->type)) {
+        Variant rv = binary_deserialize(ttype, transport, field->spec);
+        spec.set(zthis, *field, rv);
       } else {
         skip_element(ttype, transport);
       }
@@ -501,14 +490,14 @@ Variant f_thrift_protocol_read_binary(CObjRef transportobj,
 
   if (messageType == T_EXCEPTION) {
     Object ex = createObject("TApplicationException");
-    Variant spec = get_static_property("TApplicationException", "_TSPEC");
-    binary_deserialize_spec(ex, transport, spec.toArray());
+    binary_deserialize_spec(
+      ex, transport, ThriftStructSpec::GetOrEmpty("TApplicationException"));
     throw ex;
   }
 
   Object ret_val = createObject(obj_typename);
-  Variant spec = get_static_property(obj_typename, "_TSPEC");
-  binary_deserialize_spec(ret_val, transport, spec.toArray());
+  binary_deserialize_spec(ret_val, transport,
+                          ThriftStructSpec::GetOrEmpty(obj_typename));
   return ret_val;
 }
 
@@ -16,6 +16,7 @@
 */
 
 #include <runtime/ext/thrift/transport.h>
+#include <runtime/ext/thrift/struct_spec.h>
 #include <runtime/ext/ext_thrift.h>
 
 #include <stack>
@@ -466,13 +467,11 @@ class CompactReader {
 
       if (type == T_REPLY) {
         Object ret = create_object(resultClassName, Array());
-        Variant spec = get_static_property(resultClassName, "_TSPEC");
-        readStruct(ret, spec);
+        readStruct(ret, ThriftStructSpec::GetOrEmpty(resultClassName));
         return ret;
       } else if (type == T_EXCEPTION) {
         Object exn = create_object("TApplicationException", Array());
-        Variant spec = get_static_property("TApplicationException", "_TSPEC");
-        readStruct(exn, spec);
+        readStruct(exn, ThriftStructSpec::GetOrEmpty("TApplicationException"));
         throw exn;
       } else {
         thrift_error("Invalid response type", ERR_INVALID_DATA);
@@ -487,7 +486,7 @@ class CompactReader {
     std::stack<std::pair<CState, uint16_t> > structHistory;
     std::stack<CState> containerHistory;
 
-    void readStruct(CObjRef dest, CArrRef spec) {
+    void readStruct(CObjRef dest, ThriftStructSpec &spec) {
       readStructBegin();
 
       while (true) {
@@ -501,17 +500,14 @@ class CompactReader {
 
         bool readComplete = false;
 
-        Variant fieldSpecVariant = spec.rvalAt(fieldNum);
-        if (!fieldSpecVariant.isNull()) {
-          Array fieldSpec = fieldSpecVariant.toArray();
-
-          String fieldName = fieldSpec.rvalAt(s_var).toString();
-          TType expectedType = (TType)fieldSpec.rvalAt(s_type).toInt64();
+        ThriftFieldSpec *field = spec.getField(fieldNum);
+        if (field) {
+          TType expectedType = (TType)field->type;
 
           if (typesAreCompatible(fieldType, expectedType)) {
             readComplete = true;
-            Variant fieldValue = readField(fieldSpec, fieldType);
-            dest->set(fieldName, fieldValue);
+            Variant fieldValue = readField(field->spec, fieldType);
+            spec.set(dest, *field, fieldValue);
           }
         }
 
@@ -590,14 +586,14 @@ class CompactReader {
               thrift_error("invalid class type in spec", ERR_INVALID_DATA);
             }
 
-            Variant newStructSpec =
-              get_static_property(classNameString, "_TSPEC");
+            ThriftStructSpec *newStructSpec =
+              ThriftStructSpec::Get(classNameString);
 
-            if (!newStructSpec.is(KindOfArray)) {
+            if (!newStructSpec) {
               thrift_error("invalid type of spec", ERR_INVALID_DATA);
             }
 
-            readStruct(newStruct, newStructSpec);
+            readStruct(newStruct, *newStructSpec);
             return newStruct;
           }
 
@@ -846,14 +842,7 @@ class CompactReader {
       uint32_t size = readVarint();
 
       if (size && (size + 1)) {
-        char* buf = (char*) malloc(size + 1);
-        if (!buf) {
-          thrift_error("unable to allocate string", ERR_UNKNOWN);
-        }
-
-        transport.readBytes(buf, size);
-        buf[size] = '\0';
-        return String(buf, size, AttachString);
+        return transport.readString(size);
       } else {
         transport.skip(size);
         return "";
@@ -0,0 +1,111 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   | Copyright (c) 1997-2010 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/ext/thrift/struct_spec.h>
+#include <runtime/ext/thrift/transport.h>
+#include <runtime/base/execution_context.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+typedef boost::shared_ptr<ThriftStructSpec> ThriftStructSpecPtr;
+
+class ThriftSpecCache : public RequestEventHandler {
+public:
+  virtual void requestInit() {
+    specs.clear();
+    empty.reset();
+  }
+
+  virtual void requestShutdown() {
+    specs.clear();
+    empty.reset();
+  }
+
+  StringMap<ThriftStructSpecPtr> specs;
+  ThriftStructSpecPtr empty;
+};
+IMPLEMENT_STATIC_REQUEST_LOCAL(ThriftSpecCache, s_thrift_spec_cache);
+
+ThriftStructSpec *ThriftStructSpec::Get(CStrRef className) {
+  StringMap<ThriftStructSpecPtr> &specs = s_thrift_spec_cache->specs;
+  StringMap<ThriftStructSpecPtr>::const_iterator it = specs.find(className);
+  if (it != specs.end()) {
+    return it->second.get();
+  }
+  Variant spec = get_static_property(className, "_TSPEC");
+  if (!spec.is(KindOfArray)) {
+    return NULL;
+  }
+  ThriftStructSpecPtr compiled(new ThriftStructSpec(spec.toArray()));
+  specs[className] = compiled;
+  return compiled.get();
+}
+
+ThriftStructSpec &ThriftStructSpec::GetOrEmpty(CStrRef className) {
+  if (ThriftStructSpec *spec = Get(className)) {
+    return *spec;
+  }
+  ThriftStructSpecPtr &empty = s_thrift_spec_cache->empty;
+  if (!empty) {
+    empty.reset(new ThriftStructSpec(Array::Create()));
+  }
+  return *empty;
+}
+
+ThriftStructSpec::ThriftStructSpec(CArrRef spec)
+    : m_resolved(false), m_cb(NULL) {
+  for (ArrayIter iter(spec); iter; ++iter) {
+    Variant key = iter.first();
+    CVarRef fieldSpec = iter.secondRef();
+    if (!key.isInteger() || fieldSpec.isNull()) continue;
+    int64 id = key.toInt64();
+    if (id != (int16_t)id) continue;
+
+    ThriftFieldSpec &field = m_fields[id];
+    field.spec = fieldSpec.toArray();
+    field.var = field.spec.rvalAt(s_var).toString();
+    field.type = field.spec.rvalAt(s_type).toInt64();
+  }
+}
+
+void ThriftStructSpec::setSlow(ObjectData *obj, ThriftFieldSpec &field,
+                               CVarRef value) {
+  if (!m_resolved) {
+    // Only compiled classes without a redeclared parent keep all declared
+    // properties inside the object, and __set() has to see every write.
+    m_resolved = true;
+    const ObjectStaticCallbacks *osc = obj->o_get_callbacks();
+    if (osc && !osc->redeclaredParent &&
+        !obj->getAttribute(ObjectData::UseSet)) {
+      m_cb = osc;
+    }
+  }
+  if (field.offset < 0 && m_cb && obj->o_get_callbacks() == m_cb) {
+    field.offset = 0;
+    if (!field.var.empty()) {
+      Variant *slot = obj->o_realPropPublic(field.var,
+                                            ObjectData::RealPropWrite |
+                                            ObjectData::RealPropNoDynamic);
+      if (slot) field.offset = (char*)slot - (char*)obj;
+    }
+  }
+  obj->o_set(field.var, value);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,90 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010- Facebook, Inc. (http://www.facebook.com)         |
+   | Copyright (c) 1997-2010 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __THRIFT_STRUCT_SPEC_H__
+#define __THRIFT_STRUCT_SPEC_H__
+
+#include <runtime/base/base_includes.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+struct ObjectStaticCallbacks;
+
+/**
+ * One entry of a struct's _TSPEC with the property name and type already
+ * pulled out. "offset" is where the declared property lives inside objects
+ * of the struct's class: -1 until the first write resolves it, 0 if the
+ * property has to be set by name.
+ */
+struct ThriftFieldSpec {
+  ThriftFieldSpec() : type(0), offset(-1) {}
+
+  String var;
+  int8_t type;
+  Array spec;
+  int offset;
+};
+
+/**
+ * A thrift struct class's _TSPEC compiled into a field id table. Compiled
+ * specs are kept for the rest of the request, so decoding a struct only
+ * costs one lookup per field, and fields of compiled classes are written
+ * straight into the object instead of going through o_set().
+ */
+class ThriftStructSpec {
+public:
+  /**
+   * Compiled spec of a struct class, or NULL if its _TSPEC is not an array.
+   */
+  static ThriftStructSpec *Get(CStrRef className);
+
+  /**
+   * Same as Get(), except that a missing _TSPEC gives a spec with no fields.
+   */
+  static ThriftStructSpec &GetOrEmpty(CStrRef className);
+
+  ThriftStructSpec(CArrRef spec);
+
+  ThriftFieldSpec *getField(int16_t fieldId) {
+    FieldMap::iterator it = m_fields.find(fieldId);
+    return it == m_fields.end() ? NULL : &it->second;
+  }
+
+  void set(CObjRef obj, ThriftFieldSpec &field, CVarRef value) {
+    ObjectData *o = obj.get();
+    if (field.offset > 0 && o->o_get_callbacks() == m_cb) {
+      *(Variant*)((char*)o + field.offset) = value;
+      return;
+    }
+    setSlow(o, field, value);
+  }
+
+private:
+  typedef hphp_hash_map<int16_t, ThriftFieldSpec> FieldMap;
+
+  FieldMap m_fields;
+  bool m_resolved;
+  const ObjectStaticCallbacks *m_cb;
+
+  void setSlow(ObjectData *obj, ThriftFieldSpec &field, CVarRef value);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __THRIFT_STRUCT_SPEC_H__
@@ -284,14 +284,56 @@ public:
     return (int32_t)ntohl(c);
   }
 
+  /**
+   * Strings are handed out without copying when they are exactly what the
+   * transport's read() returned: a whole unconsumed chunk, or, if nothing is
+   * buffered, a read() of just the string's length that comes back complete.
+   * Strings in the middle of a chunk are copied out of it once.
+   */
+  String readString(size_t len) {
+    if (len <= buffer_used) {
+      if (len == buffer_used && buffer_ptr == chunk.data()) {
+        String ret = chunk;
+        chunk.reset();
+        buffer_used = 0;
+        return ret;
+      }
+      String ret(buffer_ptr, len, CopyString);
+      buffer_ptr += len;
+      buffer_used -= len;
+      return ret;
+    }
+    if (buffer_used == 0) {
+      chunk = t->o_invoke(s_read, CREATE_VECTOR1((int64)len), -1).toString();
+      if ((size_t)chunk.size() == len) {
+        String ret = chunk;
+        chunk.reset();
+        return ret;
+      }
+      // short read, keep what came back and fill in the rest below
+      buffer_used = chunk.size();
+      buffer_ptr = const_cast<char*>(chunk.data());
+    }
+    char* buf = reinterpret_cast<char*>(malloc(len + 1));
+    if (!buf) {
+      throw FatalErrorException("unable to allocate thrift string");
+    }
+    readBytes(buf, len);
+    buf[len] = '\0';
+    return String(buf, len, AttachString);
+  }
+
 protected:
+  // Reads are served straight out of the last string returned by the
+  // transport instead of copying it into our own buffer first.
+  String chunk;
+
   void refill() {
     ASSERT(buffer_used == 0);
-    String ret = t->o_invoke(s_read,
-                             CREATE_VECTOR1((int64)buffer_size), -1).toString();
-    buffer_used = ret.size();
-    memcpy(buffer, ret.data(), buffer_used);
-    buffer_ptr = buffer;
+    chunk = t->o_invoke(s_read,
+                        CREATE_VECTOR1((int64)buffer_size), -1).toString();
+    buffer_used = chunk.size();
+    buffer_ptr = const_cast<char*>(chunk.data());
   }
 
 };
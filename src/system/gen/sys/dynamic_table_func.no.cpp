@@ -2122,6 +2122,26 @@ Variant ifa_pagelet_server_task_start(void *extra, int count, INVOKE_FEW_ARGS_IM
 Variant i_pagelet_server_task_start(void *extra, CArrRef params) {
   return invoke_func_few_handler(extra, params, &ifa_pagelet_server_task_start);
 }
+Variant ifa_pagelet_server_tasks_start(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARGS) {
+  if (UNLIKELY(count != 1)) return throw_wrong_arguments("pagelet_server_tasks_start", count, 1, 1, 1);
+  CVarRef arg0(a0);
+  return (x_pagelet_server_tasks_start(arg0));
+}
+Variant i_pagelet_server_tasks_start(void *extra, CArrRef params) {
+  return invoke_func_few_handler(extra, params, &ifa_pagelet_server_tasks_start);
+}
+Variant ifa_pagelet_server_tasks_wait(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARGS) {
+  if (UNLIKELY(count < 1 || count > 3)) return throw_wrong_arguments("pagelet_server_tasks_wait", count, 1, 3, 1);
+  CVarRef arg0(a0);
+  if (count <= 1) return (x_pagelet_server_tasks_wait(arg0));
+  CVarRef arg1(a1);
+  if (count <= 2) return (x_pagelet_server_tasks_wait(arg0, arg1));
+  CVarRef arg2(a2);
+  return (x_pagelet_server_tasks_wait(arg0, arg1, arg2));
+}
+Variant i_pagelet_server_tasks_wait(void *extra, CArrRef params) {
+  return invoke_func_few_handler(extra, params, &ifa_pagelet_server_tasks_wait);
+}
 Variant ifa_get_included_files(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARGS) {
   if (UNLIKELY(count > 0)) return throw_toomany_arguments("get_included_files", 0, 1);
   return (x_get_included_files());
@@ -17973,6 +17993,14 @@ Variant ifa_mysql_fetch_lengths(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARG
 Variant i_mysql_fetch_lengths(void *extra, CArrRef params) {
   return invoke_func_few_handler(extra, params, &ifa_mysql_fetch_lengths);
 }
+Variant ifa_mysql_fetch_all_columns(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARGS) {
+  if (UNLIKELY(count != 1)) return throw_wrong_arguments("mysql_fetch_all_columns", count, 1, 1, 1);
+  CVarRef arg0(a0);
+  return (x_mysql_fetch_all_columns(arg0));
+}
+Variant i_mysql_fetch_all_columns(void *extra, CArrRef params) {
+  return invoke_func_few_handler(extra, params, &ifa_mysql_fetch_all_columns);
+}
 Variant ifa_magickadaptivethresholdimage(void *extra, int count, INVOKE_FEW_ARGS_IMPL_ARGS) {
   if (UNLIKELY(count != 4)) return throw_wrong_arguments("magickadaptivethresholdimage", count, 4, 4, 1);
   CVarRef arg0(a0);
@@ -21588,6 +21616,8 @@ CallInfo ci_mysql_get_host_info((void*)&i_mysql_get_host_info, (void*)&ifa_mysql
 CallInfo ci_array_diff((void*)&i_array_diff, (void*)&ifa_array_diff, 2, 1, 0x0000000000000000LL);
 CallInfo ci_magickgetimageblob((void*)&i_magickgetimageblob, (void*)&ifa_magickgetimageblob, 1, 0, 0x0000000000000000LL);
 CallInfo ci_pagelet_server_task_start((void*)&i_pagelet_server_task_start, (void*)&ifa_pagelet_server_task_start, 4, 0, 0x0000000000000000LL);
+CallInfo ci_pagelet_server_tasks_start((void*)&i_pagelet_server_tasks_start, (void*)&ifa_pagelet_server_tasks_start, 1, 0, 0x0000000000000000LL);
+CallInfo ci_pagelet_server_tasks_wait((void*)&i_pagelet_server_tasks_wait, (void*)&ifa_pagelet_server_tasks_wait, 3, 0, 0x0000000000000000LL);
 CallInfo ci_get_included_files((void*)&i_get_included_files, (void*)&ifa_get_included_files, 0, 0, 0x0000000000000000LL);
 CallInfo ci_apache_request_headers((void*)&i_apache_request_headers, (void*)&ifa_apache_request_headers, 0, 0, 0x0000000000000000LL);
 CallInfo ci_imagegrabwindow((void*)&i_imagegrabwindow, (void*)&ifa_imagegrabwindow, 2, 0, 0x0000000000000000LL);
@@ -23168,6 +23198,7 @@ CallInfo ci_pcntl_signal_dispatch((void*)&i_pcntl_signal_dispatch, (void*)&ifa_p
 CallInfo ci_php_check_syntax((void*)&i_php_check_syntax, (void*)&ifa_php_check_syntax, 2, 0, 0x0000000000000002LL);
 CallInfo ci_hphp_get_function_info((void*)&i_hphp_get_function_info, (void*)&ifa_hphp_get_function_info, 1, 0, 0x0000000000000000LL);
 CallInfo ci_mysql_fetch_lengths((void*)&i_mysql_fetch_lengths, (void*)&ifa_mysql_fetch_lengths, 1, 0, 0x0000000000000000LL);
+CallInfo ci_mysql_fetch_all_columns((void*)&i_mysql_fetch_all_columns, (void*)&ifa_mysql_fetch_all_columns, 1, 0, 0x0000000000000000LL);
 CallInfo ci_magickadaptivethresholdimage((void*)&i_magickadaptivethresholdimage, (void*)&ifa_magickadaptivethresholdimage, 4, 0, 0x0000000000000000LL);
 CallInfo ci_thrift_protocol_write_binary((void*)&i_thrift_protocol_write_binary, (void*)&ifa_thrift_protocol_write_binary, 6, 0, 0x0000000000000000LL);
 CallInfo ci_hphp_splfileobject___construct((void*)&i_hphp_splfileobject___construct, (void*)&ifa_hphp_splfileobject___construct, 5, 0, 0x0000000000000000LL);
@@ -26812,6 +26843,12 @@ bool get_call_info_builtin(const CallInfo *&ci, void *&extra, const char *s, int
         return true;
       }
       break;
+    case 2251:
+      HASH_GUARD(0x415927373498E8CBLL, pagelet_server_tasks_wait) {
+        ci = &ci_pagelet_server_tasks_wait;
+        return true;
+      }
+      break;
     case 2254:
       HASH_GUARD(0x3FFAA982E4B1E8CELL, date_offset_get) {
         ci = &ci_date_offset_get;
@@ -27920,6 +27957,12 @@ bool get_call_info_builtin(const CallInfo *&ci, void *&extra, const char *s, int
         return true;
       }
       break;
+    case 2951:
+      HASH_GUARD(0x6C785260849EAB87LL, pagelet_server_tasks_start) {
+        ci = &ci_pagelet_server_tasks_start;
+        return true;
+      }
+      break;
     case 2967:
       HASH_GUARD(0x09837A82A928AB97LL, is_null) {
         ci = &ci_is_null;
@@ -32209,6 +32252,10 @@ bool get_call_info_builtin(const CallInfo *&ci, void *&extra, const char *s, int
         ci = &ci_dom_document_create_comment;
         return true;
       }
+      HASH_GUARD(0x64FBBD423757F600LL, mysql_fetch_all_columns) {
+        ci = &ci_mysql_fetch_all_columns;
+        return true;
+      }
       break;
     case 5653:
       HASH_GUARD(0x6AD774816F8F7615LL, mb_strrchr) {
@@ -35,6 +35,7 @@ static const char *php_path = "/usr/local/php/bin/php";
 
 // By default, use shared linking for faster testing.
 bool TestCodeRun::FastMode = true;
+const char *TestCodeRun::EvalOption = NULL;
 
 TestCodeRun::TestCodeRun() : m_perfMode(false) {
   Option::GenerateCPPMain = true;
@@ -256,6 +257,7 @@ static bool verify_result(const char *input, const char *output, bool perfMode,
                             "--config=test/config.hdf",
                             "-v Fiber.ThreadCount=5",
                             "-v Eval.EnableObjDestructCall=true",
+                            TestCodeRun::EvalOption,
                             NULL};
       Process::Exec(HPHPI_PATH, argv, NULL, actual, &err);
     }
@@ -530,6 +532,8 @@ bool TestCodeRun::RunTests(const std::string &which) {
   // HipHop features
   RUN_TEST(TestYield);
   RUN_TEST(TestHint);
+  RUN_TEST(TestByteCodeInterpreter);
+  RUN_TEST(TestEvalClassTemplates);
 #ifdef TAINTED
   RUN_TEST(TestTaint);
   RUN_TEST(TestTaintExt);
@@ -5635,6 +5639,22 @@ bool TestCodeRun::TestObjectMethod() {
       "unlink($ourFileName);\n"
       "\n"
       "echo \"done\\n\";");
+
+  // one call site seeing several receiver classes, and a private method
+  // that shadows a public one when called from inside its own class
+  MVCR("<?php "
+      "class A { private function p() { return 'A::p'; } "
+      "  public function q() { return 'A::q'; } "
+      "  function run($o) { return $o->p(); } }"
+      "class B extends A { public function p() { return 'B::p'; } "
+      "  public function q() { return 'B::q'; } }"
+      "class C { public function q() { return 'C::q'; } }"
+      "$objs = array(new A, new B, new C, new B, new A);"
+      "for ($i = 0; $i < 2; $i++) {"
+      "  foreach ($objs as $o) echo $o->q(), ' ';"
+      "  echo $objs[1]->run($objs[1]), ' ', $objs[0]->run($objs[4]), ' ';"
+      "  echo $objs[0]->run($objs[0]), \"\\n\";"
+      "}");
  return true;
 }
 
@@ -7853,6 +7873,28 @@ bool TestCodeRun::TestDynamicVariables() {
        "NULL\n"
        "int(1)\n");
 
+  // catch, static and closure variables live in the same slots as plain
+  // locals, whether or not the function also reaches them by name
+  MVCR("<?php "
+      "function f($n) {"
+      "  static $calls = 0;"
+      "  $calls++;"
+      "  try { throw new Exception('e' . $n); }"
+      "  catch (Exception $e) { $msg = $e->getMessage(); }"
+      "  $add = function ($x) use ($n, &$calls) { $calls += 10; return $x + $n; };"
+      "  return array($calls, $msg, $add(1), $calls);"
+      "}"
+      "function g($n) {"
+      "  static $calls = 0;"
+      "  $calls++;"
+      "  try { throw new Exception('e' . $n); }"
+      "  catch (Exception $e) { $msg = $e->getMessage(); }"
+      "  extract(array('n' => $n * 2));"
+      "  $add = function ($x) use ($n) { return $x + $n; };"
+      "  return compact('calls', 'msg', 'n') + array('add' => $add(1));"
+      "}"
+      "var_dump(f(1), f(2), g(1), g(2));");
+
   return true;
 }
 
@@ -7953,6 +7995,17 @@ bool TestCodeRun::TestDynamicFunctions() {
       "}"
       "bar($argc > 100);");
 
+  // Single argument builtins called straight from the call site
+  MVCR("<?php "
+      "function f($v) {"
+      "  var_dump(Is_String($v), is_int($v), is_numeric($v), is_null($v));"
+      "  var_dump(is_array($v), is_object($v), gettype($v));"
+      "  if (is_string($v)) var_dump(strlen($v), ord($v));"
+      "  var_dump(count($v), sizeof($v), intval($v), floatval($v));"
+      "  var_dump(count($v, COUNT_RECURSIVE), intval($v, 16));"
+      "}"
+      "f('12'); f(7); f(null); f(array(1, array(2, 3))); f(1.5);");
+
   return true;
 }
 
@@ -10459,6 +10512,50 @@ bool TestCodeRun::TestIfStatement() {
        "}"
        "test(3);");
 
+  MVCR("<?php "
+       "function f($x) {"
+       "  if (false) {"
+       "    echo \"dead\\n\";"
+       "  } elseif ($x) {"
+       "    echo \"x\\n\";"
+       "  } elseif (true) {"
+       "    echo \"true\\n\";"
+       "  } else {"
+       "    echo \"never\\n\";"
+       "  }"
+       "  echo true ? \"yes\\n\" : \"no\\n\";"
+       "  echo 0 ?: \"elvis\\n\";"
+       "  var_dump(false && f(1), true || f(1));"
+       "  var_dump(strlen('hello'), str_repeat('ab', 3), abs(-3));"
+       "  $n = 'world';"
+       "  echo \"hello $n!\\n\", \"$n and $x\\n\";"
+       "  echo 'a' . ('b' . $n) . \"c\\n\";"
+       "  do {"
+       "    echo \"once\\n\";"
+       "    if ($x) break;"
+       "    echo \"after\\n\";"
+       "  } while (0);"
+       "  $i = 0;"
+       "  while (true) { if (++$i > 3) break; }"
+       "  for (; 1; ) { if (--$i == 0) break; }"
+       "  var_dump($i);"
+       "}"
+       "f(0);"
+       "f(1);");
+
+  MVCR("<?php "
+       "function g() {"
+       "  goto inside;"
+       "  if (false) {"
+       "    inside: echo \"inside\\n\";"
+       "  }"
+       "  while (false) {"
+       "    echo \"never\\n\";"
+       "  }"
+       "  echo \"done\\n\";"
+       "}"
+       "g();");
+
   return true;
 }
 
@@ -10561,6 +10658,25 @@ bool TestCodeRun::TestReturnStatement() {
       "var_dump(g());"
       "var_dump(f());"
       );
+
+  // deep enough to run out of hphpi's per thread slot stack, so frames get
+  // their slots from the heap, and come back through all of them twice
+  string locals, sum;
+  for (int i = 0; i < 40; i++) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "  $v%d = $n + %d;\n", i, i);
+    locals += buf;
+    snprintf(buf, sizeof(buf), " + $v%d", i);
+    sum += buf;
+  }
+  string deep = "<?php\n"
+    "function deep($n) {\n" + locals +
+    "  $r = $n > 0 ? deep($n - 1) : 0;\n"
+    "  return $r" + sum + ";\n"
+    "}\n"
+    "var_dump(deep(800));\n"
+    "var_dump(deep(800));\n";
+  MVCR(deep.c_str());
   return true;
 }
 
@@ -14041,6 +14157,100 @@ bool TestCodeRun::TestThrift() {
       "  int(1234)\n"
       "}\n");
 
+  // strings and nested structs round trip through both protocols whether
+  // the transport hands back whole messages or short reads
+  MVCRO(
+      "<?php "
+      "class TType {"
+      "  const STOP   = 0;"
+      "  const I32    = 8;"
+      "  const STRING = 11;"
+      "  const STRUCT = 12;"
+      "  const LST    = 15;"
+      "}"
+      "class DummyProtocol {"
+      "  public $t;"
+      "  function __construct($chunk) {"
+      "    $this->t = new DummyTransport($chunk);"
+      "  }"
+      "  function getTransport() {"
+      "    return $this->t;"
+      "  }"
+      "}"
+      "class DummyTransport {"
+      "  public $buff = '';"
+      "  public $pos = 0;"
+      "  public $chunk;"
+      "  function __construct($chunk) { $this->chunk = $chunk; }"
+      "  function flush() { }"
+      "  function write($buff) {"
+      "    $this->buff .= $buff;"
+      "  }"
+      "  function read($n) {"
+      "    if ($this->chunk) $n = min($n, $this->chunk);"
+      "    $r = substr($this->buff, $this->pos, $n);"
+      "    $this->pos += $n;"
+      "    return $r;"
+      "  }"
+      "}"
+      "class Inner {"
+      "  static $_TSPEC;"
+      "  public $name = null;"
+      "  public function __construct($vals=null) {"
+      "    if (!isset(self::$_TSPEC)) {"
+      "      self::$_TSPEC = array("
+      "        1 => array('var' => 'name', 'type' => TType::STRING));"
+      "    }"
+      "  }"
+      "}"
+      "class Outer {"
+      "  static $_TSPEC;"
+      "  public $id = null;"
+      "  public $strs = null;"
+      "  public $inner = null;"
+      "  public function __construct($vals=null) {"
+      "    if (!isset(self::$_TSPEC)) {"
+      "      self::$_TSPEC = array("
+      "        1 => array('var' => 'id', 'type' => TType::I32),"
+      "        2 => array('var' => 'strs', 'type' => TType::LST,"
+      "                   'etype' => TType::STRING,"
+      "                   'elem' => array('type' => TType::STRING)),"
+      "        3 => array('var' => 'inner', 'type' => TType::STRUCT,"
+      "                   'class' => 'Inner'));"
+      "    }"
+      "  }"
+      "}"
+      "function test($compact, $chunk) {"
+      "  $p = new DummyProtocol($chunk);"
+      "  $v = new Outer();"
+      "  $v->id = 7;"
+      "  $v->strs = array('', 'abcde', str_repeat('x', 16),"
+      "                   str_repeat('y', 40), str_repeat('z', 10000));"
+      "  $v->inner = new Inner();"
+      "  $v->inner->name = 'nested';"
+      "  if ($compact) {"
+      "    thrift_protocol_write_compact($p, 'foomethod', 1, $v, 20);"
+      "    $p->getTransport()->buff[1] = pack('C', 0x42);"
+      "    $r = thrift_protocol_read_compact($p, 'Outer');"
+      "  } else {"
+      "    thrift_protocol_write_binary($p, 'foomethod', 1, $v, 20, true);"
+      "    $r = thrift_protocol_read_binary($p, 'Outer', true);"
+      "  }"
+      "  var_dump($r == $v);"
+      "  echo implode(' ', array_map('strlen', $r->strs)), \"\\n\";"
+      "}"
+      "foreach (array(0, 16, 3) as $chunk) {"
+      "  test(false, $chunk);"
+      "  test(true, $chunk);"
+      "}",
+
+      "bool(true)\n0 5 16 40 10000\n"
+      "bool(true)\n0 5 16 40 10000\n"
+      "bool(true)\n0 5 16 40 10000\n"
+      "bool(true)\n0 5 16 40 10000\n"
+      "bool(true)\n0 5 16 40 10000\n"
+      "bool(true)\n0 5 16 40 10000\n");
+
   return true;
 }
 
@@ -27515,6 +27725,221 @@ bool TestCodeRun::TestTraits() {
   return true;
 }
 
+bool TestCodeRun::TestByteCodeInterpreter() {
+  if (Option::EnableEval < Option::FullEval) return true;
+
+  // Eval.BytecodeInterpreter only compiles function bodies, which is where
+  // all of TestByteCodeControlFlow() runs. The other suites are mostly top
+  // level code, but have their functions run as byte code too.
+  EvalOption = "-v Eval.BytecodeInterpreter=true";
+  bool ret = TestByteCodeControlFlow() &&
+    TestIfStatement() &&
+    TestBreakStatement() &&
+    TestContinueStatement() &&
+    TestReturnStatement() &&
+    TestLogicalOperators() &&
+    TestTernary() &&
+    TestSwitchStatement() &&
+    TestExceptions();
+  EvalOption = NULL;
+  return ret;
+}
+
+bool TestCodeRun::TestByteCodeControlFlow() {
+  // loops
+  MVCR("<?php\n"
+       "function loops($n) {\n"
+       "  $s = 0;\n"
+       "  for ($i = 0; $i < $n; $i++) { $s = $s + $i; }\n"
+       "  $j = $n;\n"
+       "  while ($j > 0) { $s = $s * 2; $j = $j - 3; }\n"
+       "  do { $s = $s - 1; $j = $j + 1; } while ($j < 2);\n"
+       "  for ($i = 0, $k = $n; $i < $k; $i++, $k--) { echo $i, $k, ' '; }\n"
+       "  foreach (array(1, 2) as $v) {\n"
+       "    for ($i = 0; $i < 2; $i++) { echo $v, $i, ' '; }\n"
+       "  }\n"
+       "  return $s;\n"
+       "}\n"
+       "var_dump(loops(0), loops(1), loops(7));\n");
+
+  // break and continue with levels, also out of statements that aren't
+  // compiled, like foreach and switch
+  MVCR("<?php\n"
+       "function levels() {\n"
+       "  for ($i = 0; $i < 3; $i++) {\n"
+       "    echo \"i$i \";\n"
+       "    for ($j = 0; ; $j++) {\n"
+       "      if ($j == 1) continue;\n"
+       "      if ($j == 3) continue 2;\n"
+       "      echo \"j$j \";\n"
+       "    }\n"
+       "  }\n"
+       "  $i = 0;\n"
+       "  while (true) {\n"
+       "    $i++;\n"
+       "    foreach (array(1, 2, 3) as $v) {\n"
+       "      if ($v == 2 && $i == 1) continue 2;\n"
+       "      if ($v == 3 && $i == 3) break 2;\n"
+       "      echo \"$i:$v \";\n"
+       "    }\n"
+       "  }\n"
+       "  for ($i = 0; $i < 10; $i++) {\n"
+       "    switch ($i) {\n"
+       "      case 1: continue 2;\n"
+       "      case 4: break 2;\n"
+       "      default: break;\n"
+       "    }\n"
+       "    echo \"s$i \";\n"
+       "  }\n"
+       "  do {\n"
+       "    while (true) { break 2; }\n"
+       "    echo 'not here';\n"
+       "  } while (false);\n"
+       "  echo \"done\\n\";\n"
+       "}\n"
+       "levels(); levels();\n");
+
+  // return from nested loops, from a loop the call is in, and by recursion
+  MVCR("<?php\n"
+       "function find($a, $x) {\n"
+       "  for ($i = 0; $i < count($a); $i++) {\n"
+       "    $j = 0;\n"
+       "    while ($j < count($a[$i])) {\n"
+       "      foreach ($a[$i] as $k => $v) {\n"
+       "        if ($v === $x) return array($i, $k);\n"
+       "      }\n"
+       "      $j++;\n"
+       "    }\n"
+       "  }\n"
+       "  return null;\n"
+       "}\n"
+       "function fib($n) { if ($n < 2) return $n;"
+       " return fib($n - 1) + fib($n - 2); }\n"
+       "function noreturn($n) { while ($n > 0) { $n = $n - 1; } }\n"
+       "$a = array(array(1, 2), array(3, 4, 5));\n"
+       "for ($n = 0; $n < 7; $n++) { var_dump(find($a, $n)); }\n"
+       "var_dump(fib(15), noreturn(3));\n");
+
+  // &&, ||, ?: and ! only evaluate what they have to
+  MVCR("<?php\n"
+       "function t($x) { echo \"t($x) \"; return $x; }\n"
+       "function logic($a, $b) {\n"
+       "  $r = t($a) && t($b); var_dump($r);\n"
+       "  $r = t($a) || t($b); var_dump($r);\n"
+       "  $r = !t($a) && (t($b) || t(0)); var_dump($r);\n"
+       "  $r = t($a) ? t($b) : t('c'); var_dump($r);\n"
+       "  $r = t($a) && t($b) ? 'yes' : 'no'; var_dump($r);\n"
+       "  $r = $a and $b; var_dump($r);\n"
+       "  $r = ($a xor $b); var_dump($r);\n"
+       "  if ($a || t('side')) echo \"if\\n\"; else echo \"else\\n\";\n"
+       "  while ($a && $b) { $b = 0; echo \"loop \"; }\n"
+       "  return $a ?: $b;\n"
+       "}\n"
+       "foreach (array(array(0, 0), array(0, 1), array(1, 0), array(1, 2),"
+       " array('', 'x'), array(null, '0')) as $p) {\n"
+       "  var_dump(logic($p[0], $p[1]));\n"
+       "}\n");
+
+  // switch with fallthrough, default in the middle and no match
+  MVCR("<?php\n"
+       "function sw($x) {\n"
+       "  $out = '';\n"
+       "  switch ($x) {\n"
+       "    case 1: $out .= 'one ';\n"
+       "    case 2: $out .= 'two '; break;\n"
+       "    default: $out .= 'default ';\n"
+       "    case 'three': $out .= 'three ';\n"
+       "    case 4: $out .= 'four '; return $out;\n"
+       "    case 5: $out .= 'five ';\n"
+       "  }\n"
+       "  return $out . 'end';\n"
+       "}\n"
+       "foreach (array(1, 2, 3, 'three', 4, 5, null, '1') as $x) {\n"
+       "  var_dump(sw($x));\n"
+       "}\n");
+
+  // exceptions thrown out of loops and through compiled frames
+  MVCR("<?php\n"
+       "function thrower($i) {\n"
+       "  for ($j = 0; $j < 5; $j++) {\n"
+       "    if ($j == $i) throw new Exception(\"at $j\");\n"
+       "  }\n"
+       "  return 'none';\n"
+       "}\n"
+       "function catcher() {\n"
+       "  $caught = 0;\n"
+       "  for ($i = 0; $i < 7; $i++) {\n"
+       "    try {\n"
+       "      if ($i == 5) continue;\n"
+       "      echo thrower($i), \"\\n\";\n"
+       "      if ($i == 6) break;\n"
+       "    } catch (Exception $e) {\n"
+       "      $caught++;\n"
+       "      echo $e->getMessage(), \"\\n\";\n"
+       "    }\n"
+       "  }\n"
+       "  return $caught;\n"
+       "}\n"
+       "function rethrow() {\n"
+       "  while (true) {\n"
+       "    try { thrower(2); }\n"
+       "    catch (Exception $e) { throw new Exception('again'); }\n"
+       "  }\n"
+       "}\n"
+       "var_dump(catcher());\n"
+       "try { rethrow(); }\n"
+       "catch (Exception $e) { var_dump($e->getMessage()); }\n");
+
+  return true;
+}
+
+bool TestCodeRun::TestEvalClassTemplates() {
+  if (Option::EnableEval < Option::FullEval) return true;
+
+  // Each program runs as two requests in one process, so the second one
+  // may find the class checked by the first. A class whose checks failed
+  // must still fail them every time.
+  EvalOption = "--count=2";
+  bool ret = true;
+  const char *programs[] = {
+    "<?php\n"
+    "class A { public function f() {} }\n"
+    "echo \"before\\n\";\n"
+    "if (true) { class B extends A { public static function f() {} } }\n"
+    "$b = new B;\n"
+    "echo \"after\\n\";\n",
+
+    "<?php\n"
+    "class A { public function f() {} }\n"
+    "class B extends A {}\n"
+    "echo \"before\\n\";\n"
+    "if (true) { class C extends B { protected function f() {} } }\n"
+    "$c = new C;\n"
+    "echo \"after\\n\";\n",
+
+    // and a good class stays good
+    "<?php\n"
+    "class A { public function f() { return 'A'; } }\n"
+    "echo \"before\\n\";\n"
+    "if (true) {\n"
+    "  class B extends A { public function f() { return 'B'; } }\n"
+    "}\n"
+    "$b = new B;\n"
+    "echo $b->f(), \"\\n\";\n",
+  };
+  const char *outputs[] = {
+    "before\nbefore\n",
+    "before\nbefore\n",
+    "before\nB\nbefore\nB\n",
+  };
+  for (unsigned int i = 0; ret && i < sizeof(programs) / sizeof(programs[0]);
+       i++) {
+    ret = RecordMulti(programs[i], outputs[i], __FILE__, __LINE__, false);
+  }
+  EvalOption = NULL;
+  return ret;
+}
+
 // please leave this unit test at last for debugging ad hoc code
 bool TestCodeRun::TestAdHoc() {
   return true;
@@ -198,6 +198,9 @@ class TestCodeRun : public TestBase {
   // HipHop specific
   bool TestYield();
   bool TestHint();
+  bool TestByteCodeInterpreter();
+  bool TestByteCodeControlFlow();
+  bool TestEvalClassTemplates();
 #ifdef TAINTED
   bool TestTaint();
   bool TestTaintExt();
@@ -207,6 +210,8 @@ class TestCodeRun : public TestBase {
   bool TestAdHoc();
 
   static bool FastMode;
+  // extra "-v" option for hphpi runs, e.g. to switch eval engines
+  static const char *EvalOption;
 
  protected:
   bool CleanUp();
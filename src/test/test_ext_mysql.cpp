@@ -64,6 +64,7 @@ bool TestExtMysql::RunTests(const std::string &which) {
   RUN_TEST(test_mysql_fetch_row);
   RUN_TEST(test_mysql_fetch_assoc);
   RUN_TEST(test_mysql_fetch_array);
+  RUN_TEST(test_mysql_fetch_all_columns);
   RUN_TEST(test_mysql_fetch_lengths);
   RUN_TEST(test_mysql_fetch_object);
   RUN_TEST(test_mysql_result);
@@ -460,6 +461,32 @@ bool TestExtMysql::test_mysql_fetch_array() {
   return Count(true);
 }
 
+bool TestExtMysql::test_mysql_fetch_all_columns() {
+  Variant conn = f_mysql_connect(TEST_HOSTNAME, TEST_USERNAME, TEST_PASSWORD);
+  VERIFY(CreateTestTable());
+  VS(f_mysql_query("insert into test (name) values ('test'),('test2')"), true);
+
+  Variant res = f_mysql_query("select * from test");
+  Variant row = f_mysql_fetch_assoc(res);
+  Variant columns = f_mysql_fetch_all_columns(res);
+  VS(f_print_r(columns, true),
+     "Array\n"
+     "(\n"
+     "    [id] => Array\n"
+     "        (\n"
+     "            [0] => 2\n"
+     "        )\n"
+     "\n"
+     "    [name] => Array\n"
+     "        (\n"
+     "            [0] => test2\n"
+     "        )\n"
+     "\n"
+     ")\n");
+  VS(f_mysql_fetch_assoc(res), false);
+  return Count(true);
+}
+
 bool TestExtMysql::test_mysql_fetch_lengths() {
   Variant conn = f_mysql_connect(TEST_HOSTNAME, TEST_USERNAME, TEST_PASSWORD);
   VERIFY(CreateTestTable());
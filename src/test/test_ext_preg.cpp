@@ -228,6 +228,17 @@ bool TestExtPreg::test_preg_replace() {
                    ref(count));
     VS(count, 3);
   }
+  {
+    // one compiled pattern and replacement template shared by all subjects
+    Variant count = 0;
+    Array subjects = CREATE_MAP3("a", "April 15, 2003", "b", "no match",
+                                 "c", "May 1, 1999 and June 2, 2000");
+    VS(f_preg_replace("/(\\w+) (\\d+), (\\d+)/", "\\\\${1}1,$3\\$4",
+                      subjects, -1, ref(count)),
+       CREATE_MAP3("a", "\\April1,2003$4", "b", "no match",
+                   "c", "\\May1,1999$4 and \\June1,2000$4"));
+    VS(count, 3);
+  }
   {
     String html_body = "<html><body></body></html>";
     String html_body2 = f_preg_replace("/(<\\/?\\w+[^>]*>)/e",
@@ -273,6 +284,15 @@ bool TestExtPreg::test_preg_replace_callback() {
                                    text);
     VS(text, "April fools day is 04/01/2003\nLast christmas was 12/24/2002\n");
   }
+  {
+    // subpattern array is reused across matches and subjects
+    Array text = CREATE_VECTOR2("Born 01/02/1970, wed 03/04/1999",
+                                "Retired 05/06/2030");
+    VS(f_preg_replace_callback("|(\\d{2}/\\d{2}/)(\\d{4})|", "next_year",
+                               text),
+       CREATE_VECTOR2("Born 01/02/1971, wed 03/04/2000",
+                      "Retired 05/06/2031"));
+  }
   return Count(true);
 }
 
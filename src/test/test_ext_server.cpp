@@ -36,6 +36,8 @@ bool TestExtServer::RunTests(const std::string &which) {
   RUN_TEST(test_pagelet_server_task_start);
   RUN_TEST(test_pagelet_server_task_status);
   RUN_TEST(test_pagelet_server_task_result);
+  RUN_TEST(test_pagelet_server_tasks_start);
+  RUN_TEST(test_pagelet_server_tasks_wait);
   RUN_TEST(test_xbox_send_message);
   RUN_TEST(test_xbox_post_message);
   RUN_TEST(test_xbox_task_start);
@@ -107,6 +109,75 @@ bool TestExtServer::test_pagelet_server_task_result() {
   return Count(true);
 }
 
+bool TestExtServer::test_pagelet_server_tasks_start() {
+  // tested in test_pagelet_server_tasks_wait()
+  return Count(true);
+}
+
+bool TestExtServer::test_pagelet_server_tasks_wait() {
+  const int TEST_SIZE = 20;
+
+  Array requests;
+  for (int i = 0; i < TEST_SIZE; ++i) {
+    String url = String("pageletserver?getparam=") + String(i);
+    if (i % 2) {
+      requests.set(String("t") + String(i), url);
+    } else {
+      requests.set(String("t") + String(i),
+                   CREATE_MAP2("url", url,
+                               "headers",
+                               CREATE_VECTOR1(String("MyHeader: ") +
+                                              String(i))));
+    }
+  }
+  Array tasks = f_pagelet_server_tasks_start(requests);
+  VS(tasks.size(), TEST_SIZE);
+
+  Array ready = f_pagelet_server_tasks_wait(tasks, -1, false);
+  VERIFY(ready.size() >= 1);
+  VS(f_pagelet_server_task_status(tasks[ready[0]]), k_PAGELET_DONE);
+
+  ready = f_pagelet_server_tasks_wait(tasks, 10000, true);
+  VS(ready.size(), TEST_SIZE);
+  VS(ready[0], "t0");
+  VS(ready[TEST_SIZE - 1], String("t") + String(TEST_SIZE - 1));
+
+  for (int i = 0; i < TEST_SIZE; ++i)  {
+    String expected = "pagelet postparam: pagelet getparam: ";
+    expected += String(i);
+    expected += "pagelet header: ";
+    if (i % 2 == 0) expected += String(i);
+
+    Variant code, headers;
+    VS(expected, f_pagelet_server_task_result(tasks[String("t") + String(i)],
+                                              ref(headers), ref(code)));
+    VS(code, 200);
+  }
+
+  VS(f_pagelet_server_tasks_wait(Array::Create(), 0, false).size(), 0);
+
+  // tasks over the queue limit come back null, and waiting skips them
+  int queueLimit = RuntimeOption::PageletServerQueueLimit;
+  RuntimeOption::PageletServerQueueLimit = 1;
+  requests = Array::Create();
+  for (int i = 0; i < 5 * TEST_SIZE; ++i) {
+    requests.append(String("pageletserver?getparam=") + String(i));
+  }
+  tasks = f_pagelet_server_tasks_start(requests);
+  RuntimeOption::PageletServerQueueLimit = queueLimit;
+  tasks.set("never", null_object);
+  Array started = Array::Create();
+  for (ArrayIter iter(tasks); iter; ++iter) {
+    if (!iter.second().isNull()) started.append(iter.first());
+  }
+  VERIFY(started.size() < tasks.size());
+  VS(f_pagelet_server_tasks_wait(tasks, 10000, true), started);
+  VERIFY(f_pagelet_server_tasks_wait(tasks, -1, false).size() >= 1);
+  VS(f_pagelet_server_tasks_wait(CREATE_MAP1("never", null_object), -1,
+                                 false).size(), 0);
+  return Count(true);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool TestExtServer::test_xbox_send_message() {
@@ -32,6 +32,8 @@ class TestExtServer : public TestCppExt {
   bool test_pagelet_server_task_start();
   bool test_pagelet_server_task_status();
   bool test_pagelet_server_task_result();
+  bool test_pagelet_server_tasks_start();
+  bool test_pagelet_server_tasks_wait();
   bool test_xbox_send_message();
   bool test_xbox_post_message();
   bool test_xbox_task_start();
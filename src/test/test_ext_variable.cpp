@@ -17,6 +17,7 @@
 #include <test/test_ext_variable.h>
 #include <runtime/ext/ext_variable.h>
 #include <runtime/ext/ext_string.h>
+#include <runtime/base/runtime_option.h>
 #include <system/lib/systemlib.h>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -356,6 +357,25 @@ bool TestExtVariable::test_serialize() {
   Variant v = CREATE_MAP3("a","apple","b",2,"c",CREATE_VECTOR3(1,"y",3));
   VS(f_serialize(v),
      "a:3:{s:1:\"a\";s:5:\"apple\";s:1:\"b\";i:2;s:1:\"c\";a:3:{i:0;i:1;i:1;s:1:\"y\";i:2;i:3;}}");
+
+  {
+    // large arrays of scalars serialize in parallel with identical output
+    Array big;
+    for (int i = 0; i < 1000; i++) {
+      big.append(i);
+      big.set(String("k") + String(i), i * 0.5);
+      big.append(i % 3 ? Variant(String("v\\'") + String(i)) : Variant(i & 1));
+    }
+    String serialized = f_serialize(big);
+    String printed = f_print_r(big, true);
+    String exported = f_var_export(big, true);
+    int64 oldThreshold = RuntimeOption::ParallelSerializationThreshold;
+    RuntimeOption::ParallelSerializationThreshold = 100;
+    VS(f_serialize(big), serialized);
+    VS(f_print_r(big, true), printed);
+    VS(f_var_export(big, true), exported);
+    RuntimeOption::ParallelSerializationThreshold = oldThreshold;
+  }
   return Count(true);
 }
 
@@ -378,6 +398,16 @@ bool TestExtVariable::test_unserialize() {
     VS(obj->o_getClassName(), "stdClass");
     VS(obj.o_get("name"), "value");
   }
+  {
+    // second object reuses the class and property slot resolved by the first
+    Variant v = f_unserialize(String("a:2:{i:0;O:9:\"Exception\":1:{"
+                                     "s:10:\"\0*\0message\";s:1:\"a\";}"
+                                     "i:1;O:9:\"Exception\":1:{"
+                                     "s:10:\"\0*\0message\";s:1:\"b\";}}",
+                                     106, AttachLiteral));
+    VS(v[0].toObject()->o_invoke("getMessage", Array(), -1), "a");
+    VS(v[1].toObject()->o_invoke("getMessage", Array(), -1), "b");
+  }
   {
     Variant v1 = CREATE_MAP3("a","apple","b",2,"c",CREATE_VECTOR3(1,"y",3));
     Variant v2 = f_unserialize("a:3:{s:1:\"a\";s:5:\"apple\";s:1:\"b\";i:2;s:1:\"c\";a:3:{i:0;i:1;i:1;s:1:\"y\";i:2;i:3;}}");
@@ -16,6 +16,7 @@
 
 #include <test/test_performance.h>
 #include <util/util.h>
+#include <compiler/option.h>
 
 using namespace std;
 
@@ -48,6 +49,7 @@ TestPerformance::TestPerformance() {
 bool TestPerformance::RunTests(const std::string &which) {
   bool ret = true;
   RUN_TEST(TestBasicOperations);
+  RUN_TEST(TestEvalByteCode);
   RUN_TEST(TestMemoryUsage);
   RUN_TEST(TestAdHocFile);
   RUN_TEST(TestAdHoc);
@@ -139,6 +141,59 @@ bool TestPerformance::TestBasicOperations() {
   return true;
 }
 
+#define PERF_EVAL_FUNCS                                                 \
+  "function arith($n) {\n"                                              \
+  "  $j = 0;\n"                                                         \
+  "  for ($i = 0; $i < $n; $i++) { $j = $j + $i * 2 - 1; }\n"           \
+  "  return $j;\n"                                                      \
+  "}\n"                                                                 \
+  "function branches($n) {\n"                                           \
+  "  $odd = 0; $i = 0;\n"                                               \
+  "  while ($i < $n) {\n"                                               \
+  "    if ($i % 2 == 1 && $i != 7) { $odd = $odd + 1; }\n"              \
+  "    else if (!$i) { $i = 2; continue; }\n"                           \
+  "    $i = $i + 1;\n"                                                  \
+  "  }\n"                                                               \
+  "  return $odd;\n"                                                    \
+  "}\n"                                                                 \
+  "function strings($n) {\n"                                            \
+  "  $s = '';\n"                                                        \
+  "  for ($i = 0; $i < $n; $i++) { $s = $s . 'x'; }\n"                  \
+  "  return strlen($s);\n"                                              \
+  "}\n"                                                                 \
+
+bool TestPerformance::TestEvalByteCode() {
+  if (Option::EnableEval < Option::FullEval) return true;
+
+  // same programs on both eval engines
+  const char *engines[] = { "-v Eval.BytecodeInterpreter=false",
+                            "-v Eval.BytecodeInterpreter=true" };
+  for (unsigned int i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+    EvalOption = engines[i];
+    printf("%s\n", engines[i]);
+
+    VCR(PERF_START
+        PERF_EVAL_FUNCS
+        "for ($k = 0; $k < " PERF_LOOP_COUNT "; $k++) { arith(100); }"
+        "\n\n/* Function local integer arithmetic */"
+        PERF_END);
+
+    VCR(PERF_START
+        PERF_EVAL_FUNCS
+        "for ($k = 0; $k < " PERF_LOOP_COUNT "; $k++) { branches(100); }"
+        "\n\n/* Function local branches and loops */"
+        PERF_END);
+
+    VCR(PERF_START
+        PERF_EVAL_FUNCS
+        "for ($k = 0; $k < " PERF_LOOP_COUNT "; $k++) { strings(100); }"
+        "\n\n/* Function local string concatenation */"
+        PERF_END);
+  }
+  EvalOption = NULL;
+  return true;
+}
+
 bool TestPerformance::TestMemoryUsage() {
   VCR(PERF_START
       "$a = array();\n"
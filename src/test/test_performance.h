@@ -31,6 +31,7 @@ class TestPerformance : public TestCodeRun {
   virtual bool RunTests(const std::string &which);
 
   bool TestBasicOperations();
+  bool TestEvalByteCode();
   bool TestMemoryUsage();
   bool TestAdHocFile();
   bool TestAdHoc();
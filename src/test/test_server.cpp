@@ -28,6 +28,7 @@
 #include <runtime/base/server/http_request_handler.h>
 #include <runtime/base/util/http_client.h>
 #include <runtime/base/runtime_option.h>
+#include <util/compression.h>
 
 using namespace std;
 using namespace boost;
@@ -44,6 +45,7 @@ TestServer::TestServer() {
 
 static int s_server_port = 0;
 static int inherit_fd = -1;
+static string s_server_option; // one more -v for the server, if any
 
 bool TestServer::VerifyServerResponse(const char *input, const char *output,
                                       const char *url, const char *method,
@@ -89,8 +91,15 @@ bool TestServer::VerifyServerResponse(const char *input, const char *output,
       f_curl_setopt(c, k_CURLOPT_POSTFIELDS, postdata);
       f_curl_setopt(c, k_CURLOPT_POST, true);
     }
+    if (strcmp(method, "HEAD") == 0) {
+      f_curl_setopt(c, k_CURLOPT_NOBODY, true);
+    }
     if (header) {
       f_curl_setopt(c, k_CURLOPT_HTTPHEADER, CREATE_VECTOR1(header));
+      if (!responseHeader && strncasecmp(header, "Accept-Encoding:", 16) == 0) {
+        // have the body decoded, so it can be compared as is
+        f_curl_setopt(c, k_CURLOPT_ENCODING, "");
+      }
     }
     if (responseHeader) {
       f_curl_setopt(c, k_CURLOPT_HEADER, 1);
@@ -132,17 +141,22 @@ void TestServer::RunServer() {
   string out, err;
   string portConfig = "Server.Port=" + lexical_cast<string>(s_server_port);
   string fd = lexical_cast<string>(inherit_fd);
+  // setting the port again is harmless when there is nothing else to set
+  const char *option = s_server_option.empty() ?
+    portConfig.c_str() : s_server_option.c_str();
 
   if (Option::EnableEval < Option::FullEval) {
     const char *argv[] = {"", "--mode=server",
                           "--config=test/config-server.hdf", "-v",
-                          portConfig.c_str(), "--port-fd", fd.c_str(), NULL};
+                          portConfig.c_str(), "-v", option,
+                          "--port-fd", fd.c_str(), NULL};
     Process::Exec("runtime/tmp/TestServer/test", argv, NULL, out, &err);
   } else {
     const char *argv[] = {"", "--file=/unittest/rootdoc/string",
                           "--mode=server", portConfig.c_str(), "-v",
                           "--config=test/config-eval.hdf",
-                          portConfig.c_str(), "--port-fd", fd.c_str(), NULL};
+                          portConfig.c_str(), "-v", option,
+                          "--port-fd", fd.c_str(), NULL};
     Process::Exec(HPHPI_PATH, argv, NULL, out, &err);
   }
 }
@@ -180,6 +194,8 @@ bool TestServer::RunTests(const std::string &which) {
   RUN_TEST(TestCookie);
   RUN_TEST(TestResponseHeader);
   RUN_TEST(TestSetCookie);
+  RUN_TEST(TestResponseCompression);
+  RUN_TEST(TestStaticContent);
   //RUN_TEST(TestRequestHandling);
   RUN_TEST(TestHttpClient);
   RUN_TEST(TestRPCServer);
@@ -287,6 +303,25 @@ bool TestServer::TestPost() {
   VSPOST("<?php print $HTTP_RAW_POST_DATA;",
          "name=value", "string", params);
 
+  // over RequestBodyReadLimit, so php://input streams it off the connection
+  string body(10000, 'x');
+  VSRX("<?php\n"
+       "$f = fopen('php://input', 'r');\n"
+       "$n = 0;\n"
+       "while (!feof($f)) {\n"
+       "  $chunk = fread($f, 1000);\n"
+       "  if (trim($chunk, 'x') !== '') print 'bad chunk';\n"
+       "  $n += strlen($chunk);\n"
+       "}\n"
+       "fclose($f);\n"
+       "var_dump($n);\n"
+       "var_dump(@fopen('php://input', 'r'));\n"
+       "var_dump(@file_get_contents('php://input'));\n"
+       "var_dump(isset($HTTP_RAW_POST_DATA));\n",
+       "int(10000)\nbool(false)\nbool(false)\nbool(false)\n",
+       "string", "POST", "Content-Type: application/octet-stream",
+       body.c_str());
+
   return true;
 }
 
@@ -333,6 +368,91 @@ bool TestServer::TestSetCookie() {
   return true;
 }
 
+bool TestServer::TestResponseCompression() {
+  // config-server.hdf hands bodies of 4096 bytes or more to the compression
+  // threads and keeps compressed bodies in cache
+  const char *small = "<?php echo str_repeat('a', 2000);";
+  const char *large = "<?php echo str_repeat('b', 10000);";
+
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: gzip");
+  VSRESX(large, "Content-Encoding: gzip", "Accept-Encoding: gzip");
+  VSRX(small, string(2000, 'a').c_str(), "string", "GET",
+       "Accept-Encoding: gzip", NULL);
+  VSRX(large, string(10000, 'b').c_str(), "string", "GET",
+       "Accept-Encoding: gzip", NULL);
+
+  // too small to be worth compressing
+  VSRX("<?php echo 'tiny';", "tiny", "string", "GET",
+       "Accept-Encoding: gzip", NULL);
+
+  // Accept-Encoding negotiation
+  string plain = string("\r\n\r\n") + string(2000, 'a');
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: *");
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: x-gzip");
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: GZIP;q=0.5");
+  VSRESX(small, plain.c_str(), "Accept-Encoding: gzip;q=0");
+  VSRESX(small, plain.c_str(), "Accept-Encoding: identity");
+  VSRESX(small, plain.c_str(), "Accept-Encoding: gzip;q=0, *");
+
+  // brotli and zstd are turned on in config-server.hdf, but only picked
+  // when asked for by name
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: gzip, br;q=0");
+  VSRESX(small, "Content-Encoding: gzip", "Accept-Encoding: gzip, zstd;q=0");
+  if (is_encoding_supported(CODING_BROTLI)) {
+    VSRESX(small, "Content-Encoding: br", "Accept-Encoding: gzip, br");
+    VSRESX(large, "Content-Encoding: br", "Accept-Encoding: br");
+  }
+  if (is_encoding_supported(CODING_ZSTD)) {
+    VSRESX(small, "Content-Encoding: zstd", "Accept-Encoding: zstd, gzip");
+    VSRESX(large, "Content-Encoding: zstd", "Accept-Encoding: zstd");
+  }
+  return true;
+}
+
+static bool write_static_file(const char *name, const string &body) {
+  string fullPath = string("/unittest/rootdoc/") + name;
+  ofstream f(fullPath.c_str());
+  if (!f) {
+    printf("Unable to open %s for write.\n", fullPath.c_str());
+    return false;
+  }
+  f << body;
+  return true;
+}
+
+bool TestServer::TestStaticContent() {
+  // .txt files are loaded into the static content cache at startup, while
+  // others are read from disk on each request. Both are over the default
+  // StaticContentZeroCopyMinSize, so they are not copied into response
+  // buffers, but sendfile()d from disk or written from the cache.
+  string body;
+  for (int i = 0; body.size() < 100000; i++) {
+    body += lexical_cast<string>(i) + "\n";
+  }
+  string length = "Content-Length: " + lexical_cast<string>(body.size());
+  if (!write_static_file("test_static.txt", body) ||
+      !write_static_file("test_static.dat", body)) {
+    return false;
+  }
+
+  VSGET("<?php ", body.c_str(), "test_static.dat");
+  VSGET("<?php ", body.c_str(), "test_static.txt");
+  VSRESURL("<?php ", length.c_str(), "test_static.dat", "GET");
+  VSRESURL("<?php ", length.c_str(), "test_static.dat", "HEAD");
+  VSRESURL("<?php ", length.c_str(), "test_static.txt", "HEAD");
+
+  // without synchronous sends, both go through the output buffer instead
+  s_server_option = "Server.LibEventSyncSend=false";
+  VSGET("<?php ", body.c_str(), "test_static.dat");
+  VSGET("<?php ", body.c_str(), "test_static.txt");
+  VSRESURL("<?php ", length.c_str(), "test_static.dat", "HEAD");
+  s_server_option.clear();
+
+  unlink("/unittest/rootdoc/test_static.txt");
+  unlink("/unittest/rootdoc/test_static.dat");
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class TestTransport : public Transport {
@@ -44,6 +44,12 @@ public:
   bool TestResponseHeader();
   bool TestSetCookie();
 
+  // test response compression
+  bool TestResponseCompression();
+
+  // test sending static files from disk and from the static content cache
+  bool TestStaticContent();
+
   // test multithreaded request processing
   bool TestRequestHandling();
   bool TestLibeventServer();
@@ -89,6 +95,11 @@ protected:
                                   NULL, true, __FILE__,__LINE__)))      \
     return false;
 
+#define VSRESX(input, output, header)                                   \
+  if (!Count(VerifyServerResponse(input, output, "string", "GET",       \
+                                  header, NULL, true, __FILE__,__LINE__))) \
+    return false;
+
 #define VSGET(input, output, url)                                       \
   if (!Count(VerifyServerResponse(input, output, url, "GET", NULL,      \
                                   NULL, false, __FILE__,__LINE__)))     \
@@ -105,6 +116,11 @@ protected:
                                   postdata, false, __FILE__,__LINE__))) \
     return false;
 
+#define VSRESURL(input, output, url, method)                             \
+  if (!Count(VerifyServerResponse(input, output, url, method, NULL,     \
+                                  NULL, true, __FILE__,__LINE__)))      \
+    return false;
+
 #define VSRX(input, output, url, method, header, postdata)              \
   if (!Count(VerifyServerResponse(input, output, url, method, header,   \
                                   postdata, false, __FILE__,__LINE__))) \
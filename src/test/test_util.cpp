@@ -17,9 +17,19 @@
 #include <test/test_util.h>
 #include <util/logger.h>
 #include <util/lfu_table.h>
+#include <util/job_queue.h>
+#include <util/parser/scanner.h>
 #include <runtime/base/complex_types.h>
 #include <runtime/base/shared/shared_string.h>
 #include <runtime/base/zend/zend_string.h>
+#include <runtime/base/server/concurrency_limiter.h>
+#include <runtime/base/server/response_compressor.h>
+#include <runtime/base/server/libevent_connection_manager.h>
+#include <runtime/base/server/shared_worker_pool.h>
+#include <runtime/base/server/transport.h>
+#include <runtime/base/runtime_option.h>
+#include <runtime/eval/runtime/stat_cache.h>
+#include <util/compression.h>
 
 using namespace std;
 
@@ -44,6 +54,14 @@ bool TestUtil::RunTests(const std::string &which) {
   RUN_TEST(TestSharedString);
   RUN_TEST(TestCanonicalize);
   RUN_TEST(TestHDF);
+  RUN_TEST(TestJobQueue);
+  RUN_TEST(TestSharedWorkerPool);
+  RUN_TEST(TestScannerReplay);
+  RUN_TEST(TestConcurrencyLimiter);
+  RUN_TEST(TestResponseCompressor);
+  RUN_TEST(TestAcceptEncoding);
+  RUN_TEST(TestConnectionManager);
+  RUN_TEST(TestStatCache);
   return ret;
 }
 
@@ -268,3 +286,594 @@ bool TestUtil::TestHDF() {
   node = doc["Node"];
   return Count(true);
 }
+
+static int s_jobSum;
+
+class SumWorker : public JobQueueWorker<int> {
+public:
+  virtual void doJob(int job) {
+    atomic_add(s_jobSum, job);
+  }
+};
+
+bool TestUtil::TestJobQueue() {
+  for (int steal = 0; steal < 2; steal++) {
+    s_jobSum = 0;
+    JobQueueDispatcher<int, SumWorker> dispatcher(4, false, 0, false, NULL,
+                                                  false, steal);
+    dispatcher.start();
+    for (int i = 1; i <= 1000; i++) {
+      dispatcher.enqueue(i);
+    }
+    dispatcher.stop();
+    VERIFY(s_jobSum == 500500);
+    VERIFY(dispatcher.getQueuedJobs() == 0);
+
+    std::vector<int64> counts;
+    dispatcher.getWaitHistogram(counts);
+    VERIFY((int)counts.size() == JobQueueWaitHistogram::BucketCount);
+    int64 total = 0;
+    for (unsigned int i = 0; i < counts.size(); i++) {
+      total += counts[i];
+    }
+    VERIFY(total == 1000);
+  }
+  return Count(true);
+}
+
+/**
+ * Keeps a pool thread busy until its gate opens.
+ */
+class GateJob : public SharedWorkerJob {
+public:
+  GateJob(Synchronizable &gate, bool &open) : m_gate(gate), m_open(open) {}
+
+  virtual void run(int worker) {
+    Lock lock(&m_gate);
+    while (!m_open) m_gate.wait();
+  }
+
+private:
+  Synchronizable &m_gate;
+  bool &m_open;
+};
+
+class WorkerIdJob : public SharedWorkerJob {
+public:
+  WorkerIdJob(int &worker) : m_worker(worker) {}
+
+  virtual void run(int worker) { m_worker = worker; }
+
+private:
+  int &m_worker;
+};
+
+static void open_gate(Synchronizable &gate, bool &open) {
+  Lock lock(&gate);
+  open = true;
+  gate.notifyAll();
+}
+
+static void enqueue_gate_jobs(SharedWorkerPool::JobClass cls, int count,
+                              Synchronizable &gate, bool &open) {
+  for (int i = 0; i < count; i++) {
+    SharedWorkerPool::Enqueue(cls, new GateJob(gate, open));
+  }
+}
+
+class OpenGateJob : public SharedWorkerJob {
+public:
+  OpenGateJob(Synchronizable &gate, bool &open) : m_gate(gate), m_open(open) {}
+
+  virtual void run(int worker) { open_gate(m_gate, m_open); }
+
+private:
+  Synchronizable &m_gate;
+  bool &m_open;
+};
+
+/**
+ * A page that sends a pagelet and waits for it, like one blocked in
+ * pagelet_server_task_result(), then counts itself done.
+ */
+class WaitForPageletJob : public SharedWorkerJob {
+public:
+  WaitForPageletJob(Synchronizable &doneLock, int &done)
+    : m_doneLock(doneLock), m_done(done) {}
+
+  virtual void run(int worker) {
+    Synchronizable gate;
+    bool open = false;
+    SharedWorkerPool::Enqueue(SharedWorkerPool::PageletJob,
+                              new OpenGateJob(gate, open));
+    GateJob(gate, open).run(worker);
+
+    Lock lock(&m_doneLock);
+    m_done++;
+    m_doneLock.notifyAll();
+  }
+
+private:
+  Synchronizable &m_doneLock;
+  int &m_done;
+};
+
+// pool threads take jobs in their own time, so give them a moment
+static bool wait_for_active(SharedWorkerPool::JobClass cls, int active) {
+  for (int i = 0; i < 500; i++) {
+    if (SharedWorkerPool::GetActiveWorker(cls) == active) {
+      usleep(50000); // and make sure no more go in
+      return SharedWorkerPool::GetActiveWorker(cls) == active;
+    }
+    usleep(10000);
+  }
+  return false;
+}
+
+bool TestUtil::TestSharedWorkerPool() {
+  int threadCount = RuntimeOption::WorkerPoolThreadCount;
+  int pageWeight = RuntimeOption::WorkerPoolPageWeight;
+  int pageletMin = RuntimeOption::WorkerPoolPageletMinThreads;
+  int pageletWeight = RuntimeOption::WorkerPoolPageletWeight;
+  int pageletThreads = RuntimeOption::PageletServerThreadCount;
+  int xboxThreads = RuntimeOption::XboxServerThreadCount;
+  RuntimeOption::PageletServerThreadCount = 0;
+  RuntimeOption::XboxServerThreadCount = 0;
+  RuntimeOption::WorkerPoolThreadCount = 4;
+  RuntimeOption::WorkerPoolPageWeight = 3;
+  RuntimeOption::WorkerPoolPageletWeight = 1;
+  RuntimeOption::WorkerPoolPageletMinThreads = 1;
+  SharedWorkerPool::Restart();
+
+  const SharedWorkerPool::JobClass page = SharedWorkerPool::PageJob;
+  const SharedWorkerPool::JobClass pagelet = SharedWorkerPool::PageletJob;
+  const SharedWorkerPool::JobClass xbox = SharedWorkerPool::XboxJob;
+  {
+    // pages can't take the thread reserved for pagelets
+    Synchronizable gate;
+    bool open = false;
+    enqueue_gate_jobs(page, 6, gate, open);
+    VERIFY(wait_for_active(page, 3));
+    VERIFY(SharedWorkerPool::GetQueuedJobs(page) == 3);
+    enqueue_gate_jobs(pagelet, 1, gate, open);
+    VERIFY(wait_for_active(pagelet, 1));
+    VERIFY(SharedWorkerPool::GetActiveWorker(page) == 3);
+    open_gate(gate, open);
+    SharedWorkerPool::WaitIdle(page);
+    SharedWorkerPool::WaitIdle(pagelet);
+  }
+  {
+    // with the reservation met, freed threads go 3:1 by weight
+    Synchronizable xboxGate, gate;
+    bool xboxOpen = false, open = false;
+    enqueue_gate_jobs(xbox, 3, xboxGate, xboxOpen);
+    VERIFY(wait_for_active(xbox, 3));
+    enqueue_gate_jobs(page, 10, gate, open);
+    enqueue_gate_jobs(pagelet, 10, gate, open);
+    VERIFY(wait_for_active(pagelet, 1));
+    VERIFY(SharedWorkerPool::GetActiveWorker(page) == 0);
+    open_gate(xboxGate, xboxOpen);
+    VERIFY(wait_for_active(page, 3));
+    VERIFY(SharedWorkerPool::GetActiveWorker(pagelet) == 1);
+    VERIFY(SharedWorkerPool::GetActiveWorker(xbox) == 0);
+    open_gate(gate, open);
+    SharedWorkerPool::WaitIdle(page);
+    SharedWorkerPool::WaitIdle(pagelet);
+    SharedWorkerPool::WaitIdle(xbox);
+  }
+  {
+    std::vector<int> workers(4, -1);
+    std::vector<SharedWorkerJob*> jobs;
+    for (int i = 0; i < 4; i++) {
+      jobs.push_back(new WorkerIdJob(workers[i]));
+    }
+    SharedWorkerPool::RunOnEachThread(jobs);
+    for (int i = 0; i < 4; i++) {
+      VERIFY(workers[i] == i);
+    }
+  }
+  {
+    // with the pagelet server on, pagelets keep a thread even unasked, so
+    // pages waiting on them can't take every thread
+    RuntimeOption::PageletServerThreadCount = 1;
+    RuntimeOption::WorkerPoolPageletMinThreads = 0;
+    SharedWorkerPool::Restart();
+    Synchronizable doneLock;
+    int done = 0;
+    for (int i = 0; i < 8; i++) {
+      SharedWorkerPool::Enqueue(page, new WaitForPageletJob(doneLock, done));
+    }
+    Lock lock(&doneLock);
+    while (done < 8) {
+      if (!doneLock.wait(10)) break;
+    }
+    VERIFY(done == 8);
+  }
+
+  RuntimeOption::WorkerPoolThreadCount = threadCount;
+  RuntimeOption::WorkerPoolPageWeight = pageWeight;
+  RuntimeOption::WorkerPoolPageletWeight = pageletWeight;
+  RuntimeOption::WorkerPoolPageletMinThreads = pageletMin;
+  RuntimeOption::PageletServerThreadCount = pageletThreads;
+  RuntimeOption::XboxServerThreadCount = xboxThreads;
+  SharedWorkerPool::Restart();
+  return Count(true);
+}
+
+static void scan_tokens(Scanner &scanner, vector<string> &out) {
+  ScannerToken token;
+  Location loc;
+  int tokid;
+  do {
+    tokid = scanner.getNextToken(token, loc);
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%d %d:%d-%d:%d%s ", tokid, loc.line0,
+             loc.char0, loc.line1, loc.char1, scanner.hasGap() ? " gap" : "");
+    out.push_back(buf + token.text() + " " + scanner.detachDocComment());
+  } while (tokid);
+}
+
+bool TestUtil::TestScannerReplay() {
+  const char *src =
+    "<?php\n"
+    "/** doc */\n"
+    "function f($a) {\n"
+    "  return $a . \"x\\n\" . <<<EOT\n"
+    "here $a\n"
+    "EOT;\n"
+    "}\n";
+  int type = Scanner::AllowShortTags;
+
+  string tokens;
+  vector<string> scanned, replayed;
+  Scanner recorder(src, strlen(src), type);
+  recorder.record(&tokens);
+  scan_tokens(recorder, scanned);
+  VERIFY(scanned.size() > 10);
+
+  Scanner replayer(src, strlen(src), type);
+  replayer.replay(tokens.data(), tokens.size());
+  scan_tokens(replayer, replayed);
+  VERIFY(replayed == scanned);
+  return Count(true);
+}
+
+bool TestUtil::TestConcurrencyLimiter() {
+  {
+    // 10ms target, 100ms windows
+    ConcurrencyLimiter limiter(2, 100, 10, 100);
+    int64 now = ConcurrencyLimiter::Now();
+    VERIFY(limiter.getLimit() == 100);
+
+    // 40ms average queue time: shrinks by at most half per window
+    for (int i = 0; i < 10; i++) limiter.onDequeue(40000);
+    now += 100000;
+    VERIFY(limiter.admit(ConcurrencyLimiter::HighPriority, 1, now));
+    VERIFY(limiter.getLimit() == 50);
+
+    // 12.5ms average: shrinks by target/average
+    for (int i = 0; i < 4; i++) limiter.onDequeue(12500);
+    now += 100000;
+    limiter.admit(ConcurrencyLimiter::HighPriority, 1, now);
+    VERIFY(limiter.getLimit() == 40);
+
+    // target met but the limit was not being reached: stays
+    limiter.onDequeue(1000);
+    now += 100000;
+    limiter.admit(ConcurrencyLimiter::HighPriority, 1, now);
+    VERIFY(limiter.getLimit() == 40);
+
+    // target met while in-flight reached 80% of the limit: grows by sqrt
+    limiter.onDequeue(1000);
+    limiter.admit(ConcurrencyLimiter::HighPriority, 32, now + 50000);
+    now += 100000;
+    limiter.admit(ConcurrencyLimiter::HighPriority, 1, now);
+    VERIFY(limiter.getLimit() == 46);
+
+    // windows without any dequeued request leave the limit alone
+    now += 100000;
+    limiter.admit(ConcurrencyLimiter::HighPriority, 46, now);
+    VERIFY(limiter.getLimit() == 46);
+
+    // never below Min
+    for (int round = 0; round < 10; round++) {
+      limiter.onDequeue(1000000);
+      now += 100000;
+      limiter.admit(ConcurrencyLimiter::HighPriority, 1, now);
+    }
+    VERIFY(limiter.getLimit() == 2);
+  }
+  {
+    // lower priorities are shed first
+    ConcurrencyLimiter limiter(1, 100, 10, 100000);
+    int64 now = ConcurrencyLimiter::Now();
+    VERIFY(limiter.admit(ConcurrencyLimiter::LowPriority, 50, now));
+    VERIFY(!limiter.admit(ConcurrencyLimiter::LowPriority, 51, now));
+    VERIFY(limiter.admit(ConcurrencyLimiter::NormalPriority, 90, now));
+    VERIFY(!limiter.admit(ConcurrencyLimiter::NormalPriority, 91, now));
+    VERIFY(limiter.admit(ConcurrencyLimiter::HighPriority, 100, now));
+    VERIFY(!limiter.admit(ConcurrencyLimiter::HighPriority, 101, now));
+    VERIFY(limiter.getRejected() == 3);
+
+    VERIFY(ConcurrencyLimiter::ParsePriority("LOW") ==
+           ConcurrencyLimiter::LowPriority);
+    VERIFY(ConcurrencyLimiter::ParsePriority("high") ==
+           ConcurrencyLimiter::HighPriority);
+    VERIFY(ConcurrencyLimiter::ParsePriority("bogus") ==
+           ConcurrencyLimiter::NormalPriority);
+  }
+  {
+    // up to Min requests are always let in
+    ConcurrencyLimiter limiter(10, 10, 10, 100);
+    int64 now = ConcurrencyLimiter::Now();
+    VERIFY(limiter.admit(ConcurrencyLimiter::LowPriority, 10, now));
+    VERIFY(!limiter.admit(ConcurrencyLimiter::LowPriority, 11, now));
+  }
+  return Count(true);
+}
+
+// compresses a copy of "body" and returns the compressed bytes
+static string compress_response(const string &body, int encoding) {
+  int len = body.size();
+  char *compressed = ResponseCompressor::Compress(body.data(), len, encoding);
+  if (!compressed) return "";
+  string ret(compressed, len);
+  free(compressed);
+  return ret;
+}
+
+bool TestUtil::TestResponseCompressor() {
+  int level = RuntimeOption::GzipCompressionLevel;
+  int64 cacheSize = RuntimeOption::GzipCompressionCacheSize;
+  RuntimeOption::GzipCompressionLevel = 6;
+
+  // bodies that barely compress, so each one takes about 1KB of cache
+  vector<string> bodies;
+  srand(1234);
+  for (int i = 0; i < 5; i++) {
+    string body;
+    for (int j = 0; j < 1000; j++) body.push_back((char)(rand() & 0xff));
+    bodies.push_back(body);
+  }
+  RuntimeOption::GzipCompressionCacheSize = 4400;
+
+  // same body: miss, then hit with the same bytes
+  int64 hits = ResponseCompressor::GetCacheHits();
+  int64 misses = ResponseCompressor::GetCacheMisses();
+  string gzipped = compress_response(bodies[0], CODING_GZIP);
+  VERIFY(!gzipped.empty());
+  VERIFY(ResponseCompressor::GetCacheMisses() == misses + 1);
+  VERIFY(compress_response(bodies[0], CODING_GZIP) == gzipped);
+  VERIFY(ResponseCompressor::GetCacheHits() == hits + 1);
+
+  int len = gzipped.size();
+  char *decoded = gzdecode(gzipped.data(), len);
+  VERIFY(decoded && string(decoded, len) == bodies[0]);
+  free(decoded);
+
+  // same body, different encoding: cached separately
+  string deflated = compress_response(bodies[0], CODING_DEFLATE);
+  VERIFY(!deflated.empty() && deflated != gzipped);
+  VERIFY(ResponseCompressor::GetCacheMisses() == misses + 2);
+  VERIFY(compress_response(bodies[0], CODING_DEFLATE) == deflated);
+  VERIFY(compress_response(bodies[0], CODING_GZIP) == gzipped);
+  VERIFY(ResponseCompressor::GetCacheHits() == hits + 3);
+
+  // five 1KB entries don't fit in 4400 bytes: the least recently used of
+  // them goes
+  for (int i = 1; i < 5; i++) {
+    compress_response(bodies[i], CODING_GZIP);
+  }
+  hits = ResponseCompressor::GetCacheHits();
+  misses = ResponseCompressor::GetCacheMisses();
+  compress_response(bodies[4], CODING_GZIP);
+  compress_response(bodies[1], CODING_GZIP);
+  VERIFY(ResponseCompressor::GetCacheHits() == hits + 2);
+  VERIFY(compress_response(bodies[0], CODING_GZIP) == gzipped);
+  VERIFY(ResponseCompressor::GetCacheMisses() == misses + 1);
+
+  // bodies over a quarter of the cache are never kept
+  RuntimeOption::GzipCompressionCacheSize = 2000;
+  misses = ResponseCompressor::GetCacheMisses();
+  compress_response(bodies[2] + bodies[3], CODING_GZIP);
+  compress_response(bodies[2] + bodies[3], CODING_GZIP);
+  VERIFY(ResponseCompressor::GetCacheMisses() == misses + 2);
+
+  RuntimeOption::GzipCompressionLevel = level;
+  RuntimeOption::GzipCompressionCacheSize = cacheSize;
+  return Count(true);
+}
+
+bool TestUtil::TestAcceptEncoding() {
+  VERIFY(Transport::AcceptsCoding("gzip", "gzip", false));
+  VERIFY(Transport::AcceptsCoding("gzip, deflate", "deflate", false));
+  VERIFY(Transport::AcceptsCoding("deflate,gzip", "gzip", false));
+  VERIFY(Transport::AcceptsCoding("GZip", "gzip", false));
+  VERIFY(Transport::AcceptsCoding("gzip;level=1", "gzip", false));
+  VERIFY(!Transport::AcceptsCoding("", "gzip", true));
+  VERIFY(!Transport::AcceptsCoding("x-gzip", "gzip", false));
+  VERIFY(!Transport::AcceptsCoding("brotli", "br", false));
+
+  // q values
+  VERIFY(!Transport::AcceptsCoding("gzip;q=0", "gzip", false));
+  VERIFY(!Transport::AcceptsCoding("gzip; q=0.0, br", "gzip", false));
+  VERIFY(Transport::AcceptsCoding("gzip;q=0.5", "gzip", false));
+  VERIFY(!Transport::AcceptsCoding("br;q=0, gzip", "br", false));
+  VERIFY(Transport::AcceptsCoding("br;q=0, gzip", "gzip", false));
+  VERIFY(Transport::AcceptsCoding("gzip, br;q=0", "gzip", false));
+
+  // wildcard only covers codings that are not listed
+  VERIFY(Transport::AcceptsCoding("*", "gzip", true));
+  VERIFY(!Transport::AcceptsCoding("*", "gzip", false));
+  VERIFY(!Transport::AcceptsCoding("*;q=0", "gzip", true));
+  VERIFY(!Transport::AcceptsCoding("gzip;q=0, *", "gzip", true));
+  VERIFY(Transport::AcceptsCoding("identity, *", "br", true));
+
+  // identity never means any compression
+  VERIFY(!Transport::AcceptsCoding("identity", "gzip", true));
+  VERIFY(Transport::AcceptsCoding("identity, *;q=0", "identity", false));
+  return Count(true);
+}
+
+/**
+ * Lets connections pretend to still be writing out their last response.
+ */
+class TestConnections : public LibEventConnectionManager {
+public:
+  std::set<evhttp_connection*> slow;
+
+protected:
+  virtual int getPendingOutput(evhttp_connection *conn) {
+    return slow.find(conn) != slow.end() ? 1 : 0;
+  }
+};
+
+bool TestUtil::TestConnectionManager() {
+  int idleMax = RuntimeOption::KeepAliveIdleMax;
+  int idleTimeout = RuntimeOption::KeepAliveIdleTimeoutSeconds;
+  RuntimeOption::KeepAliveIdleMax = 2;
+  RuntimeOption::KeepAliveIdleTimeoutSeconds = 10;
+
+  event_base *base = event_base_new();
+  TestConnections connections;
+  connections.create(base, 1);
+
+  evhttp_connection *conns[4];
+  for (int i = 0; i < 4; i++) {
+    conns[i] = evhttp_connection_new("127.0.0.1", 80);
+    evhttp_connection_set_base(conns[i], base);
+    VERIFY(connections.onRequest(conns[i]) == 1);
+    connections.onResponseSent(conns[i]);
+  }
+  time_t now = time(NULL);
+  {
+    ServerConnectionStats stats;
+    connections.getStats(stats);
+    VERIFY(stats.open == 4 && stats.idle == 4);
+  }
+
+  // the oldest one is still sending, so the next two get evicted instead
+  connections.slow.insert(conns[0]);
+  connections.closeIdle(now + 1);
+  {
+    ServerConnectionStats stats;
+    connections.getStats(stats);
+    VERIFY(stats.open == 2 && stats.idle == 2);
+    VERIFY(stats.evicted == 2 && stats.timedOut == 0);
+  }
+
+  // and its idle clock only started once it was found done
+  connections.closeIdle(now + 10);
+  {
+    ServerConnectionStats stats;
+    connections.getStats(stats);
+    VERIFY(stats.open == 1 && stats.evicted == 2 && stats.timedOut == 1);
+  }
+  connections.closeIdle(now + 11);
+  {
+    ServerConnectionStats stats;
+    connections.getStats(stats);
+    VERIFY(stats.open == 1 && stats.timedOut == 1);
+  }
+  connections.slow.clear();
+  connections.closeIdle(now + 21);
+  {
+    ServerConnectionStats stats;
+    connections.getStats(stats);
+    VERIFY(stats.open == 0 && stats.closed == 4);
+    VERIFY(stats.evicted == 2 && stats.timedOut == 2);
+  }
+
+  connections.close();
+  event_base_free(base);
+  RuntimeOption::KeepAliveIdleMax = idleMax;
+  RuntimeOption::KeepAliveIdleTimeoutSeconds = idleTimeout;
+  return Count(true);
+}
+
+static void write_file(const string &path, const char *data) {
+  FILE *f = fopen(path.c_str(), "w");
+  if (f) {
+    fputs(data, f);
+    fclose(f);
+  }
+}
+
+// the watcher thread drops entries in its own time, so give it a moment;
+// "size" is -1 for a path that shouldn't exist
+static bool stat_cache_settles(const string &path, int size) {
+  for (int i = 0; i < 500; i++) {
+    struct stat s;
+    bool exists = Eval::StatCache::Stat(path, &s);
+    if (exists ? s.st_size == size : size < 0) return true;
+    usleep(10000);
+  }
+  return false;
+}
+
+bool TestUtil::TestStatCache() {
+  int revalidate = RuntimeOption::EvalStatCacheRevalidate;
+  RuntimeOption::EvalStatCacheRevalidate = 3600; // only events count here
+
+  char tmp[] = "/tmp/test_stat_cache.XXXXXX";
+  VERIFY(mkdtemp(tmp));
+  string base = tmp;
+  VERIFY(mkdir((base + "/dir").c_str(), 0777) == 0);
+  VERIFY(mkdir((base + "/r1").c_str(), 0777) == 0);
+  VERIFY(mkdir((base + "/r2").c_str(), 0777) == 0);
+  VERIFY(symlink("r1", (base + "/current").c_str()) == 0);
+  string a = base + "/dir/a.php";
+  string b = base + "/dir/b.php";
+  write_file(a, "1");
+  write_file(base + "/r1/x.php", "1");
+  write_file(base + "/r2/x.php", "22");
+
+  // hit, once cached: an event anywhere under /tmp while the first one
+  // stat()s keeps it from being cached, so give it a few tries
+  struct stat s;
+  for (int i = 0; i < 3; i++) {
+    VERIFY(Eval::StatCache::Stat(a, &s) && s.st_size == 1);
+    VERIFY(!Eval::StatCache::Stat(b, &s));
+  }
+  int64 misses = Eval::StatCache::GetMisses();
+  VERIFY(Eval::StatCache::Stat(a, &s) && s.st_size == 1);
+  VERIFY(!Eval::StatCache::Stat(b, &s));
+  VERIFY(Eval::StatCache::GetMisses() == misses);
+
+  // relative paths are just stat()ed
+  misses = Eval::StatCache::GetMisses();
+  char cwd[PATH_MAX];
+  VERIFY(getcwd(cwd, sizeof(cwd)));
+  VERIFY(chdir(base.c_str()) == 0);
+  VERIFY(Eval::StatCache::Stat("dir/a.php", &s) && s.st_size == 1);
+  VERIFY(Eval::StatCache::Stat("./dir/a.php", &s) && s.st_size == 1);
+  VERIFY(!Eval::StatCache::Stat("dir/none.php", &s));
+  VERIFY(chdir(cwd) == 0);
+  VERIFY(Eval::StatCache::GetMisses() == misses);
+
+  // modify, create and delete
+  write_file(a, "333");
+  VERIFY(stat_cache_settles(a, 3));
+  write_file(b, "22");
+  VERIFY(stat_cache_settles(b, 2));
+  VERIFY(unlink(b.c_str()) == 0);
+  VERIFY(stat_cache_settles(b, -1));
+
+  // rename of a directory above the file
+  VERIFY(rename((base + "/dir").c_str(), (base + "/moved").c_str()) == 0);
+  VERIFY(stat_cache_settles(a, -1));
+  VERIFY(stat_cache_settles(base + "/moved/a.php", 3));
+
+  // a symlinked directory swapped to another release
+  string x = base + "/current/x.php";
+  VERIFY(Eval::StatCache::Stat(x, &s) && s.st_size == 1);
+  VERIFY(symlink("r2", (base + "/next").c_str()) == 0);
+  VERIFY(rename((base + "/next").c_str(), (base + "/current").c_str()) == 0);
+  VERIFY(stat_cache_settles(x, 2));
+
+  Eval::StatCache::Stop();
+  string cmd = "rm -rf " + base;
+  VERIFY(system(cmd.c_str()) == 0);
+  RuntimeOption::EvalStatCacheRevalidate = revalidate;
+  return Count(true);
+}
@@ -32,6 +32,14 @@ class TestUtil : public TestBase {
   bool TestSharedString();
   bool TestCanonicalize();
   bool TestHDF();
+  bool TestJobQueue();
+  bool TestSharedWorkerPool();
+  bool TestScannerReplay();
+  bool TestConcurrencyLimiter();
+  bool TestResponseCompressor();
+  bool TestAcceptEncoding();
+  bool TestConnectionManager();
+  bool TestStatCache();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
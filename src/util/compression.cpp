@@ -19,6 +19,13 @@
 #include "logger.h"
 #include "exception.h"
 
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #define PHP_ZLIB_MODIFIER 1000
 #define GZIP_HEADER_LENGTH 10
 #define GZIP_FOOTER_LENGTH 8
@@ -164,9 +171,115 @@ bool is_compressible_file(const char *filename) {
 ///////////////////////////////////////////////////////////////////////////////
 // StreamCompressor
 
+bool is_encoding_supported(int encoding_mode) {
+  switch (encoding_mode) {
+  case CODING_GZIP:
+  case CODING_DEFLATE:
+    return true;
+#ifdef HAVE_BROTLI
+  case CODING_BROTLI:
+    return true;
+#endif
+#ifdef HAVE_ZSTD
+  case CODING_ZSTD:
+    return true;
+#endif
+  }
+  return false;
+}
+
+const char *get_encoding_name(int encoding_mode) {
+  switch (encoding_mode) {
+  case CODING_GZIP:    return "gzip";
+  case CODING_DEFLATE: return "deflate";
+  case CODING_BROTLI:  return "br";
+  case CODING_ZSTD:    return "zstd";
+  }
+  return NULL;
+}
+
+char *encode_with(const char *data, int &len, int level, int encoding_mode) {
+  if (encoding_mode == CODING_GZIP || encoding_mode == CODING_DEFLATE) {
+    return gzencode(data, len, level, encoding_mode);
+  }
+  try {
+    StreamCompressor compressor(level, encoding_mode, false);
+    return compressor.compress(data, len, true);
+  } catch (Exception &e) {
+    Logger::Warning("%s", e.getMessage().c_str());
+  }
+  return NULL;
+}
+
+/**
+ * Output buffer that brotli and zstd encoders keep appending to, since
+ * neither gives a useful upper bound for a flushed chunk up front.
+ */
+class GrowableOutput {
+public:
+  GrowableOutput(int len) : m_size(len + (len >> 3) + 64), m_used(0) {
+    m_data = (char *)malloc(m_size + 1);
+  }
+  ~GrowableOutput() { free(m_data); }
+
+  char *next() { return m_data + m_used; }
+  size_t avail() const { return m_size - m_used; }
+  void advance(size_t n) { m_used += n; }
+  void grow() {
+    m_size *= 2;
+    m_data = (char *)realloc(m_data, m_size + 1);
+  }
+  char *detach(int &len) {
+    char *ret = m_data;
+    ret[m_used] = '\0';
+    len = m_used;
+    m_data = NULL;
+    return ret;
+  }
+
+private:
+  char *m_data;
+  size_t m_size;
+  size_t m_used;
+};
+
 StreamCompressor::StreamCompressor(int level, int encoding_mode, bool header)
   : m_level(level), m_encoding(encoding_mode), m_header(header),
-    m_ended(false) {
+    m_ended(false), m_state(NULL) {
+  if (encoding_mode == CODING_BROTLI) {
+#ifdef HAVE_BROTLI
+    if (level < BROTLI_MIN_QUALITY || level > BROTLI_MAX_QUALITY) {
+      throw Exception("compression level(%d) must be within 0..11", level);
+    }
+    BrotliEncoderState *state = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    if (!state) {
+      throw Exception("cannot create brotli encoder");
+    }
+    BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, level);
+    m_state = state;
+    return;
+#else
+    throw Exception("brotli encoding is not supported by this build");
+#endif
+  }
+  if (encoding_mode == CODING_ZSTD) {
+#ifdef HAVE_ZSTD
+    if (level < 1 || level > ZSTD_maxCLevel()) {
+      throw Exception("compression level(%d) must be within 1..%d", level,
+                      ZSTD_maxCLevel());
+    }
+    ZSTD_CStream *state = ZSTD_createCStream();
+    if (!state) {
+      throw Exception("cannot create zstd encoder");
+    }
+    ZSTD_CCtx_setParameter(state, ZSTD_c_compressionLevel, level);
+    m_state = state;
+    return;
+#else
+    throw Exception("zstd encoding is not supported by this build");
+#endif
+  }
+
   if (level < -1 || level > 9) {
     throw Exception("compression level(%ld) must be within -1..9", level);
   }
@@ -203,8 +316,22 @@ StreamCompressor::StreamCompressor(int level, int encoding_mode, bool header)
 }
 
 StreamCompressor::~StreamCompressor() {
-  if (!m_ended) {
-    deflateEnd(&m_stream);
+  switch (m_encoding) {
+  case CODING_BROTLI:
+#ifdef HAVE_BROTLI
+    BrotliEncoderDestroyInstance((BrotliEncoderState *)m_state);
+#endif
+    break;
+  case CODING_ZSTD:
+#ifdef HAVE_ZSTD
+    ZSTD_freeCStream((ZSTD_CStream *)m_state);
+#endif
+    break;
+  default:
+    if (!m_ended) {
+      deflateEnd(&m_stream);
+    }
+    break;
   }
 }
 
@@ -212,6 +339,79 @@ char *StreamCompressor::compress(const char *data, int &len, bool trailer) {
   // middle chunks should never be zero size
   ASSERT(len || trailer);
 
+  switch (m_encoding) {
+  case CODING_BROTLI: return compressBrotli(data, len, trailer);
+  case CODING_ZSTD:   return compressZstd(data, len, trailer);
+  }
+  return compressZlib(data, len, trailer);
+}
+
+char *StreamCompressor::compressBrotli(const char *data, int &len,
+                                       bool trailer) {
+#ifdef HAVE_BROTLI
+  BrotliEncoderState *state = (BrotliEncoderState *)m_state;
+  if (m_ended) {
+    Logger::Error("brotli stream already finished");
+    return NULL;
+  }
+  BrotliEncoderOperation op =
+    trailer ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+  const uint8_t *next_in = (const uint8_t *)data;
+  size_t avail_in = len;
+  GrowableOutput out(len);
+  while (true) {
+    uint8_t *next_out = (uint8_t *)out.next();
+    size_t avail_out = out.avail();
+    if (!BrotliEncoderCompressStream(state, op, &avail_in, &next_in,
+                                     &avail_out, &next_out, NULL)) {
+      Logger::Error("brotli compression failed");
+      return NULL;
+    }
+    out.advance(out.avail() - avail_out);
+    if (avail_in == 0 && !BrotliEncoderHasMoreOutput(state) &&
+        (!trailer || BrotliEncoderIsFinished(state))) {
+      break;
+    }
+    if (out.avail() == 0) out.grow();
+  }
+  if (trailer) m_ended = true;
+  return out.detach(len);
+#else
+  return NULL;
+#endif
+}
+
+char *StreamCompressor::compressZstd(const char *data, int &len,
+                                     bool trailer) {
+#ifdef HAVE_ZSTD
+  ZSTD_CStream *state = (ZSTD_CStream *)m_state;
+  if (m_ended) {
+    Logger::Error("zstd stream already finished");
+    return NULL;
+  }
+  ZSTD_EndDirective mode = trailer ? ZSTD_e_end : ZSTD_e_flush;
+  ZSTD_inBuffer in = { data, (size_t)len, 0 };
+  GrowableOutput out(len);
+  while (true) {
+    ZSTD_outBuffer buf = { out.next(), out.avail(), 0 };
+    size_t remaining = ZSTD_compressStream2(state, &buf, &in, mode);
+    if (ZSTD_isError(remaining)) {
+      Logger::Error("%s", ZSTD_getErrorName(remaining));
+      return NULL;
+    }
+    out.advance(buf.pos);
+    if (remaining == 0) break;
+    if (out.avail() == 0) out.grow();
+  }
+  if (trailer) m_ended = true;
+  return out.detach(len);
+#else
+  return NULL;
+#endif
+}
+
+char *StreamCompressor::compressZlib(const char *data, int &len,
+                                     bool trailer) {
   m_stream.next_in = (Bytef *)data;
   m_stream.avail_in = len;
   m_stream.total_out = 0;
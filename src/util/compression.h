@@ -23,6 +23,8 @@
 // encoding_mode
 #define CODING_GZIP     1
 #define CODING_DEFLATE  2
+#define CODING_BROTLI   3 // only with HAVE_BROTLI
+#define CODING_ZSTD     4 // only with HAVE_ZSTD
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,8 +39,26 @@ char *gzuncompress(const char *data, int &len, int limit = 0);
 char *gzdeflate(const char *data, int &len, int level = -1);
 char *gzinflate(const char *data, int &len, int limit = 0);
 
+/**
+ * Whether this build can produce an encoding_mode, and its name as used in
+ * Accept-Encoding and Content-Encoding headers.
+ */
+bool is_encoding_supported(int encoding_mode);
+const char *get_encoding_name(int encoding_mode);
+
+/**
+ * One-shot compression with any supported encoding_mode; gzip and deflate
+ * go through gzencode(), the others through a StreamCompressor.
+ */
+char *encode_with(const char *data, int &len, int level, int encoding_mode);
+
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Compresses a response in chunks, each of which can be decoded by the client
+ * as soon as it arrives. Levels are -1..9 for gzip and deflate, 0..11 for
+ * brotli and 1..22 for zstd; header only applies to gzip.
+ */
 class StreamCompressor {
 public:
   StreamCompressor(int level, int encoding_mode, bool header);
@@ -56,6 +76,11 @@ private:
   z_stream m_stream;
   uLong m_crc;
   bool m_ended;
+  void *m_state; // brotli or zstd encoder
+
+  char *compressZlib(const char *data, int &len, bool trailer);
+  char *compressBrotli(const char *data, int &len, bool trailer);
+  char *compressZstd(const char *data, int &len, bool trailer);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
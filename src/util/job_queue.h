@@ -25,6 +25,7 @@
 #include "atomic.h"
 #include "alloc.h"
 #include "exception.h"
+#include "compatibility.h"
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
@@ -63,7 +64,50 @@ namespace HPHP {
  * store prepared jobs. With JobQueueDispatcher, job queue is normally empty
  * initially and new jobs are pushed into the queue over time. Also, workers
  * can be stopped individually.
+ *
+ * By default all workers share one locked queue. With "steal" turned on, every
+ * worker has its own queue instead, new jobs are spread over them round robin,
+ * and a worker whose queue is empty takes jobs from the others. The shared
+ * lock is then only taken when a worker goes to sleep or has to be woken up.
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Counts how long jobs stayed in a JobQueue before a worker picked them up.
+ * Bucket 0 counts waits under 1us, bucket i waits in [2^(i-1), 2^i) us and
+ * the last bucket everything longer.
  */
+class JobQueueWaitHistogram {
+public:
+  static const int BucketCount = 24;
+
+  JobQueueWaitHistogram() {
+    memset(m_counts, 0, sizeof(m_counts));
+  }
+
+  static int64 Now() {
+    timespec ts;
+    gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+  }
+
+  void record(int64 start) {
+    int64 us = Now() - start;
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && us >= (1LL << bucket)) {
+      bucket++;
+    }
+    atomic_add(m_counts[bucket], (int64)1);
+  }
+
+  void get(std::vector<int64> &counts) const {
+    counts.assign(m_counts, m_counts + BucketCount);
+  }
+
+private:
+  int64 m_counts[BucketCount];
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -81,19 +125,47 @@ public:
    * Constructor.
    */
   JobQueue(int threadCount, bool threadRoundRobin, int dropCacheTimeout,
-           bool dropStack, bool lifo)
+           bool dropStack, bool lifo, bool steal = false)
       : SynchronizableMulti(threadRoundRobin ? 1 : threadCount),
         m_jobCount(0), m_stopped(false), m_workerCount(0),
         m_dropCacheTimeout(dropCacheTimeout), m_dropStack(dropStack),
-        m_lifo(lifo) {
+        m_lifo(lifo), m_idleCount(0), m_nextShard(0) {
+    if (steal) {
+      for (int i = 0; i < threadCount; i++) {
+        m_shards.push_back(new Shard());
+      }
+    }
+  }
+
+  ~JobQueue() {
+    for (unsigned int i = 0; i < m_shards.size(); i++) {
+      delete m_shards[i];
+    }
   }
 
   /**
    * Put a job into the queue and notify a worker to pick it up.
    */
   void enqueue(TJob job) {
+    QueuedJob queued(job, JobQueueWaitHistogram::Now());
+    if (!m_shards.empty()) {
+      unsigned int next = atomic_inc(m_nextShard);
+      Shard &shard = *m_shards[next % m_shards.size()];
+      {
+        Lock lock(shard.mutex);
+        shard.jobs.push_back(queued);
+      }
+      atomic_inc(m_jobCount);
+      // pairs with the idle check in dequeueStealing(): either that worker
+      // sees this job, or we see it sleeping and wake someone up
+      if (m_idleCount > 0) {
+        Lock lock(this);
+        notify();
+      }
+      return;
+    }
     Lock lock(this);
-    m_jobs.push_back(job);
+    m_jobs.push_back(queued);
     m_jobCount = m_jobs.size();
     notify();
   }
@@ -104,6 +176,9 @@ public:
    * the job object correctly.
    */
   TJob dequeue(int id, bool inc = false) {
+    if (!m_shards.empty()) {
+      return dequeueStealing(id, inc);
+    }
     Lock lock(this);
     bool flushed = false;
     while (m_jobs.empty()) {
@@ -125,14 +200,9 @@ public:
     }
     if (inc) incActiveWorker();
     m_jobCount = m_jobs.size() - 1;
-    if (m_lifo) {
-      TJob job = m_jobs.back();
-      m_jobs.pop_back();
-      return job;
-    }
-    TJob job = m_jobs.front();
-    m_jobs.pop_front();
-    return job;
+    QueuedJob queued = popJob(m_jobs);
+    m_waits.record(queued.second);
+    return queued.first;
   }
 
   /**
@@ -164,26 +234,99 @@ public:
    * Keep track of how many jobs are queued, but not yet been serviced.
    */
   int getQueuedJobs() {
-    return m_jobCount;
+    return m_jobCount > 0 ? m_jobCount : 0;
+  }
+
+  const JobQueueWaitHistogram &getWaitHistogram() const {
+    return m_waits;
   }
 
  private:
+  typedef std::pair<TJob, int64> QueuedJob; // job and its enqueue time
+  class Shard {
+  public:
+    Mutex mutex;
+    std::deque<QueuedJob> jobs;
+  };
+
   int m_jobCount;
-  std::deque<TJob> m_jobs;
+  std::deque<QueuedJob> m_jobs;
   bool m_stopped;
   int m_workerCount;
   int m_dropCacheTimeout;
   bool m_dropStack;
   bool m_lifo;
+
+  // only used when stealing
+  std::vector<Shard*> m_shards;
+  int m_idleCount;
+  int m_nextShard;
+
+  JobQueueWaitHistogram m_waits;
+
+  QueuedJob popJob(std::deque<QueuedJob> &jobs) {
+    if (m_lifo) {
+      QueuedJob queued = jobs.back();
+      jobs.pop_back();
+      return queued;
+    }
+    QueuedJob queued = jobs.front();
+    jobs.pop_front();
+    return queued;
+  }
+
+  /**
+   * Tries the worker's own queue first, then the others in turn. Only when
+   * all of them are empty does the worker take the lock and go to sleep.
+   */
+  TJob dequeueStealing(int id, bool inc) {
+    int count = m_shards.size();
+    bool flushed = false;
+    while (true) {
+      if (m_jobCount > 0) {
+        for (int i = 0; i < count; i++) {
+          Shard &shard = *m_shards[(id + i) % count];
+          Lock lock(shard.mutex);
+          if (shard.jobs.empty()) continue;
+          QueuedJob queued = popJob(shard.jobs);
+          if (inc) incActiveWorker();
+          atomic_dec(m_jobCount);
+          m_waits.record(queued.second);
+          return queued.first;
+        }
+      }
+
+      Lock lock(this);
+      atomic_inc(m_idleCount);
+      if (m_jobCount <= 0) {
+        if (m_stopped) {
+          atomic_dec(m_idleCount);
+          throw StopSignal();
+        }
+        if (m_dropCacheTimeout <= 0 || flushed) {
+          wait(id, false);
+        } else if (!wait(id, true, m_dropCacheTimeout)) {
+          if (m_jobCount <= 0) {
+            Util::flush_thread_caches();
+            if (m_dropStack && Util::s_stackLimit) {
+              Util::flush_thread_stack();
+            }
+            flushed = true;
+          }
+        }
+      }
+      atomic_dec(m_idleCount);
+    }
+  }
 };
 
 template<typename TJob>
 class JobQueue<TJob,true> : public JobQueue<TJob,false> {
 public:
   JobQueue(int threadCount, bool threadRoundRobin, int dropCacheTimeout,
-           bool dropStack, bool lifo) :
+           bool dropStack, bool lifo, bool steal = false) :
     JobQueue<TJob,false>(threadCount, threadRoundRobin, dropCacheTimeout,
-                         dropStack, lifo) {
+                         dropStack, lifo, steal) {
     pthread_cond_init(&m_cond, NULL);
   }
   ~JobQueue() {
@@ -299,10 +442,10 @@ public:
    */
   JobQueueDispatcher(int threadCount, bool threadRoundRobin,
                      int dropCacheTimeout, bool dropStack, void *opaque,
-                     bool lifo = false)
+                     bool lifo = false, bool steal = false)
       : m_stopped(true), m_id(0), m_opaque(opaque),
         m_queue(threadCount, threadRoundRobin, dropCacheTimeout, dropStack,
-                lifo) {
+                lifo, steal) {
     ASSERT(threadCount >= 1);
     for (int i = 0; i < threadCount; i++) {
       addWorkerImpl(false);
@@ -330,6 +473,13 @@ public:
     return m_queue.getQueuedJobs();
   }
 
+  /**
+   * Counts of queue waiting time, see JobQueueWaitHistogram.
+   */
+  void getWaitHistogram(std::vector<int64> &counts) {
+    m_queue.getWaitHistogram().get(counts);
+  }
+
   /**
    * Creates worker threads and start running them. This is non-blocking.
    */
@@ -87,7 +87,8 @@ Scanner::Scanner(const char *filename, int type)
     : m_filename(filename), m_source(NULL), m_len(0), m_pos(0),
       m_state(Start), m_type(type), m_yyscanner(NULL), m_token(NULL),
       m_loc(NULL), m_lastToken(-1), m_gap(false), m_inScript(false),
-      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1) {
+      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1),
+      m_recording(NULL), m_replay(NULL), m_replayEnd(NULL) {
   m_stream = new ifstream(filename);
   m_streamOwner = true;
   if (m_stream->bad()) {
@@ -109,7 +110,8 @@ Scanner::Scanner(istream &stream, int type, const char *fileName /* = "" */)
     : m_filename(fileName), m_source(NULL), m_len(0), m_pos(0),
       m_state(Start), m_type(type), m_yyscanner(NULL), m_token(NULL),
       m_loc(NULL), m_lastToken(-1), m_gap(false), m_inScript(false),
-      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1) {
+      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1),
+      m_recording(NULL), m_replay(NULL), m_replayEnd(NULL) {
   m_stream = &stream;
   m_streamOwner = false;
   if (type & PreprocessXHP) {
@@ -126,7 +128,8 @@ Scanner::Scanner(const char *source, int len, int type,
     : m_filename(fileName), m_source(source), m_len(len), m_pos(0),
       m_state(Start), m_type(type), m_yyscanner(NULL), m_token(NULL),
       m_loc(NULL), m_lastToken(-1), m_gap(false), m_inScript(false),
-      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1) {
+      m_xhpState(0), m_lookahead(false), m_lookaheadTokid(-1),
+      m_recording(NULL), m_replay(NULL), m_replayEnd(NULL) {
   ASSERT(m_source);
   m_stream = NULL;
   m_streamOwner = false;
@@ -176,6 +179,12 @@ int Scanner::getNextToken(ScannerToken &t, Location &l) {
   }
   m_token = &t;
   m_loc = &l;
+  if (m_replay) {
+    m_lastToken = replayToken();
+    return m_lastToken;
+  }
+  string docComment;
+  if (m_recording) docComment = m_docComment;
   int tokid;
   bool done = false;
   m_gap = false;
@@ -195,9 +204,98 @@ int Scanner::getNextToken(ScannerToken &t, Location &l) {
   } while (!done && (m_type & ReturnAllTokens) == 0);
 
   m_lastToken = tokid;
+  if (m_recording) recordToken(tokid, docComment != m_docComment);
   return tokid;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// token streams
+
+static void write_varint(string &out, unsigned int v) {
+  while (v >= 0x80) {
+    out += (char)(v | 0x80);
+    v >>= 7;
+  }
+  out += (char)v;
+}
+
+static void write_delta(string &out, int v, int prev) {
+  int d = v - prev;
+  write_varint(out, (unsigned int)((d << 1) ^ (d >> 31)));
+}
+
+static bool read_varint(const char *&p, const char *end, unsigned int &v) {
+  v = 0;
+  for (int shift = 0; p < end && shift < 35; shift += 7) {
+    unsigned char c = *p++;
+    v |= (unsigned int)(c & 0x7f) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+static bool read_delta(const char *&p, const char *end, int &v, int prev) {
+  unsigned int z;
+  if (!read_varint(p, end, z)) return false;
+  v = prev + (int)((z >> 1) ^ -(int)(z & 1));
+  return true;
+}
+
+static bool read_string(const char *&p, const char *end, string &s) {
+  unsigned int len;
+  if (!read_varint(p, end, len) || len > (unsigned int)(end - p)) {
+    return false;
+  }
+  s.assign(p, len);
+  p += len;
+  return true;
+}
+
+void Scanner::recordToken(int tokid, bool docComment) {
+  string &out = *m_recording;
+  write_varint(out, tokid);
+  write_varint(out, (m_gap ? 1 : 0) | (docComment ? 2 : 0));
+  const string &text = m_token->text();
+  write_varint(out, text.size());
+  out.append(text);
+  write_delta(out, m_loc->line0, m_streamLoc.line0);
+  write_delta(out, m_loc->char0, m_streamLoc.char0);
+  write_delta(out, m_loc->line1, m_streamLoc.line1);
+  write_delta(out, m_loc->char1, m_streamLoc.char1);
+  if (docComment) {
+    write_varint(out, m_docComment.size());
+    out.append(m_docComment);
+  }
+  m_streamLoc = *m_loc;
+}
+
+int Scanner::replayToken() {
+  const char *&p = m_replay;
+  unsigned int tokid, flags;
+  string text;
+  Location loc;
+  if (p < m_replayEnd &&
+      read_varint(p, m_replayEnd, tokid) &&
+      read_varint(p, m_replayEnd, flags) &&
+      read_string(p, m_replayEnd, text) &&
+      read_delta(p, m_replayEnd, loc.line0, m_streamLoc.line0) &&
+      read_delta(p, m_replayEnd, loc.char0, m_streamLoc.char0) &&
+      read_delta(p, m_replayEnd, loc.line1, m_streamLoc.line1) &&
+      read_delta(p, m_replayEnd, loc.char1, m_streamLoc.char1) &&
+      (!(flags & 2) || read_string(p, m_replayEnd, m_docComment))) {
+    m_token->setText(text);
+    m_loc->first(loc);
+    m_loc->last(loc);
+    m_streamLoc = loc;
+    m_gap = flags & 1;
+    return tokid;
+  }
+  // streams are checked before they are replayed, so this is a bad stream
+  error("Truncated token stream");
+  m_replay = m_replayEnd;
+  return 0;
+}
+
 int Scanner::read(char *text, int &result, int max) {
   if (m_stream) {
     if (!m_stream->eof()) {
@@ -131,6 +131,18 @@ public:
   int getXhpState() const { return m_xhpState;}
   bool isXhpState() const { return m_xhpState != 0;}
 
+  /**
+   * Token stream recording and replaying. A recorded stream has every token
+   * getNextToken() returned with its text, location, gap flag and the doc
+   * comment scanned before it, so replaying it to the same parser builds the
+   * same tree without running the lexer.
+   */
+  void record(std::string *tokens) { m_recording = tokens;}
+  void replay(const char *tokens, int len) {
+    m_replay = tokens;
+    m_replayEnd = tokens + len;
+  }
+
   bool hasGap() const { return m_gap;}
   bool inScript() const { return m_inScript;}
   void setInScript(bool inScript) { m_inScript = inScript;}
@@ -233,7 +245,16 @@ private:
   ScannerToken m_lookaheadToken;
   Location m_lookaheadTokenLoc;
   int m_lookaheadTokid;
+
+  // token stream recording and replaying
+  std::string *m_recording;
+  const char *m_replay;
+  const char *m_replayEnd;
+  Location m_streamLoc; // previous token's location, locations are deltas
+
   void incLoc(const char *rawText, int rawLeng);
+  void recordToken(int tokid, bool docComment);
+  int replayToken();
 };
 
 ///////////////////////////////////////////////////////////////////////////////